@@ -15,6 +15,7 @@
 #ifndef FOXXLL_COMMON_SHARED_STATE_HEADER
 #define FOXXLL_COMMON_SHARED_STATE_HEADER
 
+#include <atomic>
 #include <condition_variable>
 #include <mutex>
 
@@ -31,8 +32,9 @@ class shared_state
     //! condition variable
     std::condition_variable cv_;
 
-    //! current shared_state
-    value_type state_;
+    //! current shared_state, changed under the mutex, but read without it
+    //! by operator ()
+    std::atomic<value_type> state_;
 
 public:
     explicit shared_state(const value_type& s)
@@ -58,10 +60,10 @@ public:
             cv_.wait(lock);
     }
 
-    value_type operator () ()
+    //! returns the current state without locking, e.g. to spin on it
+    value_type operator () () const
     {
-        std::unique_lock<std::mutex> lock(mutex_);
-        return state_;
+        return state_.load(std::memory_order_acquire);
     }
 };
 
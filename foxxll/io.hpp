@@ -15,6 +15,8 @@
 #define FOXXLL_IO_HEADER
 
 #include <foxxll/common/aligned_alloc.hpp>
+#include <foxxll/io/compacting_file.hpp>
+#include <foxxll/io/copy_request.hpp>
 #include <foxxll/io/create_file.hpp>
 #include <foxxll/io/disk_queues.hpp>
 #include <foxxll/io/file.hpp>
@@ -26,6 +28,7 @@
 #include <foxxll/io/request.hpp>
 #include <foxxll/io/request_operations.hpp>
 #include <foxxll/io/syscall_file.hpp>
+#include <foxxll/io/tiered_file.hpp>
 #include <foxxll/io/wincall_file.hpp>
 
 //! \c FOXXLL library namespace
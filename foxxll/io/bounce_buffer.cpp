@@ -0,0 +1,125 @@
+/***************************************************************************
+ *  foxxll/io/bounce_buffer.cpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <foxxll/common/aligned_alloc.hpp>
+#include <foxxll/io/bounce_buffer.hpp>
+#include <foxxll/io/request.hpp>
+#include <foxxll/singleton.hpp>
+
+namespace foxxll {
+
+constexpr size_t bounce_buffer::max_idle_buffers;
+
+//! idle buffers of all bounce_buffer objects. It is never destroyed, as I/O
+//! threads may still use it while static objects are destroyed at exit.
+class bounce_buffer_pool : public singleton<bounce_buffer_pool, false>
+{
+    friend class singleton<bounce_buffer_pool, false>;
+
+public:
+    struct buffer
+    {
+        size_t size;
+        char* raw;
+        char* data;
+    };
+
+private:
+    std::mutex mutex_;
+    //! idle buffers
+    std::vector<buffer> buffers_;
+
+    bounce_buffer_pool() = default;
+
+public:
+    //! returns the smallest idle buffer of at least bytes, which is aligned to
+    //! alignment, or a new one
+    buffer get(size_t bytes, size_t alignment)
+    {
+        alignment = std::max(alignment, BlockAlignment);
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            size_t best = buffers_.size();
+            for (size_t i = 0; i < buffers_.size(); ++i)
+            {
+                const bool aligned =
+                    reinterpret_cast<uintptr_t>(buffers_[i].data) %
+                    alignment == 0;
+                if (buffers_[i].size >= bytes && aligned &&
+                    (best == buffers_.size() ||
+                     buffers_[i].size < buffers_[best].size))
+                    best = i;
+            }
+            if (best != buffers_.size()) {
+                buffer b = buffers_[best];
+                buffers_.erase(buffers_.begin() + best);
+                return b;
+            }
+        }
+
+        // alignments are powers of two, larger ones than BlockAlignment are
+        // reached by rounding up inside a larger allocation
+        buffer b;
+        b.size = bytes;
+        b.raw = static_cast<char*>(
+            aligned_alloc<BlockAlignment>(bytes + alignment - BlockAlignment));
+        const size_t misalignment =
+            reinterpret_cast<uintptr_t>(b.raw) % alignment;
+        b.data = b.raw + (alignment - misalignment) % alignment;
+        return b;
+    }
+
+    //! returns a buffer to the pool, frees the smallest one if it is full
+    void put(const buffer& b)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        buffers_.push_back(b);
+        if (buffers_.size() <= bounce_buffer::max_idle_buffers)
+            return;
+
+        size_t smallest = 0;
+        for (size_t i = 1; i < buffers_.size(); ++i)
+        {
+            if (buffers_[i].size < buffers_[smallest].size)
+                smallest = i;
+        }
+        char* ptr = buffers_[smallest].raw;
+        buffers_.erase(buffers_.begin() + smallest);
+        lock.unlock();
+
+        aligned_dealloc<BlockAlignment>(ptr);
+    }
+};
+
+bounce_buffer::bounce_buffer(size_t bytes, size_t alignment)
+{
+    bounce_buffer_pool::buffer b =
+        bounce_buffer_pool::get_instance()->get(bytes, alignment);
+    size_ = b.size;
+    raw_ = b.raw;
+    data_ = b.data;
+}
+
+bounce_buffer::~bounce_buffer()
+{
+    bounce_buffer_pool::get_instance()->put(
+        bounce_buffer_pool::buffer { size_, raw_, data_ });
+}
+
+} // namespace foxxll
+
+/**************************************************************************/
@@ -0,0 +1,64 @@
+/***************************************************************************
+ *  foxxll/io/bounce_buffer.hpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef FOXXLL_IO_BOUNCE_BUFFER_HEADER
+#define FOXXLL_IO_BOUNCE_BUFFER_HEADER
+
+#include <cstddef>
+
+namespace foxxll {
+
+//! \addtogroup foxxll_fileimpl
+//! \{
+
+/*!
+ * Aligned buffer borrowed from a process-wide pool for the lifetime of the
+ * object, used by file::copy() and for unaligned direct I/O. The pool keeps a
+ * few idle buffers, since these usually move data of the same few sizes.
+ */
+class bounce_buffer
+{
+public:
+    //! maximum number of idle buffers kept in the pool
+    static constexpr size_t max_idle_buffers = 8;
+
+    //! Borrows the smallest idle buffer of at least bytes, or allocates one,
+    //! aligned to BlockAlignment and to alignment, e.g. the
+    //! file::memory_alignment() of the files it is used for.
+    explicit bounce_buffer(size_t bytes, size_t alignment = 0);
+
+    //! Returns the buffer to the pool.
+    ~bounce_buffer();
+
+    //! non-copyable: delete copy-constructor
+    bounce_buffer(const bounce_buffer&) = delete;
+    //! non-copyable: delete assignment operator
+    bounce_buffer& operator = (const bounce_buffer&) = delete;
+
+    char * get() const { return data_; }
+
+    size_t size() const { return size_; }
+
+private:
+    size_t size_;
+    //! start of the allocation, data_ is rounded up to the alignment
+    char* raw_;
+    char* data_;
+};
+
+//! \}
+
+} // namespace foxxll
+
+#endif // !FOXXLL_IO_BOUNCE_BUFFER_HEADER
+
+/**************************************************************************/
@@ -0,0 +1,415 @@
+/***************************************************************************
+ *  foxxll/io/compacting_file.cpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstring>
+
+#include <tlx/logger.hpp>
+
+#include <foxxll/common/aligned_alloc.hpp>
+#include <foxxll/common/error_handling.hpp>
+#include <foxxll/common/exceptions.hpp>
+#include <foxxll/io/compacting_file.hpp>
+
+namespace foxxll {
+
+constexpr size_t compacting_file::default_segment_size;
+constexpr size_t compacting_file::max_moves;
+constexpr size_t compacting_file::no_segment;
+
+compacting_file::compacting_file(
+    const file_ptr& base, size_t segment_size, double interval)
+    : file(base->get_device_id(), base->get_file_stats()),
+      disk_queued_file(base->get_queue_id(), base->get_allocator_id()),
+      base_(base),
+      segment_size_(segment_size),
+      size_(base->size()),
+      buffer_(nullptr),
+      interval_(interval)
+{
+    FOXXLL_THROW_IF(segment_size_ == 0 || segment_size_ % BlockAlignment != 0,
+                    std::invalid_argument,
+                    "compacting_file segment size " << segment_size_ <<
+                    " is not a multiple of " << BlockAlignment);
+
+    inherit_alignment(*base_);
+
+    // keep the existing contents in place: map each segment to itself
+    const size_t num_segments =
+        static_cast<size_t>((size_ + segment_size_ - 1) / segment_size_);
+    base_->set_size(num_segments * segment_size_);
+
+    segments_.resize(num_segments);
+    owner_.resize(num_segments);
+    for (size_t s = 0; s < num_segments; ++s)
+    {
+        segments_[s].base = s;
+        segments_[s].live.assign(segment_size_ / BlockAlignment, true);
+        segments_[s].num_live = segment_size_ / BlockAlignment;
+        owner_[s] = s;
+    }
+
+    buffer_ = static_cast<char*>(aligned_alloc<BlockAlignment>(segment_size_));
+
+    if (interval_ > 0)
+        thread_ = std::thread(&compacting_file::run, this);
+}
+
+compacting_file::~compacting_file()
+{
+    if (thread_.joinable())
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    LOG << "compacting_file: relocations=" << relocations_ <<
+        " base segments=" << owner_.size();
+
+    aligned_dealloc<BlockAlignment>(buffer_);
+}
+
+void compacting_file::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stop_)
+    {
+        cv_.wait_for(lock, std::chrono::duration<double>(interval_),
+                     [this]() { return stop_; });
+        if (stop_)
+            break;
+
+        lock.unlock();
+        try {
+            compact();
+        }
+        catch (const io_error& e) {
+            LOG1 << "compacting_file: error during compaction: " << e.what();
+        }
+        lock.lock();
+    }
+}
+
+size_t compacting_file::mapped_segments() const
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return owner_.size() - free_base_.size();
+}
+
+size_t compacting_file::base_segments() const
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return owner_.size();
+}
+
+uint64_t compacting_file::relocations() const
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return relocations_;
+}
+
+size_t compacting_file::begin_io(
+    size_t seg, offset_type seg_offset, size_type bytes,
+    request::read_or_write op)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // set_size() may shrink the segments while waiting for a relocation,
+    // check the bounds after each wakeup
+    for ( ; ; )
+    {
+        if (seg >= segments_.size())
+        {
+            FOXXLL_THROW_IF(op == request::READ, io_error,
+                            "compacting_file: read beyond the end of the file");
+            segments_.resize(seg + 1);
+        }
+        if (!segments_[seg].moving)
+            break;
+        cv_.wait(lock);
+    }
+
+    if (op == request::WRITE)
+        size_ = std::max<offset_type>(
+            size_, seg * segment_size_ + seg_offset + bytes);
+
+    segment& s = segments_[seg];
+    if (op == request::WRITE)
+    {
+        if (s.base == no_segment)
+        {
+            // map to the first free base segment, or append one
+            if (!free_base_.empty()) {
+                s.base = *free_base_.begin();
+                free_base_.erase(free_base_.begin());
+            }
+            else {
+                s.base = owner_.size();
+                owner_.push_back(no_segment);
+                base_->set_size(owner_.size() * segment_size_);
+            }
+            owner_[s.base] = seg;
+            s.live.assign(segment_size_ / BlockAlignment, false);
+            s.num_live = 0;
+        }
+
+        const size_t first = static_cast<size_t>(seg_offset / BlockAlignment);
+        const size_t last = static_cast<size_t>(
+            (seg_offset + bytes + BlockAlignment - 1) / BlockAlignment);
+        for (size_t u = first; u < last; ++u)
+        {
+            if (!s.live[u]) {
+                s.live[u] = true;
+                ++s.num_live;
+            }
+        }
+    }
+
+    ++s.inflight;
+    return s.base;
+}
+
+void compacting_file::end_io(size_t seg)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    segment& s = segments_[seg];
+    assert(s.inflight > 0);
+    if (--s.inflight == 0 && s.moving) {
+        lock.unlock();
+        cv_.notify_all();
+    }
+}
+
+void compacting_file::serve(void* buffer, offset_type offset, size_type bytes,
+                            request::read_or_write op)
+{
+    char* cbuffer = static_cast<char*>(buffer);
+
+    // split request at segment boundaries
+    while (bytes > 0)
+    {
+        const size_t seg = static_cast<size_t>(offset / segment_size_);
+        const offset_type seg_offset = offset % segment_size_;
+        const size_type len = static_cast<size_type>(
+            std::min<offset_type>(bytes, segment_size_ - seg_offset));
+
+        const size_t b = begin_io(seg, seg_offset, len, op);
+        try {
+            if (b == no_segment)
+                memset(cbuffer, 0, len);
+            else
+                base_->serve(cbuffer, b * segment_size_ + seg_offset, len, op);
+        }
+        catch (...) {
+            end_io(seg);
+            throw;
+        }
+        end_io(seg);
+
+        cbuffer += len;
+        offset += len;
+        bytes -= len;
+    }
+}
+
+void compacting_file::release(size_t seg)
+{
+    segment& s = segments_[seg];
+    assert(s.base != no_segment && s.inflight == 0 && !s.moving);
+
+    const size_t b = s.base;
+    owner_[b] = no_segment;
+    free_base_.insert(b);
+    s.base = no_segment;
+    s.live.clear();
+    s.num_live = 0;
+
+    // interior segments stay allocated in the base file until it is
+    // truncated, give their space back to the file system
+    if (b + 1 < owner_.size())
+        base_->discard(b * segment_size_, segment_size_);
+}
+
+void compacting_file::trim()
+{
+    const size_t old_segments = owner_.size();
+    while (!owner_.empty() && owner_.back() == no_segment)
+    {
+        owner_.pop_back();
+        free_base_.erase(owner_.size());
+    }
+    if (owner_.size() != old_segments)
+        base_->set_size(owner_.size() * segment_size_);
+}
+
+void compacting_file::discard(offset_type offset, offset_type size)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // only units completely inside the range are free
+    offset_type begin = (offset + BlockAlignment - 1) / BlockAlignment;
+    const offset_type end = std::min<offset_type>(
+        (offset + size) / BlockAlignment, size_ / BlockAlignment);
+    const size_t units = segment_size_ / BlockAlignment;
+
+    while (begin < end)
+    {
+        const size_t seg = static_cast<size_t>(begin / units);
+        cv_.wait(lock, [&]() {
+                     return seg >= segments_.size() || !segments_[seg].moving;
+                 });
+        // shrunk by set_size() in the meantime
+        if (seg >= segments_.size())
+            break;
+
+        segment& s = segments_[seg];
+        const size_t first = static_cast<size_t>(begin % units);
+        const size_t last = static_cast<size_t>(
+            std::min<offset_type>(end - seg * units, units));
+
+        if (s.base != no_segment)
+        {
+            for (size_t u = first; u < last; ++u)
+            {
+                if (s.live[u]) {
+                    s.live[u] = false;
+                    --s.num_live;
+                }
+            }
+            // segments which are in use are released by compact()
+            if (s.num_live == 0 && s.inflight == 0 && !s.moving)
+                release(seg);
+        }
+
+        begin = seg * units + last;
+    }
+
+    trim();
+}
+
+void compacting_file::set_size(offset_type newsize)
+{
+    std::unique_lock<std::mutex> compact_lock(compact_mutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    const size_t num_segments =
+        static_cast<size_t>((newsize + segment_size_ - 1) / segment_size_);
+
+    for (size_t seg = num_segments; seg < segments_.size(); ++seg)
+    {
+        cv_.wait(lock, [&]() { return segments_[seg].inflight == 0; });
+        if (segments_[seg].base != no_segment)
+            release(seg);
+    }
+
+    segments_.resize(num_segments);
+    size_ = newsize;
+
+    trim();
+}
+
+file::offset_type compacting_file::size()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return size_;
+}
+
+size_t compacting_file::compact()
+{
+    std::unique_lock<std::mutex> compact_lock(compact_mutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // release segments whose data was discarded while they were in use
+    for (size_t seg = 0; seg < segments_.size(); ++seg)
+    {
+        const segment& s = segments_[seg];
+        if (s.base != no_segment && s.num_live == 0 && s.inflight == 0)
+            release(seg);
+    }
+    trim();
+
+    size_t moved = 0;
+    while (moved < max_moves && !free_base_.empty())
+    {
+        // move the last base segment into the first free one
+        const size_t to = *free_base_.begin();
+        const size_t from = owner_.size() - 1;
+        if (to >= from)
+            break;
+
+        const size_t seg = owner_[from];
+        assert(seg != no_segment);
+
+        // reserve the target, then wait for the I/Os on the segment
+        free_base_.erase(free_base_.begin());
+        owner_[to] = seg;
+
+        segments_[seg].moving = true;
+        cv_.wait(lock, [&]() { return segments_[seg].inflight == 0; });
+
+        lock.unlock();
+
+        bool ok = true;
+        try {
+            base_->serve(buffer_, from * segment_size_, segment_size_,
+                         request::READ);
+            base_->serve(buffer_, to * segment_size_, segment_size_,
+                         request::WRITE);
+        }
+        catch (const io_error& e) {
+            LOG1 << "compacting_file: error relocating segment " << seg <<
+                ": " << e.what();
+            ok = false;
+        }
+
+        lock.lock();
+
+        segments_[seg].moving = false;
+        cv_.notify_all();
+
+        if (!ok) {
+            owner_[to] = no_segment;
+            free_base_.insert(to);
+            break;
+        }
+
+        segments_[seg].base = to;
+        owner_[from] = no_segment;
+        free_base_.insert(from);
+        ++relocations_;
+        ++moved;
+
+        trim();
+    }
+
+    LOG << "compacting_file::compact() relocated " << moved <<
+        " segments, base segments " << owner_.size();
+
+    return moved;
+}
+
+const char* compacting_file::io_type() const
+{
+    return "compacting";
+}
+
+} // namespace foxxll
+
+/**************************************************************************/
@@ -0,0 +1,185 @@
+/***************************************************************************
+ *  foxxll/io/compacting_file.hpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef FOXXLL_IO_COMPACTING_FILE_HEADER
+#define FOXXLL_IO_COMPACTING_FILE_HEADER
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include <foxxll/io/disk_queued_file.hpp>
+#include <foxxll/io/file.hpp>
+
+namespace foxxll {
+
+//! \addtogroup foxxll_fileimpl
+//! \{
+
+/*!
+ * Disk file which keeps its underlying file compact by an indirection of
+ * fixed-size segments.
+ *
+ * Blocks keep their offsets in the compacting_file, while the segments holding
+ * them are mapped to segments of the base file. A segment is mapped on its
+ * first write, reads of unmapped segments return zeros. discard() marks the
+ * discarded range as free, a segment without live data releases its base
+ * segment, which is discarded in the base file (e.g. by punching a hole).
+ *
+ * compact() relocates the segments at the end of the base file into free
+ * segments further ahead and truncates the base file behind the last mapped
+ * segment, a background thread does so periodically. I/O on a segment which is
+ * being relocated waits until the copy has finished, hence the application
+ * continues to use its BIDs during compaction.
+ */
+class compacting_file final : public disk_queued_file
+{
+    constexpr static bool debug = false;
+
+public:
+    //! default relocation granularity
+    static constexpr size_t default_segment_size = 4 * 1024 * 1024;
+
+    //! maximum number of segments relocated per compaction round
+    static constexpr size_t max_moves = 16;
+
+    //! marks an unmapped segment
+    static constexpr size_t no_segment = size_t(-1);
+
+    //! Wraps a base file, which must be served synchronously (i.e. not
+    //! linuxaio or fileperblock). The current contents of the base file are
+    //! kept at their offsets.
+    //! \param base the file holding the data
+    //! \param segment_size relocation granularity, multiple of BlockAlignment
+    //! \param interval seconds between compaction rounds of the background
+    //! thread, 0 = no background thread, call compact() explicitly
+    compacting_file(const file_ptr& base,
+                    size_t segment_size = default_segment_size,
+                    double interval = 1.0);
+
+    ~compacting_file();
+
+    void serve(void* buffer, offset_type offset, size_type bytes,
+               request::read_or_write op) final;
+
+    //! Sets the size of the compacting_file, segments behind the new end are
+    //! released.
+    void set_size(offset_type newsize) final;
+
+    offset_type size() final;
+
+    void lock() final { base_->lock(); }
+
+    void discard(offset_type offset, offset_type size) final;
+
+    void close_remove() final { base_->close_remove(); }
+
+    const char * io_type() const final;
+
+    size_t segment_size() const { return segment_size_; }
+
+    //! Runs one compaction round: relocates up to max_moves segments from the
+    //! end of the base file into free segments and truncates the base file.
+    //! \return number of relocated segments
+    size_t compact();
+
+    //! \name Statistics
+    //! \{
+
+    //! number of segments holding live data
+    size_t mapped_segments() const;
+
+    //! number of segments of the base file, including free ones
+    size_t base_segments() const;
+
+    //! number of segments relocated by compaction
+    uint64_t relocations() const;
+
+    //! \}
+
+private:
+    //! mapping and usage of a segment of the compacting_file
+    struct segment
+    {
+        //! segment of the base file, or no_segment
+        size_t base = no_segment;
+        //! number of I/Os currently served on the segment
+        unsigned inflight = 0;
+        //! whether the segment is being relocated
+        bool moving = false;
+        //! which BlockAlignment units were written and not discarded
+        std::vector<bool> live;
+        //! number of set entries in live
+        size_t num_live = 0;
+    };
+
+    file_ptr base_;
+    const size_t segment_size_;
+
+    //! protects all mapping state
+    mutable std::mutex mutex_;
+    //! signaled on the end of I/Os and relocations
+    std::condition_variable cv_;
+
+    //! serializes compaction rounds, protects buffer_
+    std::mutex compact_mutex_;
+
+    //! size of the compacting_file
+    offset_type size_;
+
+    //! segments of the compacting_file
+    std::vector<segment> segments_;
+    //! segment of the compacting_file mapped to each base segment, or
+    //! no_segment
+    std::vector<size_t> owner_;
+    //! unmapped base segments, all below owner_.size()
+    std::set<size_t> free_base_;
+
+    //! bounce buffer of the relocations
+    char* buffer_;
+
+    uint64_t relocations_ = 0;
+
+    const double interval_;
+    bool stop_ = false;
+    std::thread thread_;
+
+    //! main loop of the compaction thread
+    void run();
+
+    //! start I/O on a segment, waits for a running relocation, and maps the
+    //! segment on writes
+    //! \return base segment, or no_segment for reads of unmapped segments
+    size_t begin_io(size_t seg, offset_type seg_offset, size_type bytes,
+                    request::read_or_write op);
+    //! end I/O on a segment
+    void end_io(size_t seg);
+
+    //! return a segment's base segment to the free set, expects the mutex_
+    //! to be locked
+    void release(size_t seg);
+
+    //! release unused segments and shrink the base file to the last mapped
+    //! segment, expects the mutex_ to be locked
+    void trim();
+};
+
+//! \}
+
+} // namespace foxxll
+
+#endif // !FOXXLL_IO_COMPACTING_FILE_HEADER
+
+/**************************************************************************/
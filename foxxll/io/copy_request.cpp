@@ -0,0 +1,86 @@
+/***************************************************************************
+ *  foxxll/io/copy_request.cpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <iomanip>
+
+#include <tlx/logger.hpp>
+
+#include <foxxll/common/exceptions.hpp>
+#include <foxxll/io/copy_request.hpp>
+#include <foxxll/io/disk_queues.hpp>
+#include <foxxll/io/file.hpp>
+#include <foxxll/io/iostats.hpp>
+
+namespace foxxll {
+
+copy_request::copy_request(
+    const completion_handler& on_complete,
+    file* file, offset_type offset,
+    foxxll::file* dst, offset_type dst_offset, size_type bytes,
+    int queue_id, priority_class priority)
+    : serving_request(on_complete, file, nullptr, offset, bytes,
+                      READ, queue_id, priority),
+      dst_(dst), dst_offset_(dst_offset)
+{
+    dst_->add_request_ref();
+}
+
+copy_request::~copy_request()
+{
+    // a canceled request still references dst_
+    release_dst_reference();
+}
+
+void copy_request::release_dst_reference()
+{
+    if (dst_) {
+        dst_->delete_request_ref();
+        dst_ = nullptr;
+    }
+}
+
+void copy_request::serve()
+{
+    check_nref();
+    LOG << "copy_request[" << static_cast<void*>(this) << "]::serve(): " <<
+        "[" << file_ << "]0x" <<
+        std::hex << std::setfill('0') << std::setw(8) <<
+        offset_ << " -> [" << dst_ << "]0x" << dst_offset_ << "/0x" << bytes_;
+
+    // the request is throttled as a read by the source queue, charge the
+    // write to the destination's queue
+    if (dst_->get_queue_id() != queue_id())
+    {
+        const double waited = disk_queues::get_instance()->acquire(
+            dst_->get_queue_id(), bytes_);
+        if (waited > 0 && dst_->get_file_stats())
+            dst_->get_file_stats()->throttled(waited);
+    }
+
+    try
+    {
+        file_->copy(offset_, dst_, dst_offset_, bytes_);
+    }
+    catch (const io_error& ex)
+    {
+        error_occured(ex.what());
+    }
+
+    check_nref(true);
+
+    release_dst_reference();
+    completed(false);
+}
+
+} // namespace foxxll
+
+/**************************************************************************/
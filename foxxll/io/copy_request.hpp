@@ -0,0 +1,61 @@
+/***************************************************************************
+ *  foxxll/io/copy_request.hpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef FOXXLL_IO_COPY_REQUEST_HEADER
+#define FOXXLL_IO_COPY_REQUEST_HEADER
+
+#include <foxxll/io/serving_request.hpp>
+
+namespace foxxll {
+
+//! \addtogroup foxxll_reqlayer
+//! \{
+
+//! Request which copies a range of its file to another file by calling
+//! file::copy(). It is a READ of the source file, served by the source file's
+//! queue, the write is charged to the rate limits of the destination's queue.
+class copy_request : public serving_request
+{
+    constexpr static bool debug = false;
+
+protected:
+    //! file to copy to
+    file* dst_;
+    //! offset within dst_
+    offset_type dst_offset_;
+
+public:
+    copy_request(
+        const completion_handler& on_complete,
+        file* file, offset_type offset,
+        foxxll::file* dst, offset_type dst_offset, size_type bytes,
+        int queue_id, priority_class priority = DEMAND);
+
+    ~copy_request();
+
+    foxxll::file * get_dst_file() const { return dst_; }
+    offset_type dst_offset() const { return dst_offset_; }
+
+protected:
+    void serve() final;
+
+private:
+    void release_dst_reference();
+};
+
+//! \}
+
+} // namespace foxxll
+
+#endif // !FOXXLL_IO_COPY_REQUEST_HEADER
+
+/**************************************************************************/
@@ -58,6 +58,9 @@ file_ptr create_file(disk_config& cfg, int mode, int disk_allocator_id)
         break;
     }
 
+    if (cfg.prealloc)
+        mode |= file::PREALLOC;
+
     // automatically enumerate disks as separate device ids
 
     if (cfg.device_id == file::DEFAULT_DEVICE_ID)
@@ -129,7 +132,8 @@ file_ptr create_file(disk_config& cfg, int mode, int disk_allocator_id)
         tlx::counting_ptr<ufs_file_base> result =
             tlx::make_counting<linuxaio_file>(
                 cfg.path, mode, cfg.queue, disk_allocator_id,
-                cfg.device_id, cfg.queue_length
+                cfg.device_id, cfg.queue_length,
+                static_cast<linuxaio_queue::completion_mode>(cfg.aio_completion)
             );
 
         result->lock();
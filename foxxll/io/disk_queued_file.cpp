@@ -10,6 +10,7 @@
  *  http://www.boost.org/LICENSE_1_0.txt)
  **************************************************************************/
 
+#include <foxxll/io/copy_request.hpp>
 #include <foxxll/io/disk_queued_file.hpp>
 #include <foxxll/io/disk_queues.hpp>
 #include <foxxll/io/file.hpp>
@@ -22,10 +23,10 @@ namespace foxxll {
 
 request_ptr disk_queued_file::aread(
     void* buffer, offset_type offset, size_type bytes,
-    const completion_handler& on_complete)
+    const completion_handler& on_complete, request::priority_class priority)
 {
     request_ptr req = tlx::make_counting<serving_request>(
-            on_complete, this, buffer, offset, bytes, request::READ
+            on_complete, this, buffer, offset, bytes, request::READ, priority
         );
 
     disk_queues::get_instance()->add_request(req, get_queue_id());
@@ -35,10 +36,24 @@ request_ptr disk_queued_file::aread(
 
 request_ptr disk_queued_file::awrite(
     void* buffer, offset_type offset, size_type bytes,
-    const completion_handler& on_complete)
+    const completion_handler& on_complete, request::priority_class priority)
 {
     request_ptr req = tlx::make_counting<serving_request>(
-            on_complete, this, buffer, offset, bytes, request::WRITE
+            on_complete, this, buffer, offset, bytes, request::WRITE, priority
+        );
+
+    disk_queues::get_instance()->add_request(req, get_queue_id());
+
+    return req;
+}
+
+request_ptr disk_queued_file::acopy(
+    offset_type offset, file* dst, offset_type dst_offset, size_type bytes,
+    const completion_handler& on_complete, request::priority_class priority)
+{
+    request_ptr req = tlx::make_counting<copy_request>(
+            on_complete, this, offset, dst, dst_offset, bytes,
+            get_queue_id(), priority
         );
 
     disk_queues::get_instance()->add_request(req, get_queue_id());
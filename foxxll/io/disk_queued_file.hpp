@@ -35,11 +35,18 @@ public:
 
     request_ptr aread(
         void* buffer, offset_type pos, size_type bytes,
-        const completion_handler& on_complete = completion_handler()) override;
+        const completion_handler& on_complete = completion_handler(),
+        request::priority_class priority = request::DEMAND) override;
 
     request_ptr awrite(
         void* buffer, offset_type pos, size_type bytes,
-        const completion_handler& on_complete = completion_handler()) override;
+        const completion_handler& on_complete = completion_handler(),
+        request::priority_class priority = request::DEMAND) override;
+
+    request_ptr acopy(
+        offset_type offset, file* dst, offset_type dst_offset, size_type bytes,
+        const completion_handler& on_complete = completion_handler(),
+        request::priority_class priority = request::DEMAND) override;
 
     int get_queue_id() const override
     {
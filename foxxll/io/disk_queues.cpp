@@ -23,9 +23,15 @@
 
 namespace foxxll {
 
+constexpr disk_queues::disk_id_type disk_queues::min_table_id;
+constexpr size_t disk_queues::table_size;
+
 disk_queues::disk_queues()
 {
     stats::get_instance();     // initialize stats before ourselves
+
+    for (size_t i = 0; i < table_size; ++i)
+        table_[i].store(nullptr, std::memory_order_relaxed);
 }
 
 disk_queues::~disk_queues()
@@ -36,7 +42,33 @@ disk_queues::~disk_queues()
         delete (*i).second;
 }
 
-void disk_queues::make_queue(file* file)
+request_queue* disk_queues::find_queue(disk_id_type disk)
+{
+    // queues are never removed, hence a published pointer stays valid
+    if (disk >= min_table_id &&
+        disk < min_table_id + static_cast<disk_id_type>(table_size))
+        return table_[disk - min_table_id].load(std::memory_order_acquire);
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    request_queue_map::iterator qi = queues_.find(disk);
+    if (qi == queues_.end())
+        return nullptr;
+
+    return qi->second;
+}
+
+void disk_queues::insert_queue(disk_id_type disk, request_queue* q)
+{
+    queues_[disk] = q;
+
+    if (disk >= min_table_id &&
+        disk < min_table_id + static_cast<disk_id_type>(table_size))
+        table_[disk - min_table_id].store(q, std::memory_order_release);
+}
+
+void disk_queues::make_queue(
+    file* file, unsigned int num_threads, unsigned int max_threads)
 {
     std::unique_lock<std::mutex> lock(mutex_);
 
@@ -50,61 +82,108 @@ void disk_queues::make_queue(file* file)
 #if FOXXLL_HAVE_LINUXAIO_FILE
     if (const linuxaio_file* af =
             dynamic_cast<const linuxaio_file*>(file)) {
-        queues_[queue_id] = new linuxaio_queue(af->get_desired_queue_length());
+        insert_queue(queue_id, new linuxaio_queue(
+                         af->get_desired_queue_length(),
+                         af->get_completion_mode()));
         return;
     }
 #endif
-    queues_[queue_id] = new request_queue_impl_qwqr();
+    insert_queue(queue_id, new request_queue_impl_qwqr(
+                     static_cast<int>(num_threads),
+                     static_cast<int>(max_threads)));
 }
 
 void disk_queues::add_request(request_ptr& req, disk_id_type disk)
 {
-    std::unique_lock<std::mutex> lock(mutex_);
-
 #ifdef FOXXLL_HACK_SINGLE_IO_THREAD
     disk = 42;
 #endif
-    request_queue_map::iterator qi = queues_.find(disk);
-    request_queue* q;
-    if (qi == queues_.end())
+    request_queue* q = find_queue(disk);
+    if (q == nullptr)
     {
-        // create new request queue
-#if FOXXLL_HAVE_LINUXAIO_FILE
-        if (dynamic_cast<linuxaio_request*>(req.get()))
-            q = queues_[disk] = new linuxaio_queue(
-                        dynamic_cast<linuxaio_file*>(req->get_file())->get_desired_queue_length()
-                    );
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        // another thread may have created the queue in the meantime
+        request_queue_map::iterator qi = queues_.find(disk);
+        if (qi != queues_.end())
+            q = qi->second;
         else
+        {
+            // create new request queue
+#if FOXXLL_HAVE_LINUXAIO_FILE
+            if (dynamic_cast<linuxaio_request*>(req.get())) {
+                const linuxaio_file* af =
+                    dynamic_cast<linuxaio_file*>(req->get_file());
+                q = new linuxaio_queue(
+                    af->get_desired_queue_length(), af->get_completion_mode());
+            }
+            else
 #endif
-        q = queues_[disk] = new request_queue_impl_qwqr();
+            q = new request_queue_impl_qwqr();
+
+            insert_queue(disk, q);
+        }
     }
-    else
-        q = qi->second;
 
     q->add_request(req);
 }
 
 bool disk_queues::cancel_request(request_ptr& req, disk_id_type disk)
 {
-    std::unique_lock<std::mutex> lock(mutex_);
+#ifdef FOXXLL_HACK_SINGLE_IO_THREAD
+    disk = 42;
+#endif
+    request_queue* q = find_queue(disk);
+    if (q == nullptr)
+        return false;
+
+    return q->cancel_request(req);
+}
 
+bool disk_queues::set_request_priority(
+    request_ptr& req, request::priority_class priority, disk_id_type disk)
+{
 #ifdef FOXXLL_HACK_SINGLE_IO_THREAD
     disk = 42;
 #endif
-    if (queues_.find(disk) != queues_.end())
-        return queues_[disk]->cancel_request(req);
-    else
+    request_queue* q = find_queue(disk);
+    if (q == nullptr)
         return false;
+
+    return q->set_request_priority(req, priority);
 }
 
 request_queue* disk_queues::get_queue(disk_id_type disk)
 {
-    std::unique_lock<std::mutex> lock(mutex_);
+    return find_queue(disk);
+}
 
-    if (queues_.find(disk) != queues_.end())
-        return queues_[disk];
-    else
-        return nullptr;
+size_t disk_queues::num_waiting_requests(disk_id_type disk)
+{
+#ifdef FOXXLL_HACK_SINGLE_IO_THREAD
+    disk = 42;
+#endif
+    request_queue* q = find_queue(disk);
+    if (q == nullptr)
+        return 0;
+
+    return q->num_waiting_requests();
+}
+
+void disk_queues::set_rate_limit(
+    disk_id_type disk, double bytes_per_sec, double ops_per_sec)
+{
+    request_queue* q = find_queue(disk);
+    if (q == nullptr)
+        FOXXLL_THROW_INVALID_ARGUMENT("No queue for disk " << disk << ".");
+
+    q->set_rate_limit(bytes_per_sec, ops_per_sec);
+}
+
+double disk_queues::acquire(disk_id_type disk, size_t bytes)
+{
+    request_queue* q = find_queue(disk);
+    return q ? q->acquire(bytes) : 0;
 }
 
 void disk_queues::set_priority_op(const request_queue::priority_op& op)
@@ -16,6 +16,7 @@
 #ifndef FOXXLL_IO_DISK_QUEUES_HEADER
 #define FOXXLL_IO_DISK_QUEUES_HEADER
 
+#include <atomic>
 #include <map>
 #include <mutex>
 
@@ -43,15 +44,42 @@ class disk_queues : public singleton<disk_queues>
     using disk_id_type = int64_t;
     using request_queue_map = std::map<disk_id_type, request_queue*>;
 
+public:
+    //! smallest queue id found in the dispatch table, covers the negative
+    //! default queue ids of the file implementations
+    static constexpr disk_id_type min_table_id = -8;
+
+    //! number of queue ids found in the dispatch table
+    static constexpr size_t table_size = 256;
+
 protected:
+    //! protects creation of queues and queues_
     std::mutex mutex_;
 
+    //! owns all queues, which live until the disk_queues are destroyed
     request_queue_map queues_;
 
+    //! Queues of the ids [min_table_id, min_table_id + table_size), published
+    //! once on creation. Requests of these ids are dispatched without taking
+    //! the mutex_, other ids are looked up in queues_.
+    std::atomic<request_queue*> table_[table_size];
+
     disk_queues();
 
+    //! Returns the queue of a disk, nullptr if it has no queue yet.
+    request_queue * find_queue(disk_id_type disk);
+
+    //! Inserts a new queue, expects the mutex_ to be locked.
+    void insert_queue(disk_id_type disk, request_queue* q);
+
 public:
-    void make_queue(file* file);
+    //! Creates the request queue of the file's queue id, unless it exists.
+    //! \param file file whose requests are to be served by the queue
+    //! \param num_threads number of worker threads for queues which support it
+    //! \param max_threads if larger than num_threads, the number of active
+    //! worker threads is adapted at runtime up to this limit
+    void make_queue(file* file, unsigned int num_threads = 1,
+                    unsigned int max_threads = 0);
 
     void add_request(request_ptr& req, disk_id_type disk);
 
@@ -65,8 +93,35 @@ public:
     //! \return \c true iff the request was canceled successfully
     bool cancel_request(request_ptr& req, disk_id_type disk);
 
+    //! Moves a request to another priority class, unless it is already being
+    //! processed.
+    //! \param req request to change
+    //! \param priority new priority class
+    //! \param disk disk number for disk that \c req was scheduled on
+    //! \return \c true iff the request was still waiting in the queue
+    bool set_request_priority(
+        request_ptr& req, request::priority_class priority, disk_id_type disk);
+
     request_queue * get_queue(disk_id_type disk);
 
+    //! Returns the number of requests waiting in the queue of a disk, 0 if
+    //! the disk has no queue yet.
+    size_t num_waiting_requests(disk_id_type disk);
+
+    //! Limits the rate at which requests are issued to a disk, can be changed
+    //! at any time.
+    //! \param disk disk number (queue id) to limit
+    //! \param bytes_per_sec bandwidth limit, 0 = unlimited
+    //! \param ops_per_sec limit of I/O operations per second, 0 = unlimited
+    void set_rate_limit(disk_id_type disk,
+                        double bytes_per_sec, double ops_per_sec);
+
+    //! Accounts a transfer to a disk which is served by another disk's queue
+    //! against the rate limits of the disk's queue, see
+    //! request_queue::acquire().
+    //! \return seconds waited, 0 if the disk has no queue
+    double acquire(disk_id_type disk, size_t bytes);
+
     ~disk_queues();
 
     //! Changes requests priorities.
@@ -10,6 +10,9 @@
  *  http://www.boost.org/LICENSE_1_0.txt)
  **************************************************************************/
 
+#include <algorithm>
+
+#include <foxxll/io/bounce_buffer.hpp>
 #include <foxxll/io/file.hpp>
 #include <foxxll/io/ufs_platform.hpp>
 
@@ -20,6 +23,33 @@ int file::unlink(const char* path)
     return ::unlink(path);
 }
 
+void file::copy(offset_type offset, file* dst, offset_type dst_offset,
+                size_type bytes)
+{
+    if (bytes == 0)
+        return;
+
+    static constexpr size_t max_bounce = 1024 * 1024;
+
+    // round up for files which need aligned transfers
+    const size_t unit = std::max(
+        BlockAlignment,
+        std::max(logical_block_size(), dst->logical_block_size()));
+    // chunks are multiples of unit, so they keep the alignment of the range
+    const size_t chunk = std::max(unit, max_bounce / unit * unit);
+    bounce_buffer buffer(std::min<size_t>(
+                             chunk, (bytes + unit - 1) / unit * unit),
+                         std::max(memory_alignment(), dst->memory_alignment()));
+
+    while (bytes > 0)
+    {
+        const size_type part = std::min<size_type>(bytes, chunk);
+        serve(buffer.get(), offset, part, request::READ);
+        dst->serve(buffer.get(), dst_offset, part, request::WRITE);
+        offset += part, dst_offset += part, bytes -= part;
+    }
+}
+
 } // namespace foxxll
 
 /******************************************************************************/
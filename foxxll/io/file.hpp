@@ -83,11 +83,22 @@ public:
         //! do not acquire an exclusive lock by default
         NO_LOCK = 128,
         //! implies DIRECT, fail if opening with DIRECT flag does not work.
-        REQUIRE_DIRECT = 256
+        REQUIRE_DIRECT = 256,
+        //! allocate the blocks of the file system when growing the file with
+        //! set_size() instead of creating a sparse file, where supported.
+        PREALLOC = 512,
+        //! reads extending past the end of the file transfer only the bytes
+        //! up to the end, see request::transferred(), instead of filling the
+        //! remainder of the buffer with zeroes. The contents of the remainder
+        //! are unspecified.
+        EOF_TRUNCATE = 1024
     };
 
     static const int DEFAULT_QUEUE = -1;
     static const int DEFAULT_LINUXAIO_QUEUE = -2;
+    //! queue of the serving_requests (e.g. copies) of files whose own queue
+    //! only accepts their native requests (linuxaio)
+    static const int DEFAULT_SERVING_QUEUE = -3;
     static const int NO_ALLOCATOR = -1;
     static const unsigned int DEFAULT_DEVICE_ID = std::numeric_limits<unsigned int>::max();
 
@@ -113,28 +124,54 @@ public:
     //! \param pos file position to start read from
     //! \param bytes number of bytes to transfer
     //! \param on_complete I/O completion handler
+    //! \param priority quality of service class of the request
     //! \return \c request_ptr request object, which can be used to track the
     //! status of the operation
 
     virtual request_ptr aread(
         void* buffer, offset_type pos, size_type bytes,
-        const completion_handler& on_complete = completion_handler()) = 0;
+        const completion_handler& on_complete = completion_handler(),
+        request::priority_class priority = request::DEMAND) = 0;
 
     //! Schedules an asynchronous write request to the file.
     //! \param buffer pointer to memory buffer to write from
     //! \param pos starting file position to write
     //! \param bytes number of bytes to transfer
     //! \param on_complete I/O completion handler
+    //! \param priority quality of service class of the request
     //! \return \c request_ptr request object, which can be used to track the
     //! status of the operation
 
     virtual request_ptr awrite(
         void* buffer, offset_type pos, size_type bytes,
-        const completion_handler& on_complete = completion_handler()) = 0;
+        const completion_handler& on_complete = completion_handler(),
+        request::priority_class priority = request::DEMAND) = 0;
+
+    //! Schedules an asynchronous copy of a range of this file to another file.
+    //! The request is served by this file's queue and counts as a read of
+    //! this file, the write is charged to the rate limits of dst's queue.
+    //! \param offset file position to start copying from
+    //! \param dst file to copy to
+    //! \param dst_offset position in dst to copy to
+    //! \param bytes number of bytes to copy
+    //! \param on_complete I/O completion handler
+    //! \param priority quality of service class of the request
+    //! \return \c request_ptr request object, which can be used to track the
+    //! status of the operation
+    virtual request_ptr acopy(
+        offset_type offset, file* dst, offset_type dst_offset, size_type bytes,
+        const completion_handler& on_complete = completion_handler(),
+        request::priority_class priority = request::DEMAND) = 0;
 
     virtual void serve(void* buffer, offset_type offset, size_type bytes,
                        request::read_or_write op) = 0;
 
+    //! Copies a range of this file to another file synchronously. The default
+    //! reads the range into a pooled buffer and writes it to dst, files
+    //! override it with copies inside the kernel or file system.
+    virtual void copy(offset_type offset, file* dst, offset_type dst_offset,
+                      size_type bytes);
+
     //! Changes the size of the file.
     //! \param newsize new file size
     virtual void set_size(offset_type newsize) = 0;
@@ -191,6 +228,36 @@ protected:
     //! Flag whether read/write operations REQUIRE alignment
     bool need_alignment_ = false;
 
+    //! Flag whether reads are truncated at the end of the file (EOF_TRUNCATE)
+    bool eof_truncate_ = false;
+
+    //! seconds a wait for a request spins before sleeping, 0 = no spinning
+    double poll_budget_ = 0.0;
+
+    //! \name Alignment, detected when opening the file
+    //! \{
+
+    //! alignment of offsets and sizes of direct I/O (logical block size)
+    size_t logical_block_size_ = BlockAlignment;
+    //! alignment of the device's writes without read-modify-write
+    size_t physical_block_size_ = BlockAlignment;
+    //! alignment of buffers of direct I/O
+    size_t memory_alignment_ = BlockAlignment;
+    //! preferred unit of I/O, e.g. the stripe width, 0 = unknown
+    size_t optimal_io_size_ = 0;
+
+    //! \}
+
+    //! take over the alignment requirements of a file this file maps to
+    void inherit_alignment(const file& base)
+    {
+        need_alignment_ = base.need_alignment_;
+        logical_block_size_ = base.logical_block_size_;
+        physical_block_size_ = base.physical_block_size_;
+        memory_alignment_ = base.memory_alignment_;
+        optimal_io_size_ = base.optimal_io_size_;
+    }
+
     //! The file's physical device id (e.g. used for prefetching sequence
     //! calculation)
     unsigned int device_id_;
@@ -203,6 +270,31 @@ public:
     //! Returns need_alignment_
     bool need_alignment() const { return need_alignment_; }
 
+    //! Returns whether reads are truncated at the end of the file.
+    bool eof_truncate() const { return eof_truncate_; }
+
+    //! Sets the time in seconds for which waiting for a request of this file
+    //! spins for the completion before sleeping, which saves the wakeup
+    //! latency on fast devices. Direct I/O files also use polled I/O
+    //! (RWF_HIPRI) where supported. 0 disables spinning.
+    void set_poll_budget(double seconds) { poll_budget_ = seconds; }
+
+    //! Returns the spin budget of waits for requests in seconds.
+    double poll_budget() const { return poll_budget_; }
+
+    //! Returns the alignment of offsets and sizes of direct I/O.
+    size_t logical_block_size() const { return logical_block_size_; }
+
+    //! Returns the block size the device writes without read-modify-write.
+    size_t physical_block_size() const { return physical_block_size_; }
+
+    //! Returns the alignment of buffers of direct I/O.
+    size_t memory_alignment() const { return memory_alignment_; }
+
+    //! Returns the preferred unit of I/O (e.g. the stripe width of a RAID),
+    //! or 0 if unknown.
+    size_t optimal_io_size() const { return optimal_io_size_; }
+
     //! Returns the file's physical device id
     unsigned int get_device_id() const
     {
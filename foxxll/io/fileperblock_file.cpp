@@ -16,6 +16,8 @@
 #include <iomanip>
 #include <sstream>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include <tlx/counting_ptr.hpp>
 #include <tlx/logger.hpp>
@@ -37,23 +39,54 @@
 
 namespace foxxll {
 
+template <class base_file_type>
+constexpr size_t fileperblock_file<base_file_type>::default_max_open_files;
+
+template <class base_file_type>
+constexpr size_t fileperblock_file<base_file_type>::spare_files;
+
 template <class base_file_type>
 fileperblock_file<base_file_type>::fileperblock_file(
     const std::string& filename_prefix,
     int mode,
     int queue_id,
     int allocator_id,
-    unsigned int device_id)
+    unsigned int device_id,
+    size_t max_open_files)
     : file(device_id),
       disk_queued_file(queue_id, allocator_id),
       filename_prefix_(filename_prefix),
       mode_(mode),
-      current_size_(0)
-{ }
+      current_size_(0),
+      max_open_files_(max_open_files)
+{
+    eof_truncate_ = (mode_ & EOF_TRUNCATE) != 0;
+
+    if (mode_ & PREALLOC)
+        spare_thread_ = std::thread(&fileperblock_file::prepare_spares, this);
+}
 
 template <class base_file_type>
 fileperblock_file<base_file_type>::~fileperblock_file()
 {
+    if (spare_thread_.joinable())
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        spare_cv_.notify_all();
+        spare_thread_.join();
+    }
+
+    for (std::pair<std::string, base_file_ptr>& spare : spares_)
+        spare.second->close_remove();
+
+    LOG << "fileperblock_file: cache hits=" << hits_ << " misses=" << misses_;
+
+    lru_.clear();
+    open_files_.clear();
+
     if (lock_file_)
         lock_file_->close_remove();
 }
@@ -72,10 +105,191 @@ void fileperblock_file<base_file_type>::serve(
     void* buffer, offset_type offset,
     size_type bytes, request::read_or_write op)
 {
-    base_file_type base_file(filename_for_block(offset), mode_, get_queue_id(),
-                             NO_ALLOCATOR, DEFAULT_DEVICE_ID, file_stats_);
-    base_file.set_size(bytes);
-    base_file.serve(buffer, 0, bytes, op);
+    base_file_ptr base_file = open_block(offset, bytes, op);
+    base_file->serve(buffer, 0, bytes, op);
+}
+
+template <class base_file_type>
+void fileperblock_file<base_file_type>::copy(
+    offset_type offset, file* dst, offset_type dst_offset, size_type bytes)
+{
+    base_file_ptr src_file = open_block(offset, bytes, request::READ);
+
+    if (fileperblock_file* fdst = dynamic_cast<fileperblock_file*>(dst))
+    {
+        base_file_ptr dst_file =
+            fdst->open_block(dst_offset, bytes, request::WRITE);
+        src_file->copy(0, dst_file.get(), 0, bytes);
+    }
+    else
+        src_file->copy(0, dst, dst_offset, bytes);
+}
+
+template <class base_file_type>
+typename fileperblock_file<base_file_type>::base_file_ptr
+fileperblock_file<base_file_type>::open_block(
+    offset_type offset, size_type bytes, request::read_or_write op)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    typename std::unordered_map<offset_type, typename lru_type::iterator>
+    ::iterator it = open_files_.find(offset);
+
+    if (it != open_files_.end())
+    {
+        ++hits_;
+        lru_.splice(lru_.begin(), lru_, it->second);
+
+        base_file_ptr base_file = it->second->file;
+        const bool resize = (it->second->size != bytes);
+        it->second->size = bytes;
+        lock.unlock();
+
+        if (resize)
+            base_file->set_size(bytes);
+        return base_file;
+    }
+
+    ++misses_;
+
+    // a write of a block without a file takes a spare file
+    std::pair<std::string, base_file_ptr> spare;
+    const size_type spare_size = spare_size_;
+    if (op == request::WRITE)
+    {
+        if (spare_thread_.joinable() && spare_size_ == 0) {
+            spare_size_ = bytes;
+            spare_cv_.notify_all();
+        }
+        if (!spares_.empty()) {
+            spare = std::move(spares_.back());
+            spares_.pop_back();
+            spare_cv_.notify_all();
+        }
+    }
+
+    lock.unlock();
+
+    const std::string filename = filename_for_block(offset);
+    base_file_ptr base_file;
+
+    if (spare.second)
+    {
+        try {
+            // moves the open spare file, so it is removed by its new path,
+            // unless the block already has a file
+            if (spare.second->rename(filename)) {
+                base_file = spare.second;
+                if (spare_size != bytes)
+                    base_file->set_size(bytes);
+            }
+            else {
+                lock.lock();
+                spares_.push_back(std::move(spare));
+                lock.unlock();
+            }
+        }
+        catch (const io_error& e) {
+            LOG1 << "rename() error on path=" << spare.first << " to=" <<
+                filename << ": " << e.what();
+            spare.second->close_remove();
+        }
+    }
+
+    if (!base_file)
+    {
+        base_file = base_file_ptr(new base_file_type(
+                                      filename, mode_, get_queue_id(),
+                                      NO_ALLOCATOR, DEFAULT_DEVICE_ID, file_stats_));
+        base_file->set_size(bytes);
+    }
+
+    if (max_open_files_ == 0)
+        return base_file;
+
+    std::vector<base_file_ptr> evicted;
+    lock.lock();
+
+    it = open_files_.find(offset);
+    if (it != open_files_.end())
+    {
+        // opened concurrently, both handles refer to the same block file
+        // but the other one may have been sized for a different request
+        lru_.splice(lru_.begin(), lru_, it->second);
+        evicted.push_back(base_file);
+        base_file = it->second->file;
+        const bool resize = (it->second->size != bytes);
+        it->second->size = bytes;
+        lock.unlock();
+
+        if (resize)
+            base_file->set_size(bytes);
+        return base_file;
+    }
+
+    lru_.push_front(open_file { offset, base_file, bytes });
+    open_files_[offset] = lru_.begin();
+
+    while (lru_.size() > max_open_files_)
+    {
+        evicted.push_back(lru_.back().file);
+        open_files_.erase(lru_.back().offset);
+        lru_.pop_back();
+    }
+
+    // close the evicted files without holding the lock
+    lock.unlock();
+    return base_file;
+}
+
+template <class base_file_type>
+void fileperblock_file<base_file_type>::close_block(offset_type offset)
+{
+    typename std::unordered_map<offset_type, typename lru_type::iterator>
+    ::iterator it = open_files_.find(offset);
+
+    if (it == open_files_.end())
+        return;
+
+    lru_.erase(it->second);
+    open_files_.erase(it);
+}
+
+template <class base_file_type>
+void fileperblock_file<base_file_type>::prepare_spares()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true)
+    {
+        spare_cv_.wait(lock, [this]() {
+                           return stop_ ||
+                           (spare_size_ != 0 && spares_.size() < spare_files);
+                       });
+        if (stop_)
+            break;
+
+        const std::string path =
+            filename_prefix_ + "_fpb_spare_" + std::to_string(spare_counter_++);
+        const size_type size = spare_size_;
+        lock.unlock();
+
+        base_file_ptr spare;
+        try {
+            spare = base_file_ptr(new base_file_type(
+                                      path, mode_ | CREAT, get_queue_id(),
+                                      NO_ALLOCATOR, DEFAULT_DEVICE_ID, file_stats_));
+            spare->set_size(size);
+        }
+        catch (const io_error& e) {
+            LOG1 << "fileperblock_file: error preparing spare file " << path <<
+                ", stopped preparing spare files: " << e.what();
+            return;
+        }
+
+        lock.lock();
+        spares_.emplace_back(path, spare);
+    }
 }
 
 template <class base_file_type>
@@ -105,6 +319,11 @@ template <class base_file_type>
 void fileperblock_file<base_file_type>::discard(offset_type offset, offset_type length)
 {
     tlx::unused(length);
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        close_block(offset);
+    }
+
 #ifdef FOXXLL_FILEPERBLOCK_NO_DELETE
     if (::truncate(filename_for_block(offset).c_str(), 0) != 0)
         LOG1 << "truncate() error on path=" << filename_for_block(offset) << " error=" << strerror(errno);
@@ -119,6 +338,11 @@ void fileperblock_file<base_file_type>::discard(offset_type offset, offset_type
 template <class base_file_type>
 void fileperblock_file<base_file_type>::export_files(offset_type offset, offset_type length, std::string filename)
 {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        close_block(offset);
+    }
+
     std::string original(filename_for_block(offset));
     filename.insert(0, original.substr(0, original.find_last_of("/") + 1));
     if (::remove(filename.c_str()) != 0)
@@ -143,6 +367,27 @@ const char* fileperblock_file<base_file_type>::io_type() const
     return "fileperblock";
 }
 
+template <class base_file_type>
+size_t fileperblock_file<base_file_type>::open_files()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return lru_.size();
+}
+
+template <class base_file_type>
+uint64_t fileperblock_file<base_file_type>::cache_hits()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return hits_;
+}
+
+template <class base_file_type>
+uint64_t fileperblock_file<base_file_type>::cache_misses()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return misses_;
+}
+
 ////////////////////////////////////////////////////////////////////////////
 
 template class fileperblock_file<syscall_file>;
@@ -13,7 +13,14 @@
 #ifndef FOXXLL_IO_FILEPERBLOCK_FILE_HEADER
 #define FOXXLL_IO_FILEPERBLOCK_FILE_HEADER
 
+#include <condition_variable>
+#include <list>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include <foxxll/io/disk_queued_file.hpp>
 
@@ -24,17 +31,71 @@ namespace foxxll {
 
 //! Implementation of file based on other files, dynamically allocate one file per block.
 //! Allows for dynamic disk space consumption.
+//!
+//! The files of the most recently used blocks are kept open in a bounded LRU
+//! cache. If opened with file::PREALLOC, a background thread keeps a few spare
+//! block files created and sized, which are renamed to blocks without a file
+//! on their first write.
 template <class base_file_type>
 class fileperblock_file : public disk_queued_file
 {
     constexpr static bool debug = false;
 
+public:
+    //! default number of block files kept open
+    static constexpr size_t default_max_open_files = 64;
+
+    //! number of spare block files prepared with file::PREALLOC
+    static constexpr size_t spare_files = 4;
+
 private:
+    using base_file_ptr = tlx::counting_ptr<base_file_type>;
+
     std::string filename_prefix_;
     int mode_;
     offset_type current_size_;
     tlx::counting_ptr<base_file_type> lock_file_;
 
+    //! an open block file
+    struct open_file
+    {
+        offset_type offset;
+        base_file_ptr file;
+        //! size the file was set to
+        size_type size;
+    };
+    using lru_type = std::list<open_file>;
+
+    //! maximum number of cached open block files, 0 = no caching
+    const size_t max_open_files_;
+    //! protects the cache and the spare files
+    std::mutex mutex_;
+    //! open block files, most recently used first
+    lru_type lru_;
+    std::unordered_map<offset_type, typename lru_type::iterator> open_files_;
+    uint64_t hits_ = 0, misses_ = 0;
+
+    //! spare block files as pairs (path, file)
+    std::vector<std::pair<std::string, base_file_ptr> > spares_;
+    //! size of the spare files, taken from the first written block
+    size_type spare_size_ = 0;
+    size_t spare_counter_ = 0;
+    bool stop_ = false;
+    //! signaled when spare files are needed
+    std::condition_variable spare_cv_;
+    std::thread spare_thread_;
+
+    //! main loop of the thread preparing spare files
+    void prepare_spares();
+
+    //! returns the open file of a block, from the cache, a spare file or by
+    //! opening it, and sets its size
+    base_file_ptr open_block(offset_type offset, size_type bytes,
+                             request::read_or_write op);
+
+    //! drops the cached file of a block, expects the mutex_ to be locked
+    void close_block(offset_type offset);
+
 protected:
     //! Constructs a file name for a given block.
     std::string filename_for_block(offset_type offset);
@@ -43,18 +104,26 @@ public:
     //! Constructs file object.
     //! param filename_prefix_  filename prefix, numbering will be appended to it
     //! param mode_ open mode_, see \c file::open_modes
+    //! param max_open_files number of block files kept open, 0 = open and
+    //! close the block file on each request
     fileperblock_file(
         const std::string& filename_prefix,
         int mode,
         int queue_id = DEFAULT_QUEUE,
         int allocator_id = NO_ALLOCATOR,
-        unsigned int device_id = DEFAULT_DEVICE_ID);
+        unsigned int device_id = DEFAULT_DEVICE_ID,
+        size_t max_open_files = default_max_open_files);
 
     virtual ~fileperblock_file();
 
     void serve(void* buffer, offset_type offset, size_type bytes,
                request::read_or_write op) final;
 
+    //! Copies a block by copying its block file, which the base file clones
+    //! or copies inside the kernel where supported.
+    void copy(offset_type offset, file* dst, offset_type dst_offset,
+              size_type bytes) final;
+
     //! Changes the size of the file.
     //! \param new_size value of the new file size
     virtual void set_size(offset_type new_size) { current_size_ = new_size; }
@@ -73,6 +142,20 @@ public:
     virtual void export_files(offset_type offset, offset_type length, std::string filename);
 
     const char * io_type() const final;
+
+    //! \name Statistics
+    //! \{
+
+    //! number of block files currently kept open
+    size_t open_files();
+
+    //! number of requests served with a cached open block file
+    uint64_t cache_hits();
+
+    //! number of requests which opened their block file
+    uint64_t cache_misses();
+
+    //! \}
 };
 
 //! \}
@@ -0,0 +1,105 @@
+/***************************************************************************
+ *  foxxll/io/io_throttle.cpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+#include <foxxll/common/timer.hpp>
+#include <foxxll/io/io_throttle.hpp>
+
+namespace foxxll {
+
+constexpr double io_throttle::burst_time;
+
+void io_throttle::bucket::refill(double dt)
+{
+    if (rate == 0)
+        return;
+    tokens = std::min(tokens + dt * rate, std::max(rate * burst_time, 1.0));
+}
+
+double io_throttle::bucket::take(double amount)
+{
+    if (rate == 0)
+        return 0;
+    tokens -= amount;
+    return tokens < 0 ? -tokens / rate : 0;
+}
+
+void io_throttle::set_limits(double bytes_per_sec, double ops_per_sec)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    const double now = timestamp();
+    bytes_.refill(now - last_);
+    ops_.refill(now - last_);
+    last_ = now;
+
+    bytes_.rate = std::max(bytes_per_sec, 0.0);
+    ops_.rate = std::max(ops_per_sec, 0.0);
+    enabled_.store(bytes_.rate != 0 || ops_.rate != 0,
+                   std::memory_order_relaxed);
+
+    // do not hand out a burst saved up under the old limits
+    bytes_.refill(0);
+    ops_.refill(0);
+}
+
+double io_throttle::bytes_per_sec() const
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return bytes_.rate;
+}
+
+double io_throttle::ops_per_sec() const
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return ops_.rate;
+}
+
+bool io_throttle::enabled() const
+{
+    return enabled_.load(std::memory_order_relaxed);
+}
+
+double io_throttle::acquire(size_t bytes)
+{
+    // unthrottled disks do not contend on the mutex
+    if (!enabled_.load(std::memory_order_relaxed))
+        return 0;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (bytes_.rate == 0 && ops_.rate == 0)
+        return 0;
+
+    const double now = timestamp();
+    bytes_.refill(now - last_);
+    ops_.refill(now - last_);
+    last_ = now;
+
+    const double delay = std::max(
+        bytes_.take(static_cast<double>(bytes)), ops_.take(1.0));
+    lock.unlock();
+
+    if (delay <= 0)
+        return 0;
+
+    std::this_thread::sleep_for(std::chrono::duration<double>(delay));
+    return delay;
+}
+
+} // namespace foxxll
+
+/**************************************************************************/
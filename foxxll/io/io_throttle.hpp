@@ -0,0 +1,96 @@
+/***************************************************************************
+ *  foxxll/io/io_throttle.hpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef FOXXLL_IO_IO_THROTTLE_HEADER
+#define FOXXLL_IO_IO_THROTTLE_HEADER
+
+#include <atomic>
+#include <cstddef>
+#include <mutex>
+
+namespace foxxll {
+
+//! \addtogroup foxxll_reqlayer
+//! \{
+
+/*!
+ * Rate limiter for the requests of a disk queue, consisting of two token
+ * buckets: one for bytes per second and one for I/O operations per second.
+ *
+ * A request takes its tokens immediately, even if this drives a bucket into
+ * debt, and then sleeps until the debt is paid back. Thus requests larger
+ * than the burst size pass, and concurrent workers are served in the order in
+ * which they arrived. Unused tokens accumulate up to burst_time seconds worth
+ * of the rate.
+ */
+class io_throttle
+{
+public:
+    //! seconds of unused rate which may be saved up for bursts
+    static constexpr double burst_time = 0.1;
+
+    io_throttle() = default;
+
+    //! non-copyable: delete copy-constructor
+    io_throttle(const io_throttle&) = delete;
+    //! non-copyable: delete assignment operator
+    io_throttle& operator = (const io_throttle&) = delete;
+
+    //! Sets the limits, 0 disables the respective limit. Can be called while
+    //! requests are being served.
+    void set_limits(double bytes_per_sec, double ops_per_sec);
+
+    //! Returns the current bandwidth limit in bytes per second, 0 = none.
+    double bytes_per_sec() const;
+
+    //! Returns the current limit of I/O operations per second, 0 = none.
+    double ops_per_sec() const;
+
+    //! Returns whether any limit is set.
+    bool enabled() const;
+
+    //! Takes the tokens for one request of the given size and sleeps until
+    //! the limits allow it to be issued.
+    //! \return seconds spent sleeping
+    double acquire(size_t bytes);
+
+private:
+    //! one token bucket
+    struct bucket
+    {
+        double rate = 0;
+        double tokens = 0;
+
+        //! add tokens for dt seconds, up to the burst size
+        void refill(double dt);
+        //! take tokens and return the seconds until the debt is paid back
+        double take(double amount);
+    };
+
+    mutable std::mutex mutex_;
+
+    //! whether any limit is set, read without the mutex_ by acquire()
+    std::atomic<bool> enabled_ { false };
+
+    bucket bytes_, ops_;
+
+    //! time of the last refill
+    double last_ = 0;
+};
+
+//! \}
+
+} // namespace foxxll
+
+#endif // !FOXXLL_IO_IO_THROTTLE_HEADER
+
+/**************************************************************************/
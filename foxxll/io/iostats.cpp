@@ -38,7 +38,12 @@ file_stats::file_stats(unsigned int device_id)
       read_bytes_(0), write_bytes_(0),
       read_time_(0.0), write_time_(0.0),
       p_begin_read_(0.0), p_begin_write_(0.0),
-      acc_reads_(0), acc_writes_(0)
+      acc_reads_(0), acc_writes_(0),
+      throttle_count_(0), throttle_time_(0.0),
+      poll_count_(0), poll_hits_(0), poll_time_(0.0),
+      drop_count_(0), drop_bytes_(0),
+      alloc_extents_(0), alloc_splits_(0),
+      free_bytes_(0), free_regions_(0), largest_free_region_(0)
 { }
 
 void file_stats::write_started(const size_t size, double now)
@@ -147,6 +152,51 @@ void file_stats::read_op_finished(const size_t size, double duration)
     read_bytes_ += size;
 }
 
+void file_stats::throttled(double duration)
+{
+    std::unique_lock<std::mutex> throttle_lock(throttle_mutex_);
+
+    ++throttle_count_;
+    throttle_time_ += duration;
+}
+
+void file_stats::polled(double duration, bool hit)
+{
+    std::unique_lock<std::mutex> poll_lock(poll_mutex_);
+
+    ++poll_count_;
+    if (hit)
+        ++poll_hits_;
+    poll_time_ += duration;
+}
+
+void file_stats::read_dropped(const size_t size)
+{
+    std::unique_lock<std::mutex> drop_lock(drop_mutex_);
+
+    ++drop_count_;
+    drop_bytes_ += size;
+}
+
+void file_stats::blocks_allocated(unsigned extents, unsigned splits)
+{
+    std::unique_lock<std::mutex> alloc_lock(alloc_mutex_);
+
+    alloc_extents_ += extents;
+    alloc_splits_ += splits;
+}
+
+void file_stats::free_space_changed(
+    external_size_type free_bytes, unsigned regions,
+    external_size_type largest_region)
+{
+    std::unique_lock<std::mutex> alloc_lock(alloc_mutex_);
+
+    free_bytes_ = free_bytes;
+    free_regions_ = regions;
+    largest_free_region_ = largest_region;
+}
+
 /******************************************************************************/
 // file_stats_data
 
@@ -166,6 +216,18 @@ file_stats_data file_stats_data::operator + (const file_stats_data& a) const
     fsd.write_bytes_ = write_bytes_ + a.write_bytes_;
     fsd.read_time_ = read_time_ + a.read_time_;
     fsd.write_time_ = write_time_ + a.write_time_;
+    fsd.throttle_count_ = throttle_count_ + a.throttle_count_;
+    fsd.throttle_time_ = throttle_time_ + a.throttle_time_;
+    fsd.poll_count_ = poll_count_ + a.poll_count_;
+    fsd.poll_hits_ = poll_hits_ + a.poll_hits_;
+    fsd.poll_time_ = poll_time_ + a.poll_time_;
+    fsd.drop_count_ = drop_count_ + a.drop_count_;
+    fsd.drop_bytes_ = drop_bytes_ + a.drop_bytes_;
+    fsd.alloc_extents_ = alloc_extents_ + a.alloc_extents_;
+    fsd.alloc_splits_ = alloc_splits_ + a.alloc_splits_;
+    fsd.free_bytes_ = free_bytes_;
+    fsd.free_regions_ = free_regions_;
+    fsd.largest_free_region_ = largest_free_region_;
 
     return fsd;
 }
@@ -186,6 +248,18 @@ file_stats_data file_stats_data::operator - (const file_stats_data& a) const
     fsd.write_bytes_ = write_bytes_ - a.write_bytes_;
     fsd.read_time_ = read_time_ - a.read_time_;
     fsd.write_time_ = write_time_ - a.write_time_;
+    fsd.throttle_count_ = throttle_count_ - a.throttle_count_;
+    fsd.throttle_time_ = throttle_time_ - a.throttle_time_;
+    fsd.poll_count_ = poll_count_ - a.poll_count_;
+    fsd.poll_hits_ = poll_hits_ - a.poll_hits_;
+    fsd.poll_time_ = poll_time_ - a.poll_time_;
+    fsd.drop_count_ = drop_count_ - a.drop_count_;
+    fsd.drop_bytes_ = drop_bytes_ - a.drop_bytes_;
+    fsd.alloc_extents_ = alloc_extents_ - a.alloc_extents_;
+    fsd.alloc_splits_ = alloc_splits_ - a.alloc_splits_;
+    fsd.free_bytes_ = free_bytes_;
+    fsd.free_regions_ = free_regions_;
+    fsd.largest_free_region_ = largest_free_region_;
 
     return fsd;
 }
@@ -356,11 +430,10 @@ file_stats* stats::create_file_stats(unsigned int device_id)
                 return fs.get_device_id() < id;
             }
         );
-    if (it != file_stats_list_.end() && it->get_device_id())
+    if (it != file_stats_list_.end() && it->get_device_id() == device_id)
         return &*it;
 
-    file_stats_list_.emplace(it, /* construction: */ device_id);
-    return &file_stats_list_.back();
+    return &*file_stats_list_.emplace(it, /* construction: */ device_id);
 }
 
 std::vector<file_stats_data> stats::deepcopy_file_stats_data_list() const
@@ -660,6 +733,79 @@ double stats_data::get_wait_write_time() const
     return t_wait_write_;
 }
 
+unsigned stats_data::get_throttle_count() const
+{
+    return fetch_sum<unsigned>(
+        [](const file_stats_data& fsd) { return fsd.get_throttle_count(); });
+}
+
+double stats_data::get_throttle_time() const
+{
+    return fetch_sum<double>(
+        [](const file_stats_data& fsd) { return fsd.get_throttle_time(); });
+}
+
+unsigned stats_data::get_poll_count() const
+{
+    return fetch_sum<unsigned>(
+        [](const file_stats_data& fsd) { return fsd.get_poll_count(); });
+}
+
+unsigned stats_data::get_poll_hits() const
+{
+    return fetch_sum<unsigned>(
+        [](const file_stats_data& fsd) { return fsd.get_poll_hits(); });
+}
+
+double stats_data::get_poll_time() const
+{
+    return fetch_sum<double>(
+        [](const file_stats_data& fsd) { return fsd.get_poll_time(); });
+}
+
+unsigned stats_data::get_drop_count() const
+{
+    return fetch_sum<unsigned>(
+        [](const file_stats_data& fsd) { return fsd.get_drop_count(); });
+}
+
+external_size_type stats_data::get_drop_bytes() const
+{
+    return fetch_sum<external_size_type>(
+        [](const file_stats_data& fsd) { return fsd.get_drop_bytes(); });
+}
+
+unsigned stats_data::get_alloc_extents() const
+{
+    return fetch_sum<unsigned>(
+        [](const file_stats_data& fsd) { return fsd.get_alloc_extents(); });
+}
+
+unsigned stats_data::get_alloc_splits() const
+{
+    return fetch_sum<unsigned>(
+        [](const file_stats_data& fsd) { return fsd.get_alloc_splits(); });
+}
+
+unsigned stats_data::get_free_regions() const
+{
+    return fetch_sum<unsigned>(
+        [](const file_stats_data& fsd) { return fsd.get_free_regions(); });
+}
+
+double stats_data::get_free_space_fragmentation() const
+{
+    const external_size_type free_bytes = fetch_sum<external_size_type>(
+        [](const file_stats_data& fsd) { return fsd.get_free_bytes(); });
+    const external_size_type largest = fetch_sum<external_size_type>(
+        [](const file_stats_data& fsd) {
+            return fsd.get_largest_free_region();
+        });
+    if (free_bytes == 0)
+        return 0.0;
+    return 1.0 - static_cast<double>(largest) / static_cast<double>(free_bytes);
+}
+
 void stats_data::to_ostream(std::ostream& o, const std::string line_prefix) const
 {
     constexpr double one_mib = 1024.0 * 1024;
@@ -755,6 +901,34 @@ void stats_data::to_ostream(std::ostream& o, const std::string line_prefix) cons
         o << " I/O wait4write time                        : "
           << get_wait_write_time() << " s\n" << line_prefix;
 #endif
+    if (get_throttle_count() != 0) {
+        o << " requests delayed by rate limits            : "
+          << get_throttle_count() << "\n" << line_prefix
+          << " time spent throttled (all requests)        : "
+          << get_throttle_time() << " s\n" << line_prefix;
+    }
+    if (get_poll_count() != 0) {
+        o << " waits spinning (completed while spinning)  : "
+          << get_poll_count() << " (" << get_poll_hits() << ")\n"
+          << line_prefix
+          << " time spent spinning (all waits)            : "
+          << get_poll_time() << " s\n" << line_prefix;
+    }
+    if (get_drop_count() != 0) {
+        o << " expired prefetches dropped                 : "
+          << get_drop_count() << " ("
+          << static_cast<double>(get_drop_bytes()) / one_mib << " MiB)\n"
+          << line_prefix;
+    }
+    if (get_alloc_extents() != 0) {
+        o << " allocated extents (split allocations)      : "
+          << get_alloc_extents() << " (" << get_alloc_splits() << ")\n"
+          << line_prefix
+          << " free regions (fragmentation)               : "
+          << get_free_regions() << " ("
+          << get_free_space_fragmentation() * 100.0 << " %)\n"
+          << line_prefix;
+    }
     o << " Time since the last reset                  : "
       << get_elapsed_time() << " s";
 
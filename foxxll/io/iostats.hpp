@@ -59,7 +59,34 @@ class file_stats
     //! number of requests, participating in parallel operation
     int acc_reads_, acc_writes_;
 
-    std::mutex read_mutex_, write_mutex_;
+    //! number of requests delayed by the queue's rate limits
+    unsigned throttle_count_;
+    //! seconds requests were delayed by the queue's rate limits
+    double throttle_time_;
+
+    //! number of waits which spun for the completion, and how many of them
+    //! saw it within the spin budget
+    unsigned poll_count_, poll_hits_;
+    //! seconds spent spinning
+    double poll_time_;
+
+    //! number of expired prefetch reads dropped by the queue
+    unsigned drop_count_;
+    //! number of bytes of the dropped reads
+    external_size_type drop_bytes_;
+
+    //! number of contiguous extents blocks were allocated in
+    unsigned alloc_extents_;
+    //! number of extents which had to be split for lack of contiguous space
+    unsigned alloc_splits_;
+    //! free space of the file's block allocator: bytes, number of free
+    //! regions, and size of the largest free region
+    external_size_type free_bytes_;
+    unsigned free_regions_;
+    external_size_type largest_free_region_;
+
+    std::mutex read_mutex_, write_mutex_, throttle_mutex_, drop_mutex_;
+    std::mutex poll_mutex_, alloc_mutex_;
 
 public:
     //! construct zero initialized
@@ -233,6 +260,85 @@ public:
         return write_time_;
     }
 
+    //! Returns the number of requests delayed by rate limits.
+    //! \return number of throttled requests
+    unsigned get_throttle_count() const
+    {
+        return throttle_count_;
+    }
+
+    //! Returns the time requests were delayed by rate limits.
+    //! \return seconds spent throttled
+    double get_throttle_time() const
+    {
+        return throttle_time_;
+    }
+
+    //! Returns the number of waits which spun for the completion.
+    unsigned get_poll_count() const
+    {
+        return poll_count_;
+    }
+
+    //! Returns the number of spinning waits which saw the completion within
+    //! the spin budget.
+    unsigned get_poll_hits() const
+    {
+        return poll_hits_;
+    }
+
+    //! Returns the CPU time spent spinning for completions.
+    //! \return seconds spent spinning
+    double get_poll_time() const
+    {
+        return poll_time_;
+    }
+
+    //! Returns the number of expired prefetch reads which were dropped
+    //! before being issued.
+    unsigned get_drop_count() const
+    {
+        return drop_count_;
+    }
+
+    //! Returns the number of bytes of dropped prefetch reads.
+    external_size_type get_drop_bytes() const
+    {
+        return drop_bytes_;
+    }
+
+    //! Returns the number of contiguous extents allocated blocks were placed
+    //! in.
+    unsigned get_alloc_extents() const
+    {
+        return alloc_extents_;
+    }
+
+    //! Returns the number of allocations which were split into several
+    //! extents because no contiguous free region was large enough.
+    unsigned get_alloc_splits() const
+    {
+        return alloc_splits_;
+    }
+
+    //! Returns the free bytes of the block allocator.
+    external_size_type get_free_bytes() const
+    {
+        return free_bytes_;
+    }
+
+    //! Returns the number of free regions of the block allocator.
+    unsigned get_free_regions() const
+    {
+        return free_regions_;
+    }
+
+    //! Returns the size of the largest free region of the block allocator.
+    external_size_type get_largest_free_region() const
+    {
+        return largest_free_region_;
+    }
+
     // for library use
     void write_started(const size_t size_, double now = 0.0);
     void write_canceled(const size_t size_);
@@ -243,6 +349,14 @@ public:
     void read_canceled(const size_t size_);
     void read_finished();
     void read_op_finished(const size_t size_, double duration);
+
+    void throttled(double duration);
+    void polled(double duration, bool hit);
+    void read_dropped(const size_t size_);
+
+    void blocks_allocated(unsigned extents, unsigned splits);
+    void free_space_changed(external_size_type free_bytes, unsigned regions,
+                            external_size_type largest_region);
 };
 
 class file_stats_data
@@ -255,13 +369,33 @@ class file_stats_data
     external_size_type read_bytes_, write_bytes_;
     //! seconds spent in operations
     double read_time_, write_time_;
+    //! requests delayed by rate limits and seconds of delay
+    unsigned throttle_count_;
+    double throttle_time_;
+    //! spinning waits, those completed while spinning, and seconds spun
+    unsigned poll_count_, poll_hits_;
+    double poll_time_;
+    //! dropped expired prefetch reads and their bytes
+    unsigned drop_count_;
+    external_size_type drop_bytes_;
+    //! allocated extents and split allocations
+    unsigned alloc_extents_, alloc_splits_;
+    //! free space at the time of the snapshot
+    external_size_type free_bytes_;
+    unsigned free_regions_;
+    external_size_type largest_free_region_;
 
 public:
     file_stats_data()
         : device_id_(std::numeric_limits<unsigned>::max()),
           read_count_(0), write_count_(0),
           read_bytes_(0), write_bytes_(0),
-          read_time_(0.0), write_time_(0.0)
+          read_time_(0.0), write_time_(0.0),
+          throttle_count_(0), throttle_time_(0.0),
+          poll_count_(0), poll_hits_(0), poll_time_(0.0),
+          drop_count_(0), drop_bytes_(0),
+          alloc_extents_(0), alloc_splits_(0),
+          free_bytes_(0), free_regions_(0), largest_free_region_(0)
     { }
 
     //! construct file_stats_data by taking current values from file_stats
@@ -272,9 +406,23 @@ public:
           read_bytes_(fs.get_read_bytes()),
           write_bytes_(fs.get_write_bytes()),
           read_time_(fs.get_read_time()),
-          write_time_(fs.get_write_time())
+          write_time_(fs.get_write_time()),
+          throttle_count_(fs.get_throttle_count()),
+          throttle_time_(fs.get_throttle_time()),
+          poll_count_(fs.get_poll_count()),
+          poll_hits_(fs.get_poll_hits()),
+          poll_time_(fs.get_poll_time()),
+          drop_count_(fs.get_drop_count()),
+          drop_bytes_(fs.get_drop_bytes()),
+          alloc_extents_(fs.get_alloc_extents()),
+          alloc_splits_(fs.get_alloc_splits()),
+          free_bytes_(fs.get_free_bytes()),
+          free_regions_(fs.get_free_regions()),
+          largest_free_region_(fs.get_largest_free_region())
     { }
 
+    //! Adds or subtracts the counters, the free space is that of the left
+    //! operand.
     file_stats_data operator + (const file_stats_data& a) const;
     file_stats_data operator - (const file_stats_data& a) const;
 
@@ -312,6 +460,66 @@ public:
     {
         return write_time_;
     }
+
+    unsigned get_throttle_count() const
+    {
+        return throttle_count_;
+    }
+
+    double get_throttle_time() const
+    {
+        return throttle_time_;
+    }
+
+    unsigned get_poll_count() const
+    {
+        return poll_count_;
+    }
+
+    unsigned get_poll_hits() const
+    {
+        return poll_hits_;
+    }
+
+    double get_poll_time() const
+    {
+        return poll_time_;
+    }
+
+    unsigned get_drop_count() const
+    {
+        return drop_count_;
+    }
+
+    external_size_type get_drop_bytes() const
+    {
+        return drop_bytes_;
+    }
+
+    unsigned get_alloc_extents() const
+    {
+        return alloc_extents_;
+    }
+
+    unsigned get_alloc_splits() const
+    {
+        return alloc_splits_;
+    }
+
+    external_size_type get_free_bytes() const
+    {
+        return free_bytes_;
+    }
+
+    unsigned get_free_regions() const
+    {
+        return free_regions_;
+    }
+
+    external_size_type get_largest_free_region() const
+    {
+        return largest_free_region_;
+    }
 };
 
 //! Collects various I/O statistics.
@@ -630,6 +838,46 @@ public:
 
     double get_wait_write_time() const;
 
+    //! Returns the number of requests delayed by rate limits.
+    unsigned get_throttle_count() const;
+
+    //! Time requests were delayed by the disk queues' rate limits, summed
+    //! over all requests.
+    //! \return seconds spent throttled
+    double get_throttle_time() const;
+
+    //! Returns the number of waits which spun for the completion.
+    unsigned get_poll_count() const;
+
+    //! Returns the number of spinning waits which saw the completion within
+    //! the spin budget.
+    unsigned get_poll_hits() const;
+
+    //! CPU time spent spinning for completions, summed over all waits.
+    //! \return seconds spent spinning
+    double get_poll_time() const;
+
+    //! Returns the number of expired prefetch reads dropped by the queues.
+    unsigned get_drop_count() const;
+
+    //! Returns the number of bytes of dropped prefetch reads.
+    external_size_type get_drop_bytes() const;
+
+    //! Returns the number of contiguous extents blocks were allocated in.
+    unsigned get_alloc_extents() const;
+
+    //! Returns the number of allocations which had to be split.
+    unsigned get_alloc_splits() const;
+
+    //! Returns the number of free regions over all files.
+    unsigned get_free_regions() const;
+
+    //! Returns the free space fragmentation: one minus the ratio of the
+    //! largest free region to all free bytes, averaged over the files
+    //! weighted by their free bytes. 0 if each file's free space is
+    //! contiguous.
+    double get_free_space_fragmentation() const;
+
     void to_ostream(std::ostream& o, const std::string line_prefix = "") const;
 
     friend std::ostream& operator << (std::ostream& o, const stats_data& s)
@@ -14,17 +14,23 @@
 
 #if FOXXLL_HAVE_LINUXAIO_FILE
 
+#include <foxxll/io/copy_request.hpp>
 #include <foxxll/io/disk_queues.hpp>
 #include <foxxll/io/linuxaio_request.hpp>
+#include <foxxll/io/serving_request.hpp>
 
 namespace foxxll {
 
 request_ptr linuxaio_file::aread(
     void* buffer, offset_type offset, size_type bytes,
-    const completion_handler& on_complete)
+    const completion_handler& on_complete, request::priority_class priority)
 {
+    if (_is_unaligned(buffer, offset, bytes))
+        return aserve_unaligned(
+            buffer, offset, bytes, request::READ, on_complete, priority);
+
     request_ptr req = tlx::make_counting<linuxaio_request>(
-            on_complete, this, buffer, offset, bytes, request::READ
+            on_complete, this, buffer, offset, bytes, request::READ, priority
         );
 
     disk_queues::get_instance()->add_request(req, get_queue_id());
@@ -34,10 +40,14 @@ request_ptr linuxaio_file::aread(
 
 request_ptr linuxaio_file::awrite(
     void* buffer, offset_type offset, size_type bytes,
-    const completion_handler& on_complete)
+    const completion_handler& on_complete, request::priority_class priority)
 {
+    if (_is_unaligned(buffer, offset, bytes))
+        return aserve_unaligned(
+            buffer, offset, bytes, request::WRITE, on_complete, priority);
+
     request_ptr req = tlx::make_counting<linuxaio_request>(
-            on_complete, this, buffer, offset, bytes, request::WRITE
+            on_complete, this, buffer, offset, bytes, request::WRITE, priority
         );
 
     disk_queues::get_instance()->add_request(req, get_queue_id());
@@ -45,9 +55,43 @@ request_ptr linuxaio_file::awrite(
     return req;
 }
 
+request_ptr linuxaio_file::aserve_unaligned(
+    void* buffer, offset_type offset, size_type bytes,
+    request::read_or_write op,
+    const completion_handler& on_complete, request::priority_class priority)
+{
+    // the kernel rejects unaligned direct I/O, serve it synchronously
+    const int queue_id = DEFAULT_SERVING_QUEUE;
+    request_ptr req = tlx::make_counting<serving_request>(
+            on_complete, this, buffer, offset, bytes, op, queue_id, priority
+        );
+
+    disk_queues::get_instance()->add_request(req, queue_id);
+
+    return req;
+}
+
+request_ptr linuxaio_file::acopy(
+    offset_type offset, file* dst, offset_type dst_offset, size_type bytes,
+    const completion_handler& on_complete, request::priority_class priority)
+{
+    const int queue_id = DEFAULT_SERVING_QUEUE;
+    request_ptr req = tlx::make_counting<copy_request>(
+            on_complete, this, offset, dst, dst_offset, bytes,
+            queue_id, priority
+        );
+
+    disk_queues::get_instance()->add_request(req, queue_id);
+
+    return req;
+}
+
 void linuxaio_file::serve(void* buffer, offset_type offset, size_type bytes,
                           request::read_or_write op)
 {
+    if (_is_unaligned(buffer, offset, bytes))
+        return _serve_unaligned(buffer, offset, bytes, op);
+
     // req need not be an linuxaio_request
     if (op == request::READ)
         aread(buffer, offset, bytes)->wait();
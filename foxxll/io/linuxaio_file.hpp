@@ -32,13 +32,22 @@ class linuxaio_queue;
 //! \{
 
 //! Implementation of \c file based on the Linux kernel interface for
-//! asynchronous I/O
+//! asynchronous I/O. Requests violating the alignment of direct I/O are
+//! served synchronously through bounce buffers by the DEFAULT_SERVING_QUEUE.
 class linuxaio_file final : public ufs_file_base, public disk_queued_file
 {
     friend class linuxaio_request;
 
 private:
     int desired_queue_length_;
+    linuxaio_queue::completion_mode completion_mode_;
+
+    //! post an unaligned request to the DEFAULT_SERVING_QUEUE
+    request_ptr aserve_unaligned(
+        void* buffer, offset_type offset, size_type bytes,
+        request::read_or_write op,
+        const completion_handler& on_complete,
+        request::priority_class priority);
 
 public:
     //! Constructs file object
@@ -48,16 +57,20 @@ public:
     //! \param allocator_id linked disk_allocator
     //! \param device_id physical device identifier
     //! \param desired_queue_length queue length requested from kernel
+    //! \param completion_mode how the queue collects completion events
     linuxaio_file(
         const std::string& filename, int mode,
         int queue_id = DEFAULT_LINUXAIO_QUEUE,
         int allocator_id = NO_ALLOCATOR,
         unsigned int device_id = DEFAULT_DEVICE_ID,
-        int desired_queue_length = 0)
+        int desired_queue_length = 0,
+        linuxaio_queue::completion_mode completion_mode =
+            linuxaio_queue::GETEVENTS_COMPLETION)
         : file(device_id),
           ufs_file_base(filename, mode),
           disk_queued_file(queue_id, allocator_id),
-          desired_queue_length_(desired_queue_length)
+          desired_queue_length_(desired_queue_length),
+          completion_mode_(completion_mode)
     { }
 
     void serve(void* buffer, offset_type offset, size_type bytes,
@@ -65,16 +78,29 @@ public:
 
     request_ptr aread(
         void* buffer, offset_type pos, size_type bytes,
-        const completion_handler& on_cmpl = completion_handler()) final;
+        const completion_handler& on_cmpl = completion_handler(),
+        request::priority_class priority = request::DEMAND) final;
 
     request_ptr awrite(
         void* buffer, offset_type pos, size_type bytes,
-        const completion_handler& on_cmpl = completion_handler()) final;
+        const completion_handler& on_cmpl = completion_handler(),
+        request::priority_class priority = request::DEMAND) final;
+
+    //! Copies are served by the DEFAULT_SERVING_QUEUE, since the
+    //! linuxaio_queue only submits reads and writes to the kernel.
+    request_ptr acopy(
+        offset_type offset, file* dst, offset_type dst_offset, size_type bytes,
+        const completion_handler& on_cmpl = completion_handler(),
+        request::priority_class priority = request::DEMAND) final;
 
     const char * io_type() const final;
 
     int get_desired_queue_length() const
     { return desired_queue_length_; }
+
+    //! completion mode of the queue, if it is created for this file
+    linuxaio_queue::completion_mode get_completion_mode() const
+    { return completion_mode_; }
 };
 
 //! \}
@@ -16,10 +16,13 @@
 
 #if FOXXLL_HAVE_LINUXAIO_FILE
 
+#include <sys/eventfd.h>
 #include <sys/syscall.h>
 #include <unistd.h>
 
 #include <algorithm>
+#include <cstdint>
+#include <thread>
 
 #include <tlx/die.hpp>
 #include <tlx/logger.hpp>
@@ -30,8 +33,30 @@
 
 namespace foxxll {
 
-linuxaio_queue::linuxaio_queue(int desired_queue_length)
-    : num_waiting_requests_(0), num_free_events_(0), num_posted_requests_(0),
+namespace {
+
+//! Header of the completion ring which the kernel maps at the address of the
+//! aio context (struct aio_ring in fs/aio.c), followed by nr io_events. The
+//! kernel appends at tail, the consumers advance head.
+struct aio_ring
+{
+    unsigned id;
+    unsigned nr;
+    unsigned head;
+    unsigned tail;
+    unsigned magic;
+    unsigned compat_features;
+    unsigned incompat_features;
+    unsigned header_length;
+};
+
+constexpr unsigned aio_ring_magic = 0xa10a10a1;
+
+} // namespace
+
+linuxaio_queue::linuxaio_queue(int desired_queue_length, completion_mode mode)
+    : completion_mode_(mode), eventfd_(-1),
+      num_waiting_requests_(0), num_free_events_(0), num_posted_requests_(0),
       post_thread_state_(NOT_RUNNING), wait_thread_state_(NOT_RUNNING)
 {
     if (desired_queue_length == 0) {
@@ -59,6 +84,26 @@ linuxaio_queue::linuxaio_queue(int desired_queue_length)
 
     num_free_events_.signal(max_events_);
 
+    if (completion_mode_ != GETEVENTS_COMPLETION)
+    {
+        const aio_ring* ring = reinterpret_cast<const aio_ring*>(context_);
+        if (ring->magic != aio_ring_magic || ring->incompat_features != 0 ||
+            ring->header_length != sizeof(aio_ring))
+        {
+            LOG1 << "linuxaio_queue: unknown completion ring layout, "
+                "using io_getevents()";
+            completion_mode_ = GETEVENTS_COMPLETION;
+        }
+    }
+
+    if (completion_mode_ == EVENTFD_COMPLETION &&
+        (eventfd_ = eventfd(0, EFD_CLOEXEC)) < 0)
+    {
+        FOXXLL_THROW_ERRNO(
+            io_error, "linuxaio_queue::linuxaio_queue eventfd()"
+        );
+    }
+
     LOG1 << "Set up an linuxaio queue with " << max_events_ << " entries.";
 
     start_thread(post_async, static_cast<void*>(this), post_thread_, post_thread_state_);
@@ -70,6 +115,8 @@ linuxaio_queue::~linuxaio_queue()
     stop_thread(post_thread_, post_thread_state_, num_waiting_requests_);
     stop_thread(wait_thread_, wait_thread_state_, num_posted_requests_);
     syscall(SYS_io_destroy, context_);
+    if (eventfd_ >= 0)
+        ::close(eventfd_);
 }
 
 void linuxaio_queue::add_request(request_ptr& req)
@@ -98,16 +145,11 @@ bool linuxaio_queue::cancel_request(request_ptr& req)
     if (!areq)
         die("Non-LinuxAIO request submitted to LinuxAIO queue.");
 
-    queue_type::iterator pos;
     {
         std::unique_lock<std::mutex> lock(waiting_mtx_);
 
-        pos = std::find(
-                waiting_requests_.begin(), waiting_requests_.end(), req
-            );
-        if (pos != waiting_requests_.end())
+        if (waiting_requests_.erase(req))
         {
-            waiting_requests_.erase(pos);
             lock.unlock();
 
             // request is canceled, but was not yet posted.
@@ -132,12 +174,26 @@ bool linuxaio_queue::cancel_request(request_ptr& req)
 
         num_free_events_.signal();
         num_posted_requests_.wait(); // will never block
+        notify_completed();
         return true;
     }
 
     return false;
 }
 
+bool linuxaio_queue::set_request_priority(
+    request_ptr& req, request::priority_class priority)
+{
+    std::unique_lock<std::mutex> lock(waiting_mtx_);
+    return waiting_requests_.set_priority(req, priority);
+}
+
+size_t linuxaio_queue::num_waiting_requests()
+{
+    std::unique_lock<std::mutex> lock(waiting_mtx_);
+    return waiting_requests_.size();
+}
+
 // internal routines, run by the posting thread
 void linuxaio_queue::post_requests()
 {
@@ -157,18 +213,40 @@ void linuxaio_queue::post_requests()
         std::unique_lock<std::mutex> lock(waiting_mtx_);
         if (!waiting_requests_.empty())
         {
-            req = waiting_requests_.front();
-            waiting_requests_.pop_front();
+            req = waiting_requests_.pop();
             lock.unlock();
 
+            if (req->dropped()) {
+                req->get_file()->get_file_stats()->read_dropped(req->bytes());
+                dynamic_cast<linuxaio_request*>(req.get())->completed(false, true);
+                continue;
+            }
+
+            throttle(req);
+
             num_free_events_.wait(); // might block because too many requests are posted
 
-            // polymorphic_downcast
-            while (!dynamic_cast<linuxaio_request*>(req.get())->post())
+            // events freed before the post cannot make room for it
+            uint64_t num_completed = num_completed_.load();
+
+            // polymorphic_downcast, add_request() only accepts linuxaio_requests
+            while (!static_cast<linuxaio_request*>(req.get())->post(this))
             {
                 // post failed, so first handle events to make queues (more)
                 // empty, then try again.
 
+                if (completion_mode_ != GETEVENTS_COMPLETION) {
+                    // the waiting thread is the only consumer of the ring,
+                    // sleep until it has handled another event
+                    std::unique_lock<std::mutex> completed_lock(completed_mtx_);
+                    completed_cv_.wait(
+                        completed_lock, [&]() {
+                            return num_completed_.load() != num_completed;
+                        });
+                    num_completed = num_completed_.load();
+                    continue;
+                }
+
                 // wait for at least one event to complete, no time limit
                 long num_events = syscall(
                         SYS_io_getevents, context_, 1, max_events_, events, nullptr
@@ -202,14 +280,49 @@ void linuxaio_queue::handle_events(io_event* events, long num_events, bool cance
 {
     for (int e = 0; e < num_events; ++e)
     {
-        request* r = reinterpret_cast<request*>(
+        linuxaio_request* r = reinterpret_cast<linuxaio_request*>(
                 static_cast<uintptr_t>(events[e].data));
+        if (!canceled && !r->event_completed(events[e].res, this)) {
+            // the remaining range was posted or queued again and holds its
+            // own reference
+            r->dec_reference();
+            continue;
+        }
         r->completed(canceled);
         // release counting_ptr reference, this may delete the request object
         r->dec_reference();
         num_free_events_.signal();
         num_posted_requests_.wait(); // will never block
     }
+
+    if (completion_mode_ != GETEVENTS_COMPLETION && num_events > 0)
+        notify_completed();
+}
+
+void linuxaio_queue::notify_completed()
+{
+    ++num_completed_;
+    // taking the lock orders the increment with a concurrent predicate check
+    std::unique_lock<std::mutex> lock(completed_mtx_);
+    lock.unlock();
+    completed_cv_.notify_one();
+}
+
+bool linuxaio_queue::requeue_request(request* req)
+{
+    if (post_thread_state_() != RUNNING)
+        return false;
+
+    request_ptr ptr(req);
+    std::unique_lock<std::mutex> lock(waiting_mtx_);
+    waiting_requests_.push_back(ptr);
+    lock.unlock();
+
+    // the request is waiting again, and frees its event
+    num_free_events_.signal();
+    num_posted_requests_.wait(); // will never block
+    num_waiting_requests_.signal();
+    return true;
 }
 
 // internal routines, run by the waiting thread
@@ -229,32 +342,78 @@ void linuxaio_queue::wait_requests()
             break;
 
         // wait for at least one of them to finish
-        long num_events;
-        while (1) {
-            num_events = syscall(
-                    SYS_io_getevents, context_, 1, max_events_, events, nullptr
-                );
+        long num_events = get_events(events);
 
-            if (num_events < 0) {
-                if (errno == EINTR) {
-                    // io_getevents may return prematurely in case a signal is received
-                    continue;
-                }
+        num_posted_requests_.signal(); // compensate for the one eaten prematurely above
+
+        handle_events(events, num_events, false);
+    }
+
+    delete[] events;
+}
+
+long linuxaio_queue::get_events(io_event* events)
+{
+    while (1) {
+        if (completion_mode_ != GETEVENTS_COMPLETION) {
+            long num_events = reap_ring(events);
+            if (num_events > 0)
+                return num_events;
+        }
 
+        if (completion_mode_ == EVENTFD_COMPLETION) {
+            // sleep until the next completion, the counter may also stem
+            // from events which were already reaped
+            uint64_t count;
+            if (::read(eventfd_, &count, sizeof(count)) < 0 && errno != EINTR) {
                 FOXXLL_THROW_ERRNO(
-                    io_error, "linuxaio_queue::wait_requests"
-                    " io_getevents() nr_events=" << max_events_
+                    io_error, "linuxaio_queue::get_events read(eventfd)"
                 );
             }
-            break;
+            continue;
         }
 
-        num_posted_requests_.signal(); // compensate for the one eaten prematurely above
+        long num_events = syscall(
+                SYS_io_getevents, context_, 1, max_events_, events, nullptr
+            );
 
-        handle_events(events, num_events, false);
+        if (num_events < 0) {
+            if (errno == EINTR) {
+                // io_getevents may return prematurely in case a signal is received
+                continue;
+            }
+
+            FOXXLL_THROW_ERRNO(
+                io_error, "linuxaio_queue::get_events"
+                " io_getevents() nr_events=" << max_events_
+            );
+        }
+        return num_events;
     }
+}
 
-    delete[] events;
+long linuxaio_queue::reap_ring(io_event* events)
+{
+    aio_ring* ring = reinterpret_cast<aio_ring*>(context_);
+    const io_event* ring_events = reinterpret_cast<const io_event*>(ring + 1);
+
+    // the kernel fills in an event before publishing it by advancing tail
+    const unsigned nr = ring->nr;
+    unsigned head = ring->head;
+    const unsigned tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+
+    long num_events = 0;
+    while (head != tail && num_events < max_events_)
+    {
+        events[num_events++] = ring_events[head];
+        head = (head + 1) % nr;
+    }
+
+    // hand the slots back to the kernel after copying the events out
+    if (num_events > 0)
+        __atomic_store_n(&ring->head, head, __ATOMIC_RELEASE);
+
+    return num_events;
 }
 
 void* linuxaio_queue::post_async(void* arg)
@@ -14,16 +14,18 @@
 #ifndef FOXXLL_IO_LINUXAIO_QUEUE_HEADER
 #define FOXXLL_IO_LINUXAIO_QUEUE_HEADER
 
-#include <foxxll/io/linuxaio_file.hpp>
+#include <foxxll/config.hpp>
 
 #if FOXXLL_HAVE_LINUXAIO_FILE
 
 #include <linux/aio_abi.h>
 
 #include <atomic>
+#include <condition_variable>
 #include <list>
 #include <mutex>
 
+#include <foxxll/io/qos_request_queue.hpp>
 #include <foxxll/io/request_queue_impl_worker.hpp>
 
 namespace foxxll {
@@ -42,20 +44,46 @@ class linuxaio_queue : public request_queue_impl_worker
 
     using self_type = linuxaio_queue;
 
+public:
+    //! How the waiting thread collects the completion events of the kernel.
+    enum completion_mode
+    {
+        //! sleep in io_getevents() for every batch of events
+        GETEVENTS_COMPLETION = 0,
+        //! read the events from the completion ring the kernel maps into the
+        //! process, without a system call or lock as long as events are
+        //! available, and sleep in io_getevents() only if it is empty
+        RING_COMPLETION = 1,
+        //! read the events from the completion ring, and sleep on an eventfd
+        //! which the kernel signals on each completion (IOCB_FLAG_RESFD)
+        EVENTFD_COMPLETION = 2
+    };
+
 private:
     //! OS context_
     aio_context_t context_;
 
-    //! storing linuxaio_request* would drop ownership
-    using queue_type = std::list<request_ptr>;
+    //! how completion events are collected
+    completion_mode completion_mode_;
+    //! eventfd signaled on completions in EVENTFD_COMPLETION mode, or -1
+    int eventfd_;
 
     // "waiting" request have submitted to this queue, but not yet to the OS,
-    // those are "posted"
+    // those are "posted". They are posted by weighted fair queuing over their
+    // priority classes. Storing linuxaio_request* would drop ownership.
     std::mutex waiting_mtx_;
-    queue_type waiting_requests_;
+    qos_request_queue waiting_requests_;
 
     //! max number of OS requests
     int max_events_;
+    //! number of partial transfers whose remaining range was posted again
+    std::atomic<uint64_t> num_resubmitted_ { 0 };
+    //! number of events freed by completions or cancellations, the posting
+    //! thread sleeps on it if the kernel rejects a submission while the
+    //! waiting thread reaps the completion ring
+    std::atomic<uint64_t> num_completed_ { 0 };
+    std::mutex completed_mtx_;
+    std::condition_variable completed_cv_;
     //! number of requests in waitings_requests
     tlx::semaphore num_waiting_requests_, num_free_events_, num_posted_requests_;
 
@@ -77,19 +105,41 @@ private:
     static void * wait_async(void* arg);   // thread start callback
     void post_requests();
     void handle_events(io_event* events, long num_events, bool canceled);
+    //! wake the posting thread waiting for events to be freed
+    void notify_completed();
+    //! queue a posted request again, whose remaining range could not be
+    //! submitted, returns false if the posting thread is stopped
+    bool requeue_request(request* req);
     void wait_requests();
     void suspend();
 
+    //! collect at least one completion event, sleeps if there is none
+    long get_events(io_event* events);
+    //! copy the available events out of the completion ring, only called by
+    //! the waiting thread, which is the ring's only consumer
+    long reap_ring(io_event* events);
+
     // needed by linuxaio_request
     aio_context_t get_io_context() { return context_; }
+    int get_eventfd() const { return eventfd_; }
 
 public:
     //! Construct queue. Requests max number of requests simultaneously
     //! submitted to disk, 0 means as many as possible
-    explicit linuxaio_queue(int desired_queue_length = 0);
+    explicit linuxaio_queue(int desired_queue_length = 0,
+                            completion_mode mode = GETEVENTS_COMPLETION);
+
+    completion_mode get_completion_mode() const { return completion_mode_; }
+
+    //! Returns the number of partial transfers whose remaining range was
+    //! posted again.
+    uint64_t num_resubmitted() const { return num_resubmitted_.load(); }
 
     void add_request(request_ptr& req) final;
     bool cancel_request(request_ptr& req) final;
+    bool set_request_priority(
+        request_ptr& req, request::priority_class priority) final;
+    size_t num_waiting_requests() final;
     void complete_request(request_ptr& req);
     ~linuxaio_queue();
 };
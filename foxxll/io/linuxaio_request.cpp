@@ -18,6 +18,9 @@
 #include <sys/syscall.h>
 #include <unistd.h>
 
+#include <cstring>
+#include <string>
+
 #include <foxxll/common/error_handling.hpp>
 #include <foxxll/io/disk_queues.hpp>
 
@@ -34,10 +37,10 @@ void linuxaio_request::completed(bool posted, bool canceled)
     if (!canceled)
     {
         if (op_ == READ) {
-            stats->read_op_finished(bytes_, duration);
+            stats->read_op_finished(transferred_, duration);
         }
         else {
-            stats->write_op_finished(bytes_, duration);
+            stats->write_op_finished(transferred_, duration);
         }
     }
     else if (posted)
@@ -51,7 +54,7 @@ void linuxaio_request::completed(bool posted, bool canceled)
     request_with_state::completed(canceled);
 }
 
-void linuxaio_request::fill_control_block()
+void linuxaio_request::fill_control_block(linuxaio_queue* queue)
 {
     linuxaio_file* af = dynamic_cast<linuxaio_file*>(file_);
 
@@ -62,24 +65,30 @@ void linuxaio_request::fill_control_block()
     cb_.aio_fildes = af->file_des_;
     cb_.aio_lio_opcode = (op_ == READ) ? IOCB_CMD_PREAD : IOCB_CMD_PWRITE;
     cb_.aio_reqprio = 0;
-    cb_.aio_buf = static_cast<__u64>(reinterpret_cast<unsigned long>(buffer_));
-    cb_.aio_nbytes = bytes_;
-    cb_.aio_offset = offset_;
+    // the part of the range which has not been transferred yet
+    cb_.aio_buf = static_cast<__u64>(reinterpret_cast<unsigned long>(
+                                         static_cast<char*>(buffer_) + transferred_));
+    cb_.aio_nbytes = bytes_ - transferred_;
+    cb_.aio_offset = offset_ + transferred_;
+
+    if (queue->get_eventfd() >= 0) {
+        // signal the completion to the waiting thread
+        cb_.aio_flags = IOCB_FLAG_RESFD;
+        cb_.aio_resfd = static_cast<__u32>(queue->get_eventfd());
+    }
 }
 
-//! Submits an I/O request to the OS
+//! Submits an I/O request to the OS, on the context of the posting queue
 //! \returns false if submission fails
-bool linuxaio_request::post()
+bool linuxaio_request::post(linuxaio_queue* queue)
 {
     LOG << "linuxaio_request[" << this << "] post()";
 
-    fill_control_block();
+    fill_control_block(queue);
     iocb* cb_pointer = &cb_;
     // io_submit might considerable time, so we have to remember the current
     // time before the call.
     time_posted_ = timestamp();
-    linuxaio_queue* queue = dynamic_cast<linuxaio_queue*>(
-            disk_queues::get_instance()->get_queue(file_->get_queue_id()));
 
     long success = syscall(SYS_io_submit, queue->get_io_context(), 1, &cb_pointer);
     // At this point another thread may have already called complete(),
@@ -94,6 +103,62 @@ bool linuxaio_request::post()
     return success == 1;
 }
 
+bool linuxaio_request::event_completed(long long res, linuxaio_queue* queue)
+{
+    if (res < 0)
+    {
+        error_occured(
+            std::string("linuxaio_request ") +
+            (op_ == READ ? "read" : "write") + " failed: " +
+            strerror(static_cast<int>(-res)));
+        return true;
+    }
+
+    transferred_ += static_cast<size_type>(res);
+    if (transferred_ >= bytes_)
+        return true;
+
+    if (op_ == READ && (res == 0 || offset_ + transferred_ >= file_->size()))
+    {
+        // read request extends past end-of-file, either truncate it or fill
+        // the remainder with zeroes
+        if (!file_->eof_truncate()) {
+            memset(static_cast<char*>(buffer_) + transferred_, 0,
+                   bytes_ - transferred_);
+            transferred_ = bytes_;
+        }
+        return true;
+    }
+
+    if (res == 0)
+    {
+        error_occured("linuxaio_request write made no progress");
+        return true;
+    }
+
+    LOG << "linuxaio_request[" << this << "] partial transfer of " << res <<
+        " bytes, posting the remaining " << bytes_ - transferred_ << " bytes";
+    ++queue->num_resubmitted_;
+
+    // the event slot of the completed part is reused
+    fill_control_block(queue);
+    iocb* cb_pointer = &cb_;
+    if (syscall(SYS_io_submit, queue->get_io_context(), 1, &cb_pointer) == 1)
+        return false;
+
+    const int error = errno;
+    ReferenceCounter::dec_reference();
+
+    // all events are in use, the posting thread submits the remaining range
+    // again once events completed, as with any other request
+    if (error == EAGAIN && queue->requeue_request(this))
+        return false;
+
+    error_occured(std::string("linuxaio_request io_submit() of the remaining "
+                              "range failed: ") + strerror(error));
+    return true;
+}
+
 //! Cancel the request
 //!
 //! Routine is called by user, as part of the request interface.
@@ -104,8 +169,9 @@ bool linuxaio_request::cancel()
     if (!file_) return false;
 
     request_ptr req(this);
-    linuxaio_queue* queue = dynamic_cast<linuxaio_queue*>(
-            disk_queues::get_instance()->get_queue(file_->get_queue_id()));
+    // the queue of a linuxaio_file is always a linuxaio_queue
+    linuxaio_queue* queue = static_cast<linuxaio_queue*>(
+        disk_queues::get_instance()->get_queue(file_->get_queue_id()));
     return queue->cancel_request(req);
 }
 
@@ -44,16 +44,19 @@ class linuxaio_request : public request_with_state
     iocb cb_;
     double time_posted_;
 
-    void fill_control_block();
+    void fill_control_block(linuxaio_queue* queue);
 
 public:
     linuxaio_request(
         const completion_handler& on_complete,
         file* file, void* buffer, offset_type offset, size_type bytes,
-        const read_or_write& op)
-        : request_with_state(on_complete, file, buffer, offset, bytes, op)
+        const read_or_write& op, priority_class priority = DEMAND)
+        : request_with_state(on_complete, file, buffer, offset, bytes, op,
+                             priority)
     {
         assert(dynamic_cast<linuxaio_file*>(file));
+        // counts the bytes of the completed parts
+        transferred_ = 0;
         LOG << "linuxaio_request[" << this << "]" <<
             " linuxaio_request" <<
             "(file=" << file << " buffer=" << buffer <<
@@ -61,9 +64,14 @@ public:
             " op=" << op << ")";
     }
 
-    bool post();
+    bool post(linuxaio_queue* queue);
     bool cancel() final;
     bool cancel_aio(linuxaio_queue* queue);
+    //! Accounts the result of a completion event. Partial transfers post the
+    //! remaining range again, or queue it if no events are free, reads ending
+    //! at the end of the file are done.
+    //! \return \c false if the remaining range was posted or queued again
+    bool event_completed(long long res, linuxaio_queue* queue);
     void completed(bool posted, bool canceled);
     void completed(bool canceled) { completed(true, canceled); }
 };
@@ -36,6 +36,12 @@ void memory_file::serve(void* buffer, offset_type offset, size_type bytes,
     else
     {
         file_stats::scoped_write_timer write_timer(file_stats_, bytes);
+        if (offset + bytes > size_) {
+            assert(offset + bytes <= std::numeric_limits<size_t>::max());
+            ptr_ = static_cast<char*>(
+                realloc(ptr_, static_cast<size_t>(offset + bytes)));
+            size_ = offset + bytes;
+        }
         memcpy(ptr_ + offset, buffer, bytes);
     }
 }
@@ -25,7 +25,8 @@ namespace foxxll {
 //! \addtogroup foxxll_fileimpl
 //! \{
 
-//! Implementation of file based on new[] and memcpy.
+//! Implementation of file based on new[] and memcpy. Writes beyond the end
+//! extend the file, like writes to a regular file.
 class memory_file final : public disk_queued_file
 {
     //! pointer to memory area of "file"
@@ -17,6 +17,9 @@
 
 #include <sys/mman.h>
 
+#include <algorithm>
+#include <cstring>
+
 #include <foxxll/common/error_handling.hpp>
 #include <foxxll/io/iostats.hpp>
 #include <foxxll/io/ufs_platform.hpp>
@@ -33,8 +36,26 @@ void mmap_file::serve(void* buffer, offset_type offset, size_type bytes,
     file_stats::scoped_read_write_timer read_write_timer(
         file_stats_, bytes, op == request::WRITE);
 
+    if (op == request::READ)
+    {
+        // pages past the end of the file cannot be accessed, fill the part of
+        // the buffer behind it with zeroes like a short read
+        const offset_type size = _size();
+        const size_type avail = offset < size ? static_cast<size_type>(
+            std::min<offset_type>(bytes, size - offset)) : 0;
+        memset(static_cast<char*>(buffer) + avail, 0, bytes - avail);
+        if (avail == 0)
+            return;
+        bytes = avail;
+    }
+
+    // map from the page boundary, the buffer needs no alignment
+    const offset_type delta = offset % static_cast<offset_type>(sysconf(_SC_PAGESIZE));
+    const size_t map_bytes = bytes + static_cast<size_t>(delta);
+
     int prot = (op == request::READ) ? PROT_READ : PROT_WRITE;
-    void* mem = mmap(nullptr, bytes, prot, MAP_SHARED, file_des_, offset);
+    void* mem = mmap(nullptr, map_bytes, prot, MAP_SHARED, file_des_,
+                     offset - delta);
 
     if (mem == MAP_FAILED)
     {
@@ -42,9 +63,8 @@ void mmap_file::serve(void* buffer, offset_type offset, size_type bytes,
             io_error,
             " mmap() failed." <<
                 " path=" << filename_ <<
-                " bytes=" << bytes <<
-                " Page size: " << sysconf(_SC_PAGESIZE) <<
-                " offset modulo page size " << (offset % sysconf(_SC_PAGESIZE))
+                " offset=" << offset <<
+                " bytes=" << bytes
         );
     }
     else if (mem == 0)
@@ -53,16 +73,17 @@ void mmap_file::serve(void* buffer, offset_type offset, size_type bytes,
     }
     else
     {
+        char* data = static_cast<char*>(mem) + delta;
         if (op == request::READ)
         {
-            memcpy(buffer, mem, bytes);
+            memcpy(buffer, data, bytes);
         }
         else
         {
-            memcpy(mem, buffer, bytes);
+            memcpy(data, buffer, bytes);
         }
         FOXXLL_THROW_ERRNO_NE_0(
-            munmap(mem, bytes), io_error,
+            munmap(mem, map_bytes), io_error,
             "munmap() failed"
         );
     }
@@ -0,0 +1,195 @@
+/***************************************************************************
+ *  foxxll/io/qos_request_queue.hpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef FOXXLL_IO_QOS_REQUEST_QUEUE_HEADER
+#define FOXXLL_IO_QOS_REQUEST_QUEUE_HEADER
+
+#include <algorithm>
+#include <cassert>
+#include <list>
+
+#include <foxxll/common/timer.hpp>
+#include <foxxll/io/request.hpp>
+
+namespace foxxll {
+
+//! \addtogroup foxxll_reqlayer
+//! \{
+
+/*!
+ * Container of the waiting requests of a disk queue, which hands them out by
+ * weighted fair queuing over the request priority classes.
+ *
+ * Each class has a virtual finish time which advances by the size of each
+ * served request divided by the class weight, the non-empty class with the
+ * lowest finish time is served next. PREFETCH requests are not eligible while
+ * DEMAND requests are waiting, so speculative reads never delay reads the
+ * application is blocked on. Within a class, requests are served in FIFO
+ * order, optionally with all writes before reads.
+ *
+ * A PREFETCH request whose deadline has passed when it is popped is marked
+ * as dropped, the disk queue completes it as canceled instead of issuing it.
+ *
+ * The container is not thread-safe, the disk queue must lock it.
+ */
+class qos_request_queue
+{
+public:
+    using priority_class = request::priority_class;
+
+    //! Relative share of the disk bandwidth of a priority class.
+    static double weight(priority_class c)
+    {
+        switch (c) {
+        case request::DEMAND: return 4.0;
+        case request::WRITEBACK: return 2.0;
+        case request::PREFETCH: return 1.0;
+        }
+        return 1.0;
+    }
+
+    //! \param writes_first serve writes before reads within a class
+    explicit qos_request_queue(bool writes_first = false)
+        : writes_first_(writes_first)
+    { }
+
+    bool empty() const { return size_ == 0; }
+
+    size_t size() const { return size_; }
+
+    //! Number of waiting requests of a class.
+    size_t size(priority_class c) const
+    {
+        return lists_[c][0].size() + lists_[c][1].size();
+    }
+
+    //! Appends a request to the list of its class.
+    void push_back(const request_ptr& req)
+    {
+        const priority_class c = req->priority();
+        if (size(c) == 0)
+            finish_[c] = std::max(finish_[c], vtime_);
+        list_of(req).push_back(req);
+        ++size_;
+    }
+
+    //! Removes and returns the next request to serve, the queue must not be
+    //! empty. Check request::dropped() before serving it.
+    request_ptr pop()
+    {
+        assert(!empty());
+
+        const bool demand_waiting = size(request::DEMAND) != 0;
+        size_t best = request::num_priority_classes;
+        for (size_t c = 0; c < request::num_priority_classes; ++c)
+        {
+            if (size(priority_class(c)) == 0)
+                continue;
+            if (c == request::PREFETCH && demand_waiting)
+                continue;
+            if (best == request::num_priority_classes ||
+                finish_[c] < finish_[best])
+                best = c;
+        }
+        assert(best != request::num_priority_classes);
+
+        std::list<request_ptr>& l =
+            lists_[best][0].empty() ? lists_[best][1] : lists_[best][0];
+        request_ptr req = l.front();
+        l.pop_front();
+        --size_;
+
+        if (best == request::PREFETCH)
+        {
+            const double deadline = req->deadline();
+            if (deadline != 0 && timestamp() > deadline) {
+                // dropped requests do not use up the class's share
+                req->dropped_ = true;
+                return req;
+            }
+        }
+
+        vtime_ = finish_[best];
+        finish_[best] += static_cast<double>(req->bytes()) /
+                         weight(priority_class(best));
+        return req;
+    }
+
+    //! Removes req if it is waiting.
+    //! \return true if req was found
+    bool erase(const request_ptr& req)
+    {
+        std::list<request_ptr>& l = list_of(req);
+        auto pos = std::find(l.begin(), l.end(), req);
+        if (pos == l.end())
+            return false;
+        l.erase(pos);
+        --size_;
+        return true;
+    }
+
+    //! Moves req to another priority class if it is waiting.
+    //! \return true if req was found
+    bool set_priority(const request_ptr& req, priority_class c)
+    {
+        if (req->priority() == c)
+            return false;
+        if (!erase(req))
+            return false;
+        req->priority_ = c;
+        push_back(req);
+        return true;
+    }
+
+    //! Returns whether a waiting request satisfies the predicate.
+    template <typename Predicate>
+    bool any_of(Predicate pred) const
+    {
+        for (size_t c = 0; c < request::num_priority_classes; ++c)
+        {
+            for (size_t i = 0; i < 2; ++i)
+            {
+                if (std::any_of(lists_[c][i].begin(), lists_[c][i].end(), pred))
+                    return true;
+            }
+        }
+        return false;
+    }
+
+private:
+    //! per class: list of writes (if writes_first_) and of other requests
+    std::list<request_ptr> lists_[request::num_priority_classes][2];
+
+    //! virtual finish time of each class
+    double finish_[request::num_priority_classes] = { };
+
+    //! virtual time: finish time of the class served last
+    double vtime_ = 0;
+
+    size_t size_ = 0;
+
+    const bool writes_first_;
+
+    std::list<request_ptr>& list_of(const request_ptr& req)
+    {
+        return lists_[req->priority()]
+               [writes_first_ && req->op() == request::WRITE ? 0 : 1];
+    }
+};
+
+//! \}
+
+} // namespace foxxll
+
+#endif // !FOXXLL_IO_QOS_REQUEST_QUEUE_HEADER
+
+/**************************************************************************/
@@ -15,6 +15,7 @@
 
 #include <tlx/logger.hpp>
 
+#include <foxxll/io/disk_queues.hpp>
 #include <foxxll/io/file.hpp>
 #include <foxxll/io/request.hpp>
 
@@ -23,10 +24,11 @@ namespace foxxll {
 request::request(
     const completion_handler& on_complete,
     file* file, void* buffer, offset_type offset, size_type bytes,
-    read_or_write op)
+    read_or_write op, priority_class priority)
     : on_complete_(on_complete),
-      file_(file), buffer_(buffer), offset_(offset), bytes_(bytes),
-      op_(op)
+      file_(file), queue_id_(file->get_queue_id()),
+      buffer_(buffer), offset_(offset), bytes_(bytes),
+      transferred_(bytes), op_(op), priority_(priority)
 {
     LOG << "request_with_state[" << static_cast<void*>(this) << "]::request(...), ref_cnt=" << reference_count();
     file_->add_request_ref();
@@ -37,19 +39,30 @@ request::~request()
     LOG << "request_with_state[" << static_cast<void*>(this) << "]::~request(), ref_cnt=" << reference_count();
 }
 
+bool request::set_priority(priority_class priority)
+{
+    // only the queue is asked, file_ may be reset concurrently by completion
+    request_ptr rp(this);
+    return disk_queues::get_instance()->set_request_priority(
+        rp, priority, queue_id());
+}
+
 void request::check_alignment() const
 {
-    if (offset_ % BlockAlignment != 0)
+    const size_t block_size = file_->logical_block_size();
+    const size_t memory_alignment = file_->memory_alignment();
+
+    if (offset_ % block_size != 0)
         LOG1 << "Offset is not aligned: modulo " <<
-            BlockAlignment << " = " << offset_ % BlockAlignment;
+            block_size << " = " << offset_ % block_size;
 
-    if (bytes_ % BlockAlignment != 0)
+    if (bytes_ % block_size != 0)
         LOG1 << "Size is not a multiple of " <<
-            BlockAlignment << ", = " << bytes_ % BlockAlignment;
+            block_size << ", = " << bytes_ % block_size;
 
-    if (size_t(buffer_) % BlockAlignment != 0)
+    if (size_t(buffer_) % memory_alignment != 0)
         LOG1 << "Buffer is not aligned: modulo " <<
-            BlockAlignment << " = " << size_t(buffer_) % BlockAlignment <<
+            memory_alignment << " = " << size_t(buffer_) % memory_alignment <<
             " (" << buffer_ << ")";
 }
 
@@ -15,6 +15,7 @@
 #ifndef FOXXLL_IO_REQUEST_HEADER
 #define FOXXLL_IO_REQUEST_HEADER
 
+#include <atomic>
 #include <cassert>
 #include <functional>
 #include <memory>
@@ -50,6 +51,7 @@ class request : virtual public request_interface, public tlx::reference_counter
 {
     constexpr static bool debug = false;
     friend class linuxaio_queue;
+    friend class qos_request_queue;
 
 protected:
     completion_handler on_complete_;
@@ -61,21 +63,35 @@ protected:
 
     //! file implementation to perform I/O with
     file* file_;
+    //! disk queue the request is added to, kept as file_ is reset by the
+    //! completing thread
+    int queue_id_;
     //! data buffer to transfer
     void* buffer_;
     //! offset within file
     offset_type offset_;
     //! number of bytes at buffer_ to transfer
     size_type bytes_;
+    //! number of bytes actually transferred, set before completion
+    size_type transferred_;
     //! READ or WRITE
     read_or_write op_;
+    //! quality of service class, changed by the disk queue holding the
+    //! request under its lock
+    priority_class priority_;
+    //! timestamp() after which a PREFETCH request is no longer useful, 0 =
+    //! never expires
+    std::atomic<double> deadline_ { 0.0 };
+    //! set by the disk queue under its lock if the request expired before it
+    //! was issued and will be completed as canceled
+    bool dropped_ = false;
 
     //! \}
 
 public:
     request(const completion_handler& on_complete,
             file* file, void* buffer, offset_type offset, size_type bytes,
-            read_or_write op);
+            read_or_write op, priority_class priority = DEMAND);
 
     //! non-copyable: delete copy-constructor
     request(const request&) = delete;
@@ -96,7 +112,33 @@ public:
     void * buffer() const { return buffer_; }
     offset_type offset() const { return offset_; }
     size_type bytes() const { return bytes_; }
+    //! Returns the number of bytes transferred by the completed request,
+    //! which is less than bytes() only for reads truncated at the end of a
+    //! file opened with file::EOF_TRUNCATE.
+    size_type transferred() const { return transferred_; }
     read_or_write op() const { return op_; }
+    priority_class priority() const { return priority_; }
+
+    //! Returns the identifier of the disk queue the request is added to, by
+    //! default the file's queue.
+    int queue_id() const { return queue_id_; }
+
+    //! Changes the priority class of the request if it is still waiting in
+    //! its disk queue, e.g. to promote a prefetch which the application is
+    //! about to wait for to DEMAND.
+    //! \return \c true iff the request was still waiting
+    bool set_priority(priority_class priority);
+
+    //! Sets the time (see timestamp()) after which the request is no longer
+    //! useful. A PREFETCH request which has not been issued by then is
+    //! dropped by the disk queue and completed as canceled.
+    void set_deadline(double deadline) { deadline_ = deadline; }
+
+    double deadline() const { return deadline_; }
+
+    //! Whether the request expired before being issued. Only valid if the
+    //! request is completed, or if set_priority() returned \c false.
+    bool dropped() const { return dropped_; }
 
     void check_alignment() const;
 
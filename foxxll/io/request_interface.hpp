@@ -41,6 +41,21 @@ public:
 
     enum read_or_write { READ, WRITE };
 
+    //! Quality of service classes of requests. The disk queues share the
+    //! disks between the classes by weighted fair queuing, and PREFETCH
+    //! requests are held back as long as DEMAND requests are waiting.
+    enum priority_class {
+        //! the application is (or will soon be) blocked on the request
+        DEMAND,
+        //! speculative read ahead
+        PREFETCH,
+        //! write back of buffered data
+        WRITEBACK
+    };
+
+    //! number of priority classes
+    static constexpr size_t num_priority_classes = 3;
+
 public:
     virtual bool add_waiter(onoff_switch* sw) = 0;
     virtual void delete_waiter(onoff_switch* sw) = 0;
@@ -46,6 +46,38 @@ public:
     virtual bool cancel_request(request_ptr& req) = 0;
     virtual ~request_queue() { }
     virtual void set_priority_op(const priority_op& p) { tlx::unused(p); }
+
+    //! Moves a waiting request to another priority class.
+    //! \return \c true iff the request was still waiting in the queue
+    virtual bool set_request_priority(
+        request_ptr& req, request::priority_class priority)
+    {
+        tlx::unused(req);
+        tlx::unused(priority);
+        return false;
+    }
+
+    //! Returns the number of requests waiting to be issued, as a measure of
+    //! the current load of the disk.
+    virtual size_t num_waiting_requests() { return 0; }
+
+    //! Limits the rate at which requests are issued to the disk, 0 disables
+    //! the respective limit. Ignored by queues which cannot throttle.
+    virtual void set_rate_limit(double bytes_per_sec, double ops_per_sec)
+    {
+        tlx::unused(bytes_per_sec);
+        tlx::unused(ops_per_sec);
+    }
+
+    //! Accounts a transfer to the disk which is served by another queue
+    //! (e.g. the write of a copy) against the rate limits, and waits until
+    //! they allow it.
+    //! \return seconds waited
+    virtual double acquire(size_t bytes)
+    {
+        tlx::unused(bytes);
+        return 0;
+    }
 };
 
 //! \}
@@ -71,11 +71,7 @@ void request_queue_impl_1q::add_request(request_ptr& req)
 #if FOXXLL_CHECK_FOR_PENDING_REQUESTS_ON_SUBMISSION
     {
         std::unique_lock<std::mutex> lock(queue_mutex_);
-        if (std::find_if(
-                queue_.begin(), queue_.end(),
-                bind2nd(file_offset_match(), req)
-            )
-            != queue_.end())
+        if (queue_.any_of(bind2nd(file_offset_match(), req)))
         {
             LOG1 << "request submitted for a BID with a pending request";
         }
@@ -99,12 +95,8 @@ bool request_queue_impl_1q::cancel_request(request_ptr& req)
     bool was_still_in_queue = false;
     {
         std::unique_lock<std::mutex> lock(queue_mutex_);
-        queue_type::iterator pos
-            = std::find(queue_.begin(), queue_.end(), req);
-
-        if (pos != queue_.end())
+        if (queue_.erase(req))
         {
-            queue_.erase(pos);
             was_still_in_queue = true;
             lock.unlock();
             sem_.wait();
@@ -114,6 +106,19 @@ bool request_queue_impl_1q::cancel_request(request_ptr& req)
     return was_still_in_queue;
 }
 
+bool request_queue_impl_1q::set_request_priority(
+    request_ptr& req, request::priority_class priority)
+{
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    return queue_.set_priority(req, priority);
+}
+
+size_t request_queue_impl_1q::num_waiting_requests()
+{
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    return queue_.size();
+}
+
 request_queue_impl_1q::~request_queue_impl_1q()
 {
     stop_thread(thread_, thread_state_, sem_);
@@ -131,13 +136,18 @@ void* request_queue_impl_1q::worker(void* arg)
             std::unique_lock<std::mutex> lock(pthis->queue_mutex_);
             if (!pthis->queue_.empty())
             {
-                request_ptr req = pthis->queue_.front();
-                pthis->queue_.pop_front();
+                request_ptr req = pthis->queue_.pop();
 
                 lock.unlock();
 
                 //assert(req->nref() > 1);
-                dynamic_cast<serving_request*>(req.get())->serve();
+                if (req->dropped()) {
+                    dynamic_cast<serving_request*>(req.get())->drop();
+                }
+                else {
+                    pthis->throttle(req);
+                    dynamic_cast<serving_request*>(req.get())->serve();
+                }
             }
             else
             {
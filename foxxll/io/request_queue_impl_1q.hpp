@@ -20,6 +20,7 @@
 
 #include <tlx/unused.hpp>
 
+#include <foxxll/io/qos_request_queue.hpp>
 #include <foxxll/io/request_queue_impl_worker.hpp>
 
 namespace foxxll {
@@ -28,15 +29,15 @@ namespace foxxll {
 //! \{
 
 //! Implementation of a local request queue having only one queue for both read
-//! and write requests, thus having only one thread.
+//! and write requests, thus having only one thread. Requests are served in
+//! FIFO order within their priority class.
 class request_queue_impl_1q : public request_queue_impl_worker
 {
 private:
     using self = request_queue_impl_1q;
-    using queue_type = std::list<request_ptr>;
 
     std::mutex queue_mutex_;
-    queue_type queue_;
+    qos_request_queue queue_;
 
     shared_state<thread_state> thread_state_;
     std::thread thread_;
@@ -58,6 +59,9 @@ public:
 
     void add_request(request_ptr& req) final;
     bool cancel_request(request_ptr& req) final;
+    bool set_request_priority(
+        request_ptr& req, request::priority_class priority) final;
+    size_t num_waiting_requests() final;
     ~request_queue_impl_1q();
 };
 
@@ -19,6 +19,7 @@
 #include <tlx/logger.hpp>
 
 #include <foxxll/common/error_handling.hpp>
+#include <foxxll/common/timer.hpp>
 #include <foxxll/io/request_queue_impl_qwqr.hpp>
 #include <foxxll/io/serving_request.hpp>
 
@@ -45,11 +46,25 @@ struct file_offset_match
     }
 };
 
-request_queue_impl_qwqr::request_queue_impl_qwqr(int n)
-    : thread_state_(NOT_RUNNING), sem_(0)
+request_queue_impl_qwqr::request_queue_impl_qwqr(int n, int max_n)
+    : queue_(priority_op_ == WRITE),
+      thread_state_(NOT_RUNNING), sem_(0),
+      scaler_(n > 1 ? static_cast<size_t>(n) : 1,
+              max_n > n ? static_cast<size_t>(max_n) : 1)
 {
-    tlx::unused(n);
-    start_thread(worker, static_cast<void*>(this), thread_, thread_state_);
+    if (max_n != 0 && max_n < n)
+        FOXXLL_THROW_INVALID_ARGUMENT(
+            "Maximum number of worker threads " << max_n <<
+            " is less than the number of threads " << n << ".");
+
+    active_workers_ = scaler_.target();
+    next_worker_index_ = 0;
+
+    const size_t num_threads = std::max(
+        active_workers_.load(), max_n > 1 ? static_cast<size_t>(max_n) : 1);
+    running_workers_ = num_threads;
+    start_threads(worker, static_cast<void*>(this), num_threads,
+                  threads_, thread_state_);
 }
 
 void request_queue_impl_qwqr::set_priority_op(const priority_op& op)
@@ -67,42 +82,24 @@ void request_queue_impl_qwqr::add_request(request_ptr& req)
     if (!dynamic_cast<serving_request*>(req.get()))
         LOG1 << "Incompatible request submitted to running queue.";
 
-    if (req.get()->op() == request::READ)
-    {
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+
 #if FOXXLL_CHECK_FOR_PENDING_REQUESTS_ON_SUBMISSION
-        {
-            std::unique_lock<std::mutex> lock(write_mutex_);
-            if (std::find_if(
-                    write_queue_.begin(), write_queue_.end(),
-                    bind2nd(file_offset_match(), req)
-                )
-                != write_queue_.end())
-            {
-                LOG1 << "READ request submitted for a BID with a pending WRITE request";
-            }
-        }
-#endif
-        std::unique_lock<std::mutex> lock(read_mutex_);
-        read_queue_.push_back(req);
-    }
-    else
+    if (queue_.any_of(
+            [&req](const request_ptr& other) {
+                return other->op() != req->op() &&
+                file_offset_match()(other, req);
+            }))
     {
-#if FOXXLL_CHECK_FOR_PENDING_REQUESTS_ON_SUBMISSION
-        {
-            std::unique_lock<std::mutex> lock(read_mutex_);
-            if (std::find_if(
-                    read_queue_.begin(), read_queue_.end(),
-                    bind2nd(file_offset_match(), req)
-                )
-                != read_queue_.end())
-            {
-                LOG1 << "WRITE request submitted for a BID with a pending READ request";
-            }
-        }
-#endif
-        std::unique_lock<std::mutex> lock(write_mutex_);
-        write_queue_.push_back(req);
+        if (req->op() == request::READ)
+            LOG1 << "READ request submitted for a BID with a pending WRITE request";
+        else
+            LOG1 << "WRITE request submitted for a BID with a pending READ request";
     }
+#endif
+
+    queue_.push_back(req);
+    lock.unlock();
 
     sem_.signal();
 }
@@ -116,107 +113,110 @@ bool request_queue_impl_qwqr::cancel_request(request_ptr& req)
     if (!dynamic_cast<serving_request*>(req.get()))
         LOG1 << "Incompatible request submitted to running queue.";
 
-    bool was_still_in_queue = false;
-    if (req.get()->op() == request::READ)
-    {
-        std::unique_lock<std::mutex> lock(read_mutex_);
-        queue_type::iterator pos
-            = std::find(read_queue_.begin(), read_queue_.end(), req);
-        if (pos != read_queue_.end())
-        {
-            read_queue_.erase(pos);
-            was_still_in_queue = true;
-            lock.unlock();
-            sem_.wait();
-        }
-    }
-    else
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    if (!queue_.erase(req))
+        return false;
+
+    lock.unlock();
+    sem_.wait();
+    return true;
+}
+
+bool request_queue_impl_qwqr::set_request_priority(
+    request_ptr& req, request::priority_class priority)
+{
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    return queue_.set_priority(req, priority);
+}
+
+size_t request_queue_impl_qwqr::num_waiting_requests()
+{
+    std::unique_lock<std::mutex> lock(queue_mutex_);
+    return queue_.size();
+}
+
+request_queue_impl_qwqr::~request_queue_impl_qwqr()
+{
+    // all parked workers take part in draining the queues and termination
     {
-        std::unique_lock<std::mutex> lock(write_mutex_);
-        queue_type::iterator pos
-            = std::find(write_queue_.begin(), write_queue_.end(), req);
-        if (pos != write_queue_.end())
-        {
-            write_queue_.erase(pos);
-            was_still_in_queue = true;
-            lock.unlock();
-            sem_.wait();
-        }
+        std::unique_lock<std::mutex> lock(park_mutex_);
+        terminating_ = true;
     }
+    park_cv_.notify_all();
 
-    return was_still_in_queue;
+    stop_threads(threads_, thread_state_, sem_);
 }
 
-request_queue_impl_qwqr::~request_queue_impl_qwqr()
+void request_queue_impl_qwqr::wait_until_active(size_t index)
+{
+    if (index < active_workers_)
+        return;
+
+    std::unique_lock<std::mutex> lock(park_mutex_);
+    park_cv_.wait(lock, [&]() {
+                      return index < active_workers_ || terminating_;
+                  });
+}
+
+void request_queue_impl_qwqr::serve(request_ptr& req, size_t backlog)
 {
-    stop_thread(thread_, thread_state_, sem_);
+    if (req->dropped()) {
+        dynamic_cast<serving_request*>(req.get())->drop();
+        return;
+    }
+
+    throttle(req);
+
+    if (!scaler_.enabled()) {
+        dynamic_cast<serving_request*>(req.get())->serve();
+        return;
+    }
+
+    const size_t bytes = req->bytes();
+    const double start = timestamp();
+    dynamic_cast<serving_request*>(req.get())->serve();
+
+    if (scaler_.served(bytes, timestamp() - start, backlog))
+    {
+        {
+            std::unique_lock<std::mutex> lock(park_mutex_);
+            active_workers_ = scaler_.target();
+        }
+        park_cv_.notify_all();
+    }
 }
 
 void* request_queue_impl_qwqr::worker(void* arg)
 {
     self* pthis = static_cast<self*>(arg);
+    const size_t index = pthis->next_worker_index_++;
 
-    bool write_phase = true;
     for ( ; ; )
     {
+        pthis->wait_until_active(index);
+
         pthis->sem_.wait();
 
-        if (write_phase)
+        std::unique_lock<std::mutex> lock(pthis->queue_mutex_);
+        if (!pthis->queue_.empty())
         {
-            std::unique_lock<std::mutex> write_lock(pthis->write_mutex_);
-            if (!pthis->write_queue_.empty())
-            {
-                request_ptr req = pthis->write_queue_.front();
-                pthis->write_queue_.pop_front();
-
-                write_lock.unlock();
-
-                //assert(req->get_reference_count()) > 1);
-                dynamic_cast<serving_request*>(req.get())->serve();
-            }
-            else
-            {
-                write_lock.unlock();
-
-                pthis->sem_.signal();
+            request_ptr req = pthis->queue_.pop();
+            const size_t backlog = pthis->queue_.size();
 
-                if (pthis->priority_op_ == WRITE)
-                    write_phase = false;
-            }
+            lock.unlock();
 
-            if (pthis->priority_op_ == NONE || pthis->priority_op_ == READ)
-                write_phase = false;
+            LOG << "queue: before serve request has "
+                << req->reference_count() << " references ";
+            //assert(req->get_reference_count() > 1);
+            pthis->serve(req, backlog);
+            LOG << "queue: after serve request has "
+                << req->reference_count() << " references ";
         }
         else
         {
-            std::unique_lock<std::mutex> read_lock(pthis->read_mutex_);
-
-            if (!pthis->read_queue_.empty())
-            {
-                request_ptr req = pthis->read_queue_.front();
-                pthis->read_queue_.pop_front();
-
-                read_lock.unlock();
-
-                LOG << "queue: before serve request has "
-                    << req->reference_count() << " references ";
-                //assert(req->get_reference_count() > 1);
-                dynamic_cast<serving_request*>(req.get())->serve();
-                LOG << "queue: after serve request has "
-                    << req->reference_count() << " references ";
-            }
-            else
-            {
-                read_lock.unlock();
-
-                pthis->sem_.signal();
-
-                if (pthis->priority_op_ == READ)
-                    write_phase = true;
-            }
+            lock.unlock();
 
-            if (pthis->priority_op_ == NONE || pthis->priority_op_ == WRITE)
-                write_phase = true;
+            pthis->sem_.signal();
         }
 
         // terminate if it has been requested and queues are empty
@@ -228,7 +228,11 @@ void* request_queue_impl_qwqr::worker(void* arg)
         }
     }
 
-    pthis->thread_state_.set_to(TERMINATED);
+    // pass the termination signal on to the next worker
+    pthis->sem_.signal();
+
+    if (--pthis->running_workers_ == 0)
+        pthis->thread_state_.set_to(TERMINATED);
 
 #if FOXXLL_MSVC >= 1700 && FOXXLL_MSVC <= 1800
     // Workaround for deadlock bug in Visual C++ Runtime 2012 and 2013, see
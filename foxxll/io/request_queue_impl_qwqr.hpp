@@ -16,11 +16,15 @@
 #ifndef FOXXLL_IO_REQUEST_QUEUE_IMPL_QWQR_HEADER
 #define FOXXLL_IO_REQUEST_QUEUE_IMPL_QWQR_HEADER
 
+#include <atomic>
+#include <condition_variable>
 #include <list>
 #include <mutex>
+#include <vector>
 
 #include <tlx/unused.hpp>
 
+#include <foxxll/io/qos_request_queue.hpp>
 #include <foxxll/io/request_queue_impl_worker.hpp>
 
 namespace foxxll {
@@ -28,33 +32,63 @@ namespace foxxll {
 //! \addtogroup foxxll_reqlayer
 //! \{
 
-//! Implementation of a local request queue having two queues, one for read and
-//! one for write requests, thus having two threads. This is the default
-//! implementation.
+//! Implementation of a local request queue served by a pool of worker threads.
+//! The requests are chosen by weighted fair queuing over their priority
+//! classes, within a class write requests are served before read requests.
+//! This is the default implementation.
+//!
+//! If the maximum number of threads exceeds the minimum, all threads are
+//! started but only worker_scaler::target() of them take requests, the others
+//! are parked until the controller activates them again.
 class request_queue_impl_qwqr final : public request_queue_impl_worker
 {
     constexpr static bool debug = false;
 
 private:
     using self = request_queue_impl_qwqr;
-    using queue_type = std::list<request_ptr>;
 
-    std::mutex write_mutex_;
-    std::mutex read_mutex_;
-    queue_type write_queue_;
-    queue_type read_queue_;
+    std::mutex queue_mutex_;
+    qos_request_queue queue_;
 
     shared_state<thread_state> thread_state_;
-    std::thread thread_;
+    std::vector<std::thread> threads_;
+    //! number of worker threads which have not yet terminated
+    std::atomic<size_t> running_workers_;
+    //! counter to hand out worker indexes, workers with an index at or above
+    //! the number of active workers are parked
+    std::atomic<size_t> next_worker_index_;
     tlx::semaphore sem_;
 
+    //! controller of the number of active workers
+    worker_scaler scaler_;
+    //! copy of scaler_.target() read by the workers without locking
+    std::atomic<size_t> active_workers_;
+
+    //! parked workers wait for activation or termination here
+    std::mutex park_mutex_;
+    std::condition_variable park_cv_;
+    bool terminating_ = false;
+
     static const priority_op priority_op_ = WRITE;
 
     static void * worker(void* arg);
 
+    //! blocks worker number index while it is not active
+    void wait_until_active(size_t index);
+
+    //! serve a request and report it to the worker controller
+    void serve(request_ptr& req, size_t backlog);
+
 public:
-    // \param n max number of requests simultaneously submitted to disk
-    explicit request_queue_impl_qwqr(int n = 1);
+    // \param n max number of requests simultaneously submitted to disk,
+    // i.e. the number of worker threads
+    // \param max_n if larger than n, the number of active worker threads is
+    // adapted between n and max_n depending on the observed throughput and
+    // service times, 0 = fixed. Throws std::invalid_argument if less than n.
+    explicit request_queue_impl_qwqr(int n = 1, int max_n = 0);
+
+    //! number of worker threads currently taking requests
+    size_t num_active_workers() const { return active_workers_; }
 
     // in a multi-threaded setup this does not work as intended
     // also there were race conditions possible
@@ -63,6 +97,9 @@ public:
     void set_priority_op(const priority_op& op) final;
     void add_request(request_ptr& req) final;
     bool cancel_request(request_ptr& req) final;
+    bool set_request_priority(
+        request_ptr& req, request::priority_class priority) final;
+    size_t num_waiting_requests() final;
     ~request_queue_impl_qwqr();
 };
 
@@ -13,13 +13,22 @@
  *  http://www.boost.org/LICENSE_1_0.txt)
  **************************************************************************/
 
+#include <algorithm>
 #include <cassert>
 #include <cstddef>
+#include <mutex>
 #include <thread>
+#include <vector>
+
+#include <tlx/logger.hpp>
 
 #include <foxxll/common/error_handling.hpp>
 #include <foxxll/common/shared_state.hpp>
+#include <foxxll/common/timer.hpp>
 #include <foxxll/config.hpp>
+#include <foxxll/io/file.hpp>
+#include <foxxll/io/iostats.hpp>
+#include <foxxll/io/request.hpp>
 #include <foxxll/io/request_queue_impl_worker.hpp>
 #include <tlx/semaphore.hpp>
 
@@ -29,6 +38,24 @@
 
 namespace foxxll {
 
+void request_queue_impl_worker::throttle(const request_ptr& req)
+{
+    const double waited = throttle_.acquire(req->bytes());
+    if (waited > 0 && req->get_file()->get_file_stats())
+        req->get_file()->get_file_stats()->throttled(waited);
+}
+
+void request_queue_impl_worker::set_rate_limit(
+    double bytes_per_sec, double ops_per_sec)
+{
+    throttle_.set_limits(bytes_per_sec, ops_per_sec);
+}
+
+double request_queue_impl_worker::acquire(size_t bytes)
+{
+    return throttle_.acquire(bytes);
+}
+
 void request_queue_impl_worker::start_thread(
     void* (*worker)(void*), void* arg, std::thread& t,
     shared_state<thread_state>& s)
@@ -64,6 +91,117 @@ void request_queue_impl_worker::stop_thread(
     s.set_to(NOT_RUNNING);
 }
 
+void request_queue_impl_worker::start_threads(
+    void* (*worker)(void*), void* arg, size_t n,
+    std::vector<std::thread>& threads, shared_state<thread_state>& s)
+{
+    assert(s() == NOT_RUNNING);
+    assert(n > 0);
+    threads.reserve(n);
+    for (size_t i = 0; i < n; ++i)
+        threads.emplace_back(worker, arg);
+    s.set_to(RUNNING);
+}
+
+void request_queue_impl_worker::stop_threads(
+    std::vector<std::thread>& threads, shared_state<thread_state>& s,
+    tlx::semaphore& sem)
+{
+    assert(s() == RUNNING);
+    s.set_to(TERMINATING);
+    sem.signal();
+    for (std::thread& t : threads)
+    {
+#if FOXXLL_MSVC >= 1700 && FOXXLL_MSVC <= 1800
+        // see stop_thread()
+        WaitForSingleObject(t.native_handle(), INFINITE);
+        CloseHandle(t.native_handle());
+#else
+        t.join();
+#endif
+    }
+    threads.clear();
+    assert(s() == TERMINATED);
+    s.set_to(NOT_RUNNING);
+}
+
+constexpr double request_queue_impl_worker::worker_scaler::latency_factor;
+constexpr double request_queue_impl_worker::worker_scaler::bandwidth_gain;
+constexpr size_t request_queue_impl_worker::worker_scaler::window_per_worker;
+
+request_queue_impl_worker::worker_scaler::worker_scaler(
+    size_t min_workers, size_t max_workers)
+    : min_workers_(std::max<size_t>(min_workers, 1)),
+      max_workers_(std::max(max_workers, min_workers_)),
+      target_(min_workers_),
+      window_start_(timestamp())
+{ }
+
+bool request_queue_impl_worker::worker_scaler::served(
+    size_t bytes, double service_time, size_t backlog)
+{
+    constexpr bool debug = false;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    ++window_requests_;
+    window_bytes_ += bytes;
+    window_service_time_ += service_time;
+    window_backlog_ += backlog;
+
+    if (window_requests_ < window_per_worker * target_)
+        return false;
+
+    const double now = timestamp();
+    const double elapsed = now - window_start_;
+    const double bandwidth = elapsed > 0 ? window_bytes_ / elapsed : 0;
+    const double latency = window_service_time_ / window_requests_;
+    const double mean_backlog =
+        static_cast<double>(window_backlog_) / window_requests_;
+
+    // forget the base latency slowly, the request mix may change
+    if (base_latency_ == 0 || latency < base_latency_)
+        base_latency_ = latency;
+    else
+        base_latency_ *= 1.05;
+
+    const size_t old_target = target_;
+    bool increased = false;
+
+    if (latency > latency_factor * base_latency_)
+    {
+        // congestion: multiplicative decrease
+        target_ = std::max(target_ / 2, min_workers_);
+    }
+    else if (last_increased_ && bandwidth < bandwidth_gain * last_bandwidth_)
+    {
+        // the last additional worker did not pay off
+        target_ = std::max(target_ - 1, min_workers_);
+    }
+    else if (mean_backlog >= 1.0 && target_ < max_workers_)
+    {
+        // requests are queueing up: additive increase
+        ++target_;
+        increased = true;
+    }
+
+    LOG << "worker_scaler: bandwidth=" << bandwidth
+        << " latency=" << latency << " base_latency=" << base_latency_
+        << " backlog=" << mean_backlog
+        << " workers " << old_target << " -> " << target_;
+
+    last_bandwidth_ = bandwidth;
+    last_increased_ = increased;
+
+    window_requests_ = 0;
+    window_bytes_ = 0;
+    window_service_time_ = 0;
+    window_backlog_ = 0;
+    window_start_ = now;
+
+    return target_ != old_target;
+}
+
 } // namespace foxxll
 
 /**************************************************************************/
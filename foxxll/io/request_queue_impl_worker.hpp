@@ -16,10 +16,13 @@
 #ifndef FOXXLL_IO_REQUEST_QUEUE_IMPL_WORKER_HEADER
 #define FOXXLL_IO_REQUEST_QUEUE_IMPL_WORKER_HEADER
 
+#include <mutex>
 #include <thread>
+#include <vector>
 
 #include <foxxll/common/shared_state.hpp>
 #include <foxxll/config.hpp>
+#include <foxxll/io/io_throttle.hpp>
 #include <foxxll/io/request_queue.hpp>
 #include <tlx/semaphore.hpp>
 
@@ -36,6 +39,18 @@ class request_queue_impl_worker : public request_queue
 protected:
     enum thread_state { NOT_RUNNING, RUNNING, TERMINATING, TERMINATED };
 
+    //! rate limits of the queue
+    io_throttle throttle_;
+
+    //! Waits until the rate limits allow req to be issued and accounts the
+    //! time in the file's statistics. Must be called by the worker threads.
+    void throttle(const request_ptr& req);
+
+public:
+    void set_rate_limit(double bytes_per_sec, double ops_per_sec) override;
+
+    double acquire(size_t bytes) override;
+
 protected:
     void start_thread(
         void* (*worker)(void*), void* arg,
@@ -43,6 +58,85 @@ protected:
 
     void stop_thread(
         std::thread& t, shared_state<thread_state>& s, tlx::semaphore& sem);
+
+    //! Starts a pool of n threads running the same worker function.
+    void start_threads(
+        void* (*worker)(void*), void* arg, size_t n,
+        std::vector<std::thread>& threads, shared_state<thread_state>& s);
+
+    //! Stops a pool of threads. The semaphore is signaled once, each worker
+    //! leaving must signal it again to wake up the next one, and the last
+    //! worker must set the state to TERMINATED.
+    void stop_threads(
+        std::vector<std::thread>& threads, shared_state<thread_state>& s,
+        tlx::semaphore& sem);
+
+    /*!
+     * AIMD controller for the number of active worker threads of a pool.
+     *
+     * Workers report each served request. Every observation window (a number
+     * of requests proportional to the current target) the controller
+     * computes the achieved bandwidth, the mean service time and the mean
+     * backlog. If the service time exceeds latency_factor times the lowest
+     * recently observed one, the device is considered congested and the
+     * target is halved (multiplicative decrease). Otherwise, if requests are
+     * queueing up, the target is incremented (additive increase), and an
+     * increment which did not raise bandwidth is taken back again. Thus the
+     * pool probes for the concurrency yielding maximum bandwidth at bounded
+     * latency, which differs widely between rotational disks and NVMe.
+     */
+    class worker_scaler
+    {
+    public:
+        //! a service time of more than this factor times the base latency
+        //! is considered congestion
+        static constexpr double latency_factor = 4.0;
+
+        //! minimum relative bandwidth gain to justify an additional worker
+        static constexpr double bandwidth_gain = 1.05;
+
+        //! requests per window and active worker
+        static constexpr size_t window_per_worker = 8;
+
+        worker_scaler(size_t min_workers, size_t max_workers);
+
+        //! Records a served request.
+        //! \param bytes size of the request
+        //! \param service_time time taken to serve the request in seconds
+        //! \param backlog number of requests still waiting in the queue
+        //! \return true if the target number of workers was changed
+        bool served(size_t bytes, double service_time, size_t backlog);
+
+        //! number of workers which should currently be active
+        size_t target() const
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            return target_;
+        }
+
+        //! whether the worker count is adapted at all
+        bool enabled() const { return max_workers_ > min_workers_; }
+
+    private:
+        mutable std::mutex mutex_;
+
+        const size_t min_workers_, max_workers_;
+        size_t target_;
+
+        //! counters of the current observation window
+        size_t window_requests_ = 0;
+        size_t window_bytes_ = 0;
+        double window_service_time_ = 0;
+        size_t window_backlog_ = 0;
+        double window_start_;
+
+        //! bandwidth of the previous window
+        double last_bandwidth_ = 0;
+        //! whether the target was incremented after the previous window
+        bool last_increased_ = false;
+        //! lowest recently observed mean service time, slowly decaying
+        double base_latency_ = 0;
+    };
 };
 
 //! \}
@@ -15,6 +15,7 @@
 #include <cassert>
 
 #include <foxxll/common/shared_state.hpp>
+#include <foxxll/common/timer.hpp>
 #include <foxxll/io/disk_queues.hpp>
 #include <foxxll/io/file.hpp>
 #include <foxxll/io/iostats.hpp>
@@ -24,6 +25,17 @@
 
 namespace foxxll {
 
+request_with_state::request_with_state(
+    const completion_handler& on_complete,
+    file* file, void* buffer, offset_type offset, size_type bytes,
+    read_or_write op, priority_class priority)
+    : request_with_waiters(on_complete, file, buffer, offset, bytes, op,
+                           priority),
+      state_(OP),
+      poll_budget_(file->poll_budget()),
+      poll_stats_(file->get_file_stats())
+{ }
+
 request_with_state::~request_with_state()
 {
     LOG << "request_with_state[" << static_cast<void*>(this) << "]::~(), ref_cnt: " << reference_count();
@@ -38,6 +50,17 @@ void request_with_state::wait(bool measure_time)
     stats::scoped_wait_timer wait_timer(
         op_ == READ ? stats::WAIT_OP_READ : stats::WAIT_OP_WRITE, measure_time);
 
+    if (poll_budget_ > 0.0 && state_() != READY2DIE)
+    {
+        // spin for the completion instead of waiting to be woken up
+        const double start = timestamp();
+        double now = start;
+        bool hit;
+        while (!(hit = state_() == READY2DIE) && now - start < poll_budget_)
+            now = timestamp();
+        poll_stats_->polled(now - start, hit);
+    }
+
     state_.wait_for(READY2DIE);
 
     check_errors();
@@ -52,7 +75,7 @@ bool request_with_state::cancel()
 
     // TODO(tb): remove
     request_ptr rp(this);
-    if (disk_queues::get_instance()->cancel_request(rp, file_->get_queue_id()))
+    if (disk_queues::get_instance()->cancel_request(rp, queue_id()))
     {
         state_.set_to(DONE);
         if (on_complete_)
@@ -78,6 +101,12 @@ bool request_with_state::poll()
 void request_with_state::completed(bool canceled)
 {
     LOG << "request_with_state[" << static_cast<void*>(this) << "]::completed()";
+    // the owner of a file held by counting pointers may drop it as soon as
+    // poll() reports the request as done, keep it alive until the callback
+    // returned and the request reference is deleted
+    file_ptr keep_file;
+    if (file_ && file_->reference_count() != 0)
+        keep_file = file_ptr(file_);
     // change state
     state_.set_to(DONE);
     // user callback
@@ -20,6 +20,8 @@
 
 namespace foxxll {
 
+class file_stats;
+
 //! \addtogroup foxxll_reqlayer
 //! \{
 
@@ -35,14 +37,16 @@ protected:
 
     shared_state<request_state> state_;
 
+    //! seconds wait() spins before sleeping, the file's poll_budget()
+    const double poll_budget_;
+    //! stats of the file, which outlive it, to account the spinning
+    file_stats* const poll_stats_;
+
 protected:
     request_with_state(
         const completion_handler& on_complete,
         file* file, void* buffer, offset_type offset, size_type bytes,
-        read_or_write op)
-        : request_with_waiters(on_complete, file, buffer, offset, bytes, op),
-          state_(OP)
-    { }
+        read_or_write op, priority_class priority = DEMAND);
 
 public:
     virtual ~request_with_state();
@@ -43,8 +43,8 @@ public:
     request_with_waiters(
         const completion_handler& on_complete,
         file* file, void* buffer, offset_type offset, size_type bytes,
-        read_or_write op)
-        : request(on_complete, file, buffer, offset, bytes, op)
+        read_or_write op, priority_class priority = DEMAND)
+        : request(on_complete, file, buffer, offset, bytes, op, priority)
     { }
 };
 
@@ -11,6 +11,7 @@
  *  http://www.boost.org/LICENSE_1_0.txt)
  **************************************************************************/
 
+#include <algorithm>
 #include <iomanip>
 
 #include <foxxll/common/exceptions.hpp>
@@ -25,9 +26,18 @@ namespace foxxll {
 serving_request::serving_request(
     const completion_handler& on_cmpl,
     file* file, void* buffer, offset_type offset, size_type bytes,
-    read_or_write op)
-    : request_with_state(on_cmpl, file, buffer, offset, bytes, op)
+    read_or_write op, priority_class priority)
+    : serving_request(on_cmpl, file, buffer, offset, bytes, op,
+                      file->get_queue_id(), priority)
+{ }
+
+serving_request::serving_request(
+    const completion_handler& on_cmpl,
+    file* file, void* buffer, offset_type offset, size_type bytes,
+    read_or_write op, int queue_id, priority_class priority)
+    : request_with_state(on_cmpl, file, buffer, offset, bytes, op, priority)
 {
+    queue_id_ = queue_id;
 #ifdef FOXXLL_CHECK_BLOCK_ALIGNING
     // Direct I/O requires file system block size alignment for file offsets,
     // memory buffer addresses, and transfer(buffer) size must be multiple
@@ -49,7 +59,15 @@ void serving_request::serve()
 
     try
     {
-        file_->serve(buffer_, offset_, bytes_, op_);
+        if (op_ == READ && file_->eof_truncate())
+        {
+            // transfer only the bytes up to the end of the file
+            const offset_type size = file_->size();
+            transferred_ = offset_ < size ? static_cast<size_type>(
+                std::min<offset_type>(bytes_, size - offset_)) : 0;
+        }
+        if (transferred_ > 0)
+            file_->serve(buffer_, offset_, transferred_, op_);
     }
     catch (const io_error& ex)
     {
@@ -61,6 +79,14 @@ void serving_request::serve()
     completed(false);
 }
 
+void serving_request::drop()
+{
+    LOG << "serving_request[" << static_cast<void*>(this) << "]::drop()";
+
+    file_->get_file_stats()->read_dropped(bytes_);
+    completed(true);
+}
+
 const char* serving_request::io_type() const
 {
     return file_->io_type();
@@ -33,14 +33,26 @@ class serving_request : public request_with_state
     friend class request_queue_impl_1q;
 
 public:
+    //! Constructs a request served by the file's queue.
     serving_request(
         const completion_handler& on_complete,
         file* file, void* buffer, offset_type offset, size_type bytes,
-        read_or_write op);
+        read_or_write op, priority_class priority = DEMAND);
+
+    //! Constructs a request served by the queue queue_id, which must serve
+    //! serving_requests.
+    serving_request(
+        const completion_handler& on_complete,
+        file* file, void* buffer, offset_type offset, size_type bytes,
+        read_or_write op, int queue_id, priority_class priority = DEMAND);
 
 protected:
     virtual void serve();
 
+    //! Completes the request as canceled without serving it, used by the
+    //! disk queue for expired prefetches.
+    void drop();
+
 public:
     const char * io_type() const final;
 };
@@ -12,9 +12,13 @@
  *  http://www.boost.org/LICENSE_1_0.txt)
  **************************************************************************/
 
+#include <atomic>
+#include <cerrno>
 #include <limits>
 #include <mutex>
 
+#include <tlx/unused.hpp>
+
 #include <foxxll/common/error_handling.hpp>
 #include <foxxll/config.hpp>
 #include <foxxll/io/iostats.hpp>
@@ -23,20 +27,63 @@
 #include <foxxll/io/syscall_file.hpp>
 #include <foxxll/io/ufs_platform.hpp>
 
+#if FOXXLL_HAVE_RWF_HIPRI
+ #include <sys/uio.h>
+#endif
+
 namespace foxxll {
 
+#if !FOXXLL_WINDOWS
+//! pread() or pwrite(), polling for the completion (RWF_HIPRI) if poll is set
+//! and hipri, which is cleared if the kernel does not support it.
+static ssize_t positional_io(
+    int fd, char* buffer, size_t bytes, off_t offset,
+    request::read_or_write op, bool poll, std::atomic<bool>& hipri)
+{
+#if FOXXLL_HAVE_RWF_HIPRI
+    if (poll && hipri.load(std::memory_order_relaxed))
+    {
+        iovec iov = { buffer, bytes };
+        ssize_t rc = (op == request::READ)
+                     ? ::preadv2(fd, &iov, 1, offset, RWF_HIPRI)
+                     : ::pwritev2(fd, &iov, 1, offset, RWF_HIPRI);
+        if (rc >= 0 || (errno != EOPNOTSUPP && errno != ENOSYS))
+            return rc;
+        hipri = false;
+    }
+#else
+    tlx::unused(poll);
+    tlx::unused(hipri);
+#endif
+    return (op == request::READ) ? ::pread(fd, buffer, bytes, offset)
+           : ::pwrite(fd, buffer, bytes, offset);
+}
+#endif
+
 void syscall_file::serve(void* buffer, offset_type offset, size_type bytes,
                          request::read_or_write op)
 {
+    if (_is_unaligned(buffer, offset, bytes))
+        return _serve_unaligned(buffer, offset, bytes, op);
+
+#if FOXXLL_WINDOWS
+    // without positional I/O the file pointer is shared by all requests
     std::unique_lock<std::mutex> fd_lock(fd_mutex_);
+#endif
 
     auto* cbuffer = static_cast<char*>(buffer);
 
     file_stats::scoped_read_write_timer read_write_timer(
         file_stats_, bytes, op == request::WRITE);
 
+#if !FOXXLL_WINDOWS
+    // polled I/O only helps direct I/O
+    const bool poll = poll_budget_ > 0.0 && need_alignment_;
+#endif
+
     while (bytes > 0)
     {
+#if FOXXLL_WINDOWS
         off_t rc = ::lseek(file_des_, offset, SEEK_SET);
         if (rc < 0)
         {
@@ -53,20 +100,26 @@ void syscall_file::serve(void* buffer, offset_type offset, size_type bytes,
                     " rc=" << rc
             );
         }
+#else
+        ssize_t rc;
+#endif
 
         if (op == request::READ)
         {
 #if FOXXLL_MSVC
             assert(bytes <= std::numeric_limits<unsigned int>::max());
             if ((rc = ::read(file_des_, cbuffer, (unsigned int)bytes)) <= 0)
-#else
+#elif FOXXLL_WINDOWS
             if ((rc = ::read(file_des_, cbuffer, bytes)) <= 0)
+#else
+            if ((rc = positional_io(file_des_, cbuffer, bytes, offset,
+                                    op, poll, hipri_)) <= 0)
 #endif
             {
                 FOXXLL_THROW_ERRNO(
                     io_error,
                     " this=" << this <<
-                        " call=::read(fd,buffer,bytes)" <<
+                        " call=::pread(fd,buffer,bytes,offset)" <<
                         " path=" << filename_ <<
                         " fd=" << file_des_ <<
                         " offset=" << offset <<
@@ -93,14 +146,17 @@ void syscall_file::serve(void* buffer, offset_type offset, size_type bytes,
 #if FOXXLL_MSVC
             assert(bytes <= std::numeric_limits<unsigned int>::max());
             if ((rc = ::write(file_des_, cbuffer, (unsigned int)bytes)) <= 0)
-#else
+#elif FOXXLL_WINDOWS
             if ((rc = ::write(file_des_, cbuffer, bytes)) <= 0)
+#else
+            if ((rc = positional_io(file_des_, cbuffer, bytes, offset,
+                                    op, poll, hipri_)) <= 0)
 #endif
             {
                 FOXXLL_THROW_ERRNO(
                     io_error,
                     " this=" << this <<
-                        " call=::write(fd,buffer,bytes)" <<
+                        " call=::pwrite(fd,buffer,bytes,offset)" <<
                         " path=" << filename_ <<
                         " fd=" << file_des_ <<
                         " offset=" << offset <<
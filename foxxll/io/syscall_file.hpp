@@ -16,6 +16,7 @@
 #ifndef FOXXLL_IO_SYSCALL_FILE_HEADER
 #define FOXXLL_IO_SYSCALL_FILE_HEADER
 
+#include <atomic>
 #include <string>
 
 #include <foxxll/io/disk_queued_file.hpp>
@@ -29,6 +30,9 @@ namespace foxxll {
 //! Implementation of file based on UNIX syscalls.
 class syscall_file final : public ufs_file_base, public disk_queued_file
 {
+    //! whether the kernel accepts polled I/O, cleared on the first rejection
+    std::atomic<bool> hipri_ { true };
+
 public:
     //! Constructs file object.
     //! \param filename path of file
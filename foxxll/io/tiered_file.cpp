@@ -0,0 +1,619 @@
+/***************************************************************************
+ *  foxxll/io/tiered_file.cpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <limits>
+
+#include <tlx/logger.hpp>
+
+#include <foxxll/common/aligned_alloc.hpp>
+#include <foxxll/common/error_handling.hpp>
+#include <foxxll/common/exceptions.hpp>
+#include <foxxll/io/tiered_file.hpp>
+
+namespace foxxll {
+
+/******************************************************************************/
+// hot_tier
+
+constexpr size_t hot_tier::default_segment_size;
+constexpr size_t hot_tier::max_moves;
+constexpr unsigned hot_tier::min_heat;
+constexpr size_t hot_tier::no_slot;
+constexpr size_t hot_tier::num_shards;
+
+hot_tier::hot_tier(const file_ptr& cache, offset_type size,
+                   size_t segment_size, double interval)
+    : cache_(cache),
+      segment_size_(segment_size),
+      slots_(static_cast<size_t>(size / segment_size)),
+      buffer_(nullptr),
+      interval_(interval)
+{
+    FOXXLL_THROW_IF(segment_size_ == 0 || segment_size_ % BlockAlignment != 0,
+                    std::invalid_argument,
+                    "hot tier segment size " << segment_size_ <<
+                    " is not a multiple of " << BlockAlignment);
+    FOXXLL_THROW_IF(slots_.empty(), std::invalid_argument,
+                    "hot tier of " << size << " bytes is smaller than one "
+                    "segment of " << segment_size_ << " bytes");
+
+    cache_->set_size(slots_.size() * segment_size_);
+
+    free_slots_.reserve(slots_.size());
+    for (size_t s = slots_.size(); s > 0; --s)
+        free_slots_.push_back(s - 1);
+
+    buffer_ = static_cast<char*>(aligned_alloc<BlockAlignment>(segment_size_));
+
+    if (interval_ > 0)
+        thread_ = std::thread(&hot_tier::run, this);
+}
+
+hot_tier::~hot_tier()
+{
+    if (thread_.joinable())
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    assert(files_.empty());
+
+    LOG << "hot_tier: hits=" << hits_.load() << " misses=" << misses_.load() <<
+        " promotions=" << promotions_ << " evictions=" << evictions_ <<
+        " writebacks=" << writebacks_;
+
+    aligned_dealloc<BlockAlignment>(buffer_);
+}
+
+size_t hot_tier::used_slots() const
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return slots_.size() - free_slots_.size();
+}
+
+uint64_t hot_tier::hits() const
+{
+    return hits_.load();
+}
+
+uint64_t hot_tier::misses() const
+{
+    return misses_.load();
+}
+
+uint64_t hot_tier::promotions() const
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return promotions_;
+}
+
+uint64_t hot_tier::evictions() const
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return evictions_;
+}
+
+uint64_t hot_tier::writebacks() const
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    return writebacks_;
+}
+
+void hot_tier::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (!stop_)
+    {
+        cv_.wait_for(lock, std::chrono::duration<double>(interval_),
+                     [this]() { return stop_; });
+        if (stop_)
+            break;
+
+        lock.unlock();
+        migrate();
+        lock.lock();
+    }
+}
+
+void hot_tier::attach(tiered_file* f)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    files_.push_back(f);
+}
+
+hot_tier::shard& hot_tier::shard_of(tiered_file* f, offset_type seg)
+{
+    return f->shards_[seg % num_shards];
+}
+
+void hot_tier::detach(tiered_file* f, bool write_back)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // wait for a running migration, none can start while the mutex is held,
+    // hence the bounce buffer is free.
+    cv_.wait(lock, [this]() { return busy_file_ == nullptr; });
+
+    files_.erase(std::find(files_.begin(), files_.end(), f));
+
+    for (size_t s = 0; s < slots_.size(); ++s)
+    {
+        if (slots_[s].file != f)
+            continue;
+
+        const offset_type seg = slots_[s].seg;
+        shard& sh = shard_of(f, seg);
+        std::unique_lock<std::mutex> shard_lock(sh.mutex);
+
+        if (write_back && sh.segments[seg].dirty)
+        {
+            try {
+                copy(f, seg, s, false);
+                ++writebacks_;
+            }
+            catch (const io_error& e) {
+                LOG1 << "hot_tier: error writing back segment " <<
+                    seg << " of " << f << ": " << e.what();
+            }
+        }
+
+        slots_[s].file = nullptr;
+        free_slots_.push_back(s);
+        ++evictions_;
+    }
+}
+
+void hot_tier::drop(segment& s)
+{
+    slots_[s.slot].file = nullptr;
+    free_slots_.push_back(s.slot);
+    s.slot = no_slot;
+    s.dirty = false;
+    ++evictions_;
+}
+
+void hot_tier::discard(tiered_file* f, offset_type offset, offset_type size)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // no migration may copy the range while it is discarded
+    cv_.wait(lock, [this]() { return busy_file_ == nullptr; });
+
+    const offset_type end = offset + size;
+    for (shard& sh : f->shards_)
+    {
+        std::unique_lock<std::mutex> shard_lock(sh.mutex);
+
+        for (auto& it : sh.segments)
+        {
+            segment& s = it.second;
+            const offset_type seg_begin = it.first * segment_size_;
+            const offset_type seg_end = seg_begin + segment_size_;
+            if (s.slot == no_slot || seg_end <= offset || seg_begin >= end)
+                continue;
+
+            if (seg_begin >= offset && seg_end <= end) {
+                drop(s);
+            }
+            else {
+                const offset_type begin = std::max(offset, seg_begin);
+                cache_->discard(s.slot * segment_size_ + (begin - seg_begin),
+                                std::min(end, seg_end) - begin);
+            }
+        }
+    }
+
+    f->base_->discard(offset, size);
+}
+
+void hot_tier::set_size(tiered_file* f, offset_type newsize)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    // wait for a running migration, none can start while the mutex is held,
+    // hence the bounce buffer is free.
+    cv_.wait(lock, [this]() { return busy_file_ == nullptr; });
+
+    for (shard& sh : f->shards_)
+    {
+        std::unique_lock<std::mutex> shard_lock(sh.mutex);
+
+        for (auto& it : sh.segments)
+        {
+            segment& s = it.second;
+            const offset_type seg_begin = it.first * segment_size_;
+            if (s.slot == no_slot || seg_begin + segment_size_ <= newsize)
+                continue;
+
+            // keep the part before the new end, which is truncated below
+            if (seg_begin < newsize && s.dirty)
+            {
+                copy(f, it.first, s.slot, false);
+                ++writebacks_;
+            }
+
+            drop(s);
+        }
+    }
+
+    f->base_->set_size(newsize);
+}
+
+size_t hot_tier::begin_io(
+    tiered_file* f, offset_type seg, request::read_or_write op)
+{
+    shard& sh = shard_of(f, seg);
+    std::unique_lock<std::mutex> lock(sh.mutex);
+
+    for ( ; ; )
+    {
+        // look up again after waiting, aging may have dropped the entry
+        segment& s = sh.segments[seg];
+        if (!s.migrating)
+        {
+            if (s.heat != std::numeric_limits<unsigned>::max())
+                ++s.heat;
+            ++s.inflight;
+
+            if (s.slot == no_slot) {
+                ++misses_;
+            }
+            else {
+                ++hits_;
+                if (op == request::WRITE)
+                    s.dirty = true;
+            }
+            return s.slot;
+        }
+        sh.cv.wait(lock);
+    }
+}
+
+void hot_tier::end_io(tiered_file* f, offset_type seg)
+{
+    shard& sh = shard_of(f, seg);
+    std::unique_lock<std::mutex> lock(sh.mutex);
+
+    segment& s = sh.segments[seg];
+    assert(s.inflight > 0);
+    if (--s.inflight == 0 && s.migrating) {
+        lock.unlock();
+        sh.cv.notify_all();
+    }
+}
+
+bool hot_tier::start_move(tiered_file* f, offset_type seg)
+{
+    if (std::find(files_.begin(), files_.end(), f) == files_.end())
+        return false;
+
+    shard& sh = shard_of(f, seg);
+    std::unique_lock<std::mutex> shard_lock(sh.mutex);
+
+    segment& s = sh.segments[seg];
+    if (s.migrating)
+        return false;
+
+    s.migrating = true;
+    busy_file_ = f;
+
+    // I/Os only lock the shard, they finish while the mutex_ is held
+    sh.cv.wait(shard_lock, [&]() { return sh.segments[seg].inflight == 0; });
+    return true;
+}
+
+void hot_tier::finish_move(tiered_file* f, offset_type seg)
+{
+    shard& sh = shard_of(f, seg);
+    {
+        std::unique_lock<std::mutex> shard_lock(sh.mutex);
+        sh.segments[seg].migrating = false;
+    }
+    sh.cv.notify_all();
+
+    busy_file_ = nullptr;
+    cv_.notify_all();
+}
+
+void hot_tier::copy(tiered_file* f, offset_type seg, size_t s, bool to_cache)
+{
+    const offset_type cache_offset = s * segment_size_;
+    const offset_type base_offset = seg * segment_size_;
+
+    if (to_cache) {
+        f->base_->serve(buffer_, base_offset, segment_size_, request::READ);
+        cache_->serve(buffer_, cache_offset, segment_size_, request::WRITE);
+    }
+    else {
+        cache_->serve(buffer_, cache_offset, segment_size_, request::READ);
+        f->base_->serve(buffer_, base_offset, segment_size_, request::WRITE);
+    }
+}
+
+bool hot_tier::promote(tiered_file* f, offset_type seg)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    if (free_slots_.empty() || !start_move(f, seg))
+        return false;
+
+    shard& sh = shard_of(f, seg);
+    std::unique_lock<std::mutex> shard_lock(sh.mutex);
+
+    if (sh.segments[seg].slot != no_slot ||
+        seg >= f->base_->size() / segment_size_) {
+        shard_lock.unlock();
+        finish_move(f, seg);
+        return false;
+    }
+
+    const size_t s = free_slots_.back();
+    free_slots_.pop_back();
+
+    shard_lock.unlock();
+    lock.unlock();
+
+    bool ok = true;
+    try {
+        copy(f, seg, s, true);
+    }
+    catch (const io_error& e) {
+        LOG1 << "hot_tier: error promoting segment " << seg <<
+            " of " << f << ": " << e.what();
+        ok = false;
+    }
+
+    lock.lock();
+
+    if (ok) {
+        shard_lock.lock();
+        segment& sg = sh.segments[seg];
+        sg.slot = s;
+        sg.dirty = false;
+        shard_lock.unlock();
+
+        slots_[s].file = f;
+        slots_[s].seg = seg;
+        ++promotions_;
+    }
+    else {
+        free_slots_.push_back(s);
+    }
+
+    finish_move(f, seg);
+    return ok;
+}
+
+bool hot_tier::evict(size_t s)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    tiered_file* f = slots_[s].file;
+    if (f == nullptr)
+        return false;
+
+    const offset_type seg = slots_[s].seg;
+    if (!start_move(f, seg))
+        return false;
+
+    shard& sh = shard_of(f, seg);
+    std::unique_lock<std::mutex> shard_lock(sh.mutex);
+
+    bool ok = true;
+    if (sh.segments[seg].dirty)
+    {
+        shard_lock.unlock();
+        lock.unlock();
+        try {
+            copy(f, seg, s, false);
+        }
+        catch (const io_error& e) {
+            LOG1 << "hot_tier: error writing back segment " << seg <<
+                " of " << f << ": " << e.what();
+            ok = false;
+        }
+        lock.lock();
+        shard_lock.lock();
+        if (ok)
+            ++writebacks_;
+    }
+
+    if (ok) {
+        segment& sg = sh.segments[seg];
+        sg.slot = no_slot;
+        sg.dirty = false;
+        slots_[s].file = nullptr;
+        free_slots_.push_back(s);
+        ++evictions_;
+    }
+
+    shard_lock.unlock();
+    finish_move(f, seg);
+    return ok;
+}
+
+size_t hot_tier::migrate()
+{
+    struct candidate
+    {
+        tiered_file* file;
+        offset_type seg;
+        unsigned heat;
+    };
+
+    std::vector<candidate> hot;
+    // cached segments as pairs (heat, slot)
+    std::vector<std::pair<unsigned, size_t> > cold;
+    std::vector<std::pair<candidate, size_t> > plan;
+
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+
+        // uncached segments worth promoting, only segments which are
+        // completely inside the slow file are migrated. I/O continues on the
+        // shards which are not being scanned.
+        for (tiered_file* f : files_)
+        {
+            const offset_type num_segments = f->base_->size() / segment_size_;
+            for (shard& sh : f->shards_)
+            {
+                std::unique_lock<std::mutex> shard_lock(sh.mutex);
+                for (const auto& it : sh.segments)
+                {
+                    if (it.second.slot == no_slot &&
+                        it.second.heat >= min_heat && it.first < num_segments)
+                        hot.push_back(candidate { f, it.first, it.second.heat });
+                }
+            }
+        }
+
+        const size_t num_hot = std::min(hot.size(), max_moves);
+        std::partial_sort(
+            hot.begin(), hot.begin() + num_hot, hot.end(),
+            [](const candidate& a, const candidate& b) {
+                return a.heat > b.heat;
+            });
+        hot.resize(num_hot);
+
+        for (size_t s = 0; s < slots_.size(); ++s)
+        {
+            if (!slots_[s].file)
+                continue;
+            shard& sh = shard_of(slots_[s].file, slots_[s].seg);
+            std::unique_lock<std::mutex> shard_lock(sh.mutex);
+            cold.emplace_back(sh.segments[slots_[s].seg].heat, s);
+        }
+        std::sort(cold.begin(), cold.end());
+
+        // fill free slots first, then replace segments with less than half
+        // the heat, to avoid thrashing between similarly hot segments
+        size_t free_slots = free_slots_.size(), next_cold = 0;
+        for (const candidate& c : hot)
+        {
+            if (free_slots > 0) {
+                plan.emplace_back(c, no_slot);
+                --free_slots;
+            }
+            else if (next_cold < cold.size() &&
+                     2 * cold[next_cold].first < c.heat) {
+                plan.emplace_back(c, cold[next_cold++].second);
+            }
+            else {
+                break;
+            }
+        }
+
+        // age access counters, forget idle uncached segments
+        for (tiered_file* f : files_)
+        {
+            for (shard& sh : f->shards_)
+            {
+                std::unique_lock<std::mutex> shard_lock(sh.mutex);
+                for (auto it = sh.segments.begin(); it != sh.segments.end(); )
+                {
+                    segment& s = it->second;
+                    s.heat /= 2;
+                    if (s.heat == 0 && s.slot == no_slot &&
+                        s.inflight == 0 && !s.migrating)
+                        it = sh.segments.erase(it);
+                    else
+                        ++it;
+                }
+            }
+        }
+    }
+
+    size_t promoted = 0;
+    for (const auto& p : plan)
+    {
+        if (p.second != no_slot && !evict(p.second))
+            continue;
+        if (promote(p.first.file, p.first.seg))
+            ++promoted;
+    }
+
+    LOG << "hot_tier::migrate() promoted " << promoted << " segments";
+    return promoted;
+}
+
+/******************************************************************************/
+// tiered_file
+
+tiered_file::tiered_file(
+    const file_ptr& base, const tlx::counting_ptr<hot_tier>& tier,
+    bool write_back)
+    : file(base->get_device_id(), base->get_file_stats()),
+      disk_queued_file(base->get_queue_id(), base->get_allocator_id()),
+      base_(base),
+      tier_(tier),
+      write_back_(write_back)
+{
+    inherit_alignment(*base_);
+    tier_->attach(this);
+}
+
+tiered_file::~tiered_file()
+{
+    tier_->detach(this, write_back_);
+}
+
+void tiered_file::serve(void* buffer, offset_type offset, size_type bytes,
+                        request::read_or_write op)
+{
+    const size_t segment_size = tier_->segment_size();
+    char* cbuffer = static_cast<char*>(buffer);
+
+    // split request at segment boundaries
+    while (bytes > 0)
+    {
+        const offset_type seg = offset / segment_size;
+        const offset_type seg_offset = offset % segment_size;
+        const size_type len = static_cast<size_type>(
+            std::min<offset_type>(bytes, segment_size - seg_offset));
+
+        const size_t s = tier_->begin_io(this, seg, op);
+        try {
+            if (s == hot_tier::no_slot)
+                base_->serve(cbuffer, offset, len, op);
+            else
+                tier_->cache_->serve(
+                    cbuffer, s * segment_size + seg_offset, len, op);
+        }
+        catch (...) {
+            tier_->end_io(this, seg);
+            throw;
+        }
+        tier_->end_io(this, seg);
+
+        cbuffer += len;
+        offset += len;
+        bytes -= len;
+    }
+}
+
+const char* tiered_file::io_type() const
+{
+    return "tiered";
+}
+
+} // namespace foxxll
+
+/**************************************************************************/
@@ -0,0 +1,295 @@
+/***************************************************************************
+ *  foxxll/io/tiered_file.hpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef FOXXLL_IO_TIERED_FILE_HEADER
+#define FOXXLL_IO_TIERED_FILE_HEADER
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <tlx/counting_ptr.hpp>
+
+#include <foxxll/io/disk_queued_file.hpp>
+#include <foxxll/io/file.hpp>
+
+namespace foxxll {
+
+//! \addtogroup foxxll_fileimpl
+//! \{
+
+class tiered_file;
+
+/*!
+ * Hot tier of a tiered storage setup: a small, fast (flash) file which caches
+ * the most frequently accessed segments of one or more slow files.
+ *
+ * The slow files are wrapped in tiered_file objects, which count the accesses
+ * of each fixed-size segment and redirect I/O on cached segments to the hot
+ * tier. A background thread periodically halves all access counters and
+ * migrates the hottest uncached segments into free cache slots, or into the
+ * slots of cached segments which are much colder. Segments written while
+ * cached are written back to the slow file on eviction.
+ *
+ * Migration is transparent to the holders of a BID: the offset of a block in
+ * its tiered_file never changes, I/O on a segment which is being migrated
+ * waits until the migration has finished.
+ *
+ * The segments of each tiered_file are striped over num_shards shards with
+ * their own locks. I/O only locks the shard of its segment, the migration
+ * thread locks one shard at a time while it scans the access counters.
+ */
+class hot_tier : public tlx::reference_counter
+{
+    constexpr static bool debug = false;
+
+public:
+    using offset_type = file::offset_type;
+
+    //! default migration granularity
+    static constexpr size_t default_segment_size = 4 * 1024 * 1024;
+
+    //! maximum number of segments promoted per migration round
+    static constexpr size_t max_moves = 8;
+
+    //! minimum (aged) access count of a segment to be promoted
+    static constexpr unsigned min_heat = 2;
+
+    //! marks an uncached segment
+    static constexpr size_t no_slot = size_t(-1);
+
+    //! number of lock shards of the segments of each tiered_file
+    static constexpr size_t num_shards = 16;
+
+    //! Constructs a hot tier in the cache file.
+    //! \param cache file to hold the cached segments, resized to size
+    //! \param size capacity of the hot tier in bytes
+    //! \param segment_size migration granularity, multiple of BlockAlignment
+    //! \param interval seconds between migration rounds of the background
+    //! thread, 0 = no background thread, call migrate() explicitly
+    hot_tier(const file_ptr& cache, offset_type size,
+             size_t segment_size = default_segment_size,
+             double interval = 0.1);
+
+    //! non-copyable: delete copy-constructor
+    hot_tier(const hot_tier&) = delete;
+    //! non-copyable: delete assignment operator
+    hot_tier& operator = (const hot_tier&) = delete;
+
+    ~hot_tier();
+
+    size_t segment_size() const { return segment_size_; }
+
+    //! Returns the number of cache slots.
+    size_t num_slots() const { return slots_.size(); }
+
+    //! Returns the number of cache slots holding a segment.
+    size_t used_slots() const;
+
+    //! Runs one migration round: promotes the hottest uncached segments, and
+    //! then ages the access counters.
+    //! \return number of promoted segments
+    size_t migrate();
+
+    //! \name Statistics
+    //! \{
+
+    //! number of segment accesses served by the hot tier
+    uint64_t hits() const;
+
+    //! number of segment accesses served by the slow files
+    uint64_t misses() const;
+
+    //! number of segments copied into the hot tier
+    uint64_t promotions() const;
+
+    //! number of segments removed from the hot tier
+    uint64_t evictions() const;
+
+    //! number of dirty segments written back to the slow files
+    uint64_t writebacks() const;
+
+    //! \}
+
+private:
+    friend class tiered_file;
+
+    //! access state of a segment of a tiered_file
+    struct segment
+    {
+        //! access counter, halved each migration round
+        unsigned heat = 0;
+        //! cache slot holding the segment, or no_slot
+        size_t slot = no_slot;
+        //! number of I/Os currently served on the segment
+        unsigned inflight = 0;
+        //! whether the segment is being promoted or evicted
+        bool migrating = false;
+        //! whether the cached segment was written
+        bool dirty = false;
+    };
+
+    //! segments of a tiered_file whose numbers are congruent modulo
+    //! num_shards
+    struct shard
+    {
+        //! protects the segments, taken after the hot_tier's mutex_
+        std::mutex mutex;
+        //! signaled on the end of I/Os and migrations of the segments
+        std::condition_variable cv;
+        std::unordered_map<offset_type, segment> segments;
+    };
+
+    //! owner of a cache slot
+    struct slot
+    {
+        tiered_file* file = nullptr;
+        offset_type seg = 0;
+    };
+
+    file_ptr cache_;
+    const size_t segment_size_;
+
+    //! protects the files, slots and counters, except for hits_ and misses_.
+    //! The segments are protected by the locks of their shards.
+    mutable std::mutex mutex_;
+    //! signaled on the end of migrations
+    std::condition_variable cv_;
+
+    std::vector<tiered_file*> files_;
+    std::vector<slot> slots_;
+    std::vector<size_t> free_slots_;
+
+    //! file of the segment being migrated, detach() waits for it
+    tiered_file* busy_file_ = nullptr;
+
+    //! bounce buffer of the migrations
+    char* buffer_;
+
+    std::atomic<uint64_t> hits_ { 0 }, misses_ { 0 };
+    uint64_t promotions_ = 0, evictions_ = 0, writebacks_ = 0;
+
+    const double interval_;
+    bool stop_ = false;
+    std::thread thread_;
+
+    //! main loop of the migration thread
+    void run();
+
+    //! called by tiered_file on construction and destruction
+    void attach(tiered_file* f);
+    void detach(tiered_file* f, bool write_back);
+
+    //! drop the cached segments of f inside the range without writing them
+    //! back, discard the rest of the range in the cache, then in the slow file
+    void discard(tiered_file* f, offset_type offset, offset_type size);
+    //! drop the cached segments of f behind newsize, a dirty segment
+    //! containing newsize is written back first, then resize the slow file
+    void set_size(tiered_file* f, offset_type newsize);
+
+    //! shard of a segment of f
+    static shard& shard_of(tiered_file* f, offset_type seg);
+
+    //! free the slot of a cached segment without writing it back, expects
+    //! the mutex_ and the segment's shard to be locked
+    void drop(segment& s);
+
+    //! start I/O on a segment, waits for a running migration
+    //! \return cache slot of the segment, or no_slot
+    size_t begin_io(tiered_file* f, offset_type seg, request::read_or_write op);
+    //! end I/O on a segment
+    void end_io(tiered_file* f, offset_type seg);
+
+    //! mark a segment as migrating and wait for its I/Os to finish, expects
+    //! the mutex_ to be locked
+    bool start_move(tiered_file* f, offset_type seg);
+    //! end the migration of a segment, expects the mutex_ to be locked
+    void finish_move(tiered_file* f, offset_type seg);
+
+    //! copy a segment into a free slot
+    bool promote(tiered_file* f, offset_type seg);
+    //! free a slot, writing its segment back if dirty
+    bool evict(size_t s);
+
+    //! copy between a cache slot and the slow file, mutex_ must not be held
+    //! unless no migration is running
+    void copy(tiered_file* f, offset_type seg, size_t s, bool to_cache);
+};
+
+/*!
+ * Slow file of a tiered storage setup, whose frequently accessed segments are
+ * cached by a hot_tier. Block offsets are those of the slow file, I/O on
+ * segments cached by the hot tier is redirected to it.
+ */
+class tiered_file final : public disk_queued_file
+{
+    constexpr static bool debug = false;
+
+public:
+    //! Wraps a slow file, which must be served synchronously (i.e. not
+    //! linuxaio or fileperblock).
+    //! \param base the slow file
+    //! \param tier the hot tier caching segments of base
+    //! \param write_back write dirty cached segments back to base when the
+    //! tiered_file is destroyed, may be disabled for files deleted on exit
+    tiered_file(const file_ptr& base, const tlx::counting_ptr<hot_tier>& tier,
+                bool write_back = true);
+
+    ~tiered_file();
+
+    void serve(void* buffer, offset_type offset, size_type bytes,
+               request::read_or_write op) final;
+
+    //! Sets the size of the slow file, cached segments behind the new end
+    //! are dropped.
+    void set_size(offset_type newsize) final
+    {
+        tier_->set_size(this, newsize);
+    }
+
+    offset_type size() final { return base_->size(); }
+
+    void lock() final { base_->lock(); }
+
+    //! Discards the range in the slow file and in the hot tier, cached
+    //! segments inside the range are dropped without being written back.
+    void discard(offset_type offset, offset_type size) final
+    {
+        tier_->discard(this, offset, size);
+    }
+
+    void close_remove() final { base_->close_remove(); }
+
+    const char * io_type() const final;
+
+private:
+    friend class hot_tier;
+
+    file_ptr base_;
+    tlx::counting_ptr<hot_tier> tier_;
+    const bool write_back_;
+
+    //! accessed segments, striped over the shards by segment number
+    hot_tier::shard shards_[hot_tier::num_shards];
+};
+
+//! \}
+
+} // namespace foxxll
+
+#endif // !FOXXLL_IO_TIERED_FILE_HEADER
+
+/**************************************************************************/
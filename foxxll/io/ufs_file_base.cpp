@@ -14,15 +14,27 @@
  *  http://www.boost.org/LICENSE_1_0.txt)
  **************************************************************************/
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
 #include <tlx/logger.hpp>
+#include <tlx/unused.hpp>
 
 #include <foxxll/common/error_handling.hpp>
 #include <foxxll/common/exceptions.hpp>
 #include <foxxll/config.hpp>
+#include <foxxll/io/bounce_buffer.hpp>
 #include <foxxll/io/file.hpp>
 #include <foxxll/io/ufs_file_base.hpp>
 #include <foxxll/io/ufs_platform.hpp>
 
+#if defined(__linux__)
+ #include <linux/fs.h>
+ #include <sys/ioctl.h>
+#endif
+
 namespace foxxll {
 
 const char* ufs_file_base::io_type() const
@@ -31,8 +43,10 @@ const char* ufs_file_base::io_type() const
 }
 
 ufs_file_base::ufs_file_base(const std::string& filename, int mode)
-    : file_des_(-1), mode_(mode), filename_(filename)
+    : file_des_(-1), mode_(mode), filename_(filename), discard_(true)
 {
+    eof_truncate_ = (mode & EOF_TRUNCATE) != 0;
+
     int flags = 0;
 
     if (mode & RDONLY)
@@ -148,6 +162,12 @@ void ufs_file_base::_after_open()
 #endif
     is_device_ = S_ISBLK(st.st_mode) ? true : false;
 
+#if FOXXLL_WINDOWS || defined(__MINGW32__)
+    _detect_alignment(0);
+#else
+    _detect_alignment(static_cast<size_t>(st.st_blksize));
+#endif
+
 #ifdef __APPLE__
     if (mode_ & REQUIRE_DIRECT) {
         FOXXLL_THROW_ERRNO_NE_0(
@@ -176,6 +196,48 @@ void ufs_file_base::_after_open()
         lock();
 }
 
+void ufs_file_base::_detect_alignment(size_t preferred_io_size)
+{
+#if defined(__linux__)
+    if (is_device_)
+    {
+        int logical = 0;
+        unsigned int physical = 0, optimal = 0;
+        if (::ioctl(file_des_, BLKSSZGET, &logical) == 0 && logical > 0)
+            logical_block_size_ = memory_alignment_ =
+                                      static_cast<size_t>(logical);
+        if (::ioctl(file_des_, BLKPBSZGET, &physical) == 0 && physical > 0)
+            physical_block_size_ = physical;
+        if (::ioctl(file_des_, BLKIOOPT, &optimal) == 0)
+            optimal_io_size_ = optimal;
+    }
+    else
+    {
+#if FOXXLL_HAVE_STATX_DIOALIGN
+        struct statx stx;
+        if (::statx(file_des_, "", AT_EMPTY_PATH, STATX_DIOALIGN, &stx) == 0 &&
+            (stx.stx_mask & STATX_DIOALIGN) && stx.stx_dio_offset_align != 0)
+        {
+            logical_block_size_ = stx.stx_dio_offset_align;
+            if (stx.stx_dio_mem_align != 0)
+                memory_alignment_ = stx.stx_dio_mem_align;
+        }
+#endif
+        // the file system's preferred I/O size, e.g. the stripe width of xfs
+        physical_block_size_ = logical_block_size_;
+        optimal_io_size_ = preferred_io_size;
+    }
+
+    LOG << "ufs_file_base: path=" << filename_ <<
+        " logical_block_size=" << logical_block_size_ <<
+        " physical_block_size=" << physical_block_size_ <<
+        " memory_alignment=" << memory_alignment_ <<
+        " optimal_io_size=" << optimal_io_size_;
+#else
+    tlx::unused(preferred_io_size);
+#endif
+}
+
 void ufs_file_base::close()
 {
     std::unique_lock<std::mutex> fd_lock(fd_mutex_);
@@ -183,6 +245,10 @@ void ufs_file_base::close()
     if (file_des_ == -1)
         return;
 
+    if (buffered_fd_ != -1 && ::close(buffered_fd_) < 0)
+        FOXXLL_THROW_ERRNO(io_error, "close() fd=" << buffered_fd_);
+    buffered_fd_ = -1;
+
     if (::close(file_des_) < 0)
         FOXXLL_THROW_ERRNO(io_error, "close() fd=" << file_des_);
 
@@ -261,10 +327,13 @@ void ufs_file_base::_set_size(offset_type newsize)
                     " newsize=" << newsize << " "
             );
 #else
-        FOXXLL_THROW_ERRNO_NE_0(
-            ::ftruncate(file_des_, newsize), io_error,
-            "ftruncate() path=" << filename_ << " fd=" << file_des_
-        );
+        if (newsize <= cur_size || !(mode_ & PREALLOC) || !_preallocate(cur_size, newsize))
+        {
+            FOXXLL_THROW_ERRNO_NE_0(
+                ::ftruncate(file_des_, newsize), io_error,
+                "ftruncate() path=" << filename_ << " fd=" << file_des_
+            );
+        }
 #endif
     }
 
@@ -277,6 +346,331 @@ void ufs_file_base::_set_size(offset_type newsize)
 #endif
 }
 
+bool ufs_file_base::_preallocate(offset_type cur_size, offset_type newsize)
+{
+#if FOXXLL_HAVE_FALLOCATE
+    // mode 0 allocates the range and extends the file size
+    if (::fallocate(file_des_, 0, cur_size, newsize - cur_size) == 0)
+        return true;
+
+    if (errno != EOPNOTSUPP && errno != ENOSYS)
+        FOXXLL_THROW_ERRNO(
+            io_error, "fallocate() path=" << filename_ << " fd=" << file_des_ <<
+                " offset=" << cur_size << " len=" << newsize - cur_size
+        );
+
+    LOG1 << "fallocate() not supported on path=" << filename_ <<
+        ", growing the file sparse.";
+#else
+    tlx::unused(cur_size, newsize);
+    LOG1 << "Preallocation not supported on this platform, growing path=" <<
+        filename_ << " sparse.";
+#endif
+    // do not try again
+    mode_ &= ~PREALLOC;
+    return false;
+}
+
+void ufs_file_base::discard(offset_type offset, offset_type size)
+{
+    std::unique_lock<std::mutex> fd_lock(fd_mutex_);
+
+    // preallocated files keep their blocks
+    if (!discard_ || (!is_device_ && (mode_ & PREALLOC)) || size == 0)
+        return;
+
+    int rc = -1;
+    errno = EOPNOTSUPP;
+
+#if defined(__linux__) && defined(BLKDISCARD)
+    if (is_device_)
+    {
+        // trim the range of the raw device
+        uint64_t range[2] = { offset, size };
+        rc = ::ioctl(file_des_, BLKDISCARD, &range);
+    }
+#endif
+#if FOXXLL_HAVE_FALLOCATE && defined(FALLOC_FL_PUNCH_HOLE)
+    if (!is_device_)
+    {
+        // deallocate the range in the file system, which trims it on the
+        // device if the file system is mounted with discard
+        rc = ::fallocate(file_des_, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                         offset, size);
+    }
+#endif
+
+    if (rc == 0)
+        return;
+
+    if (errno != EOPNOTSUPP && errno != ENOTTY && errno != ENOSYS)
+        FOXXLL_THROW_ERRNO(
+            io_error, "discard path=" << filename_ << " fd=" << file_des_ <<
+                " offset=" << offset << " len=" << size
+        );
+
+    LOG1 << "Discarding blocks not supported on path=" << filename_ << ".";
+    // do not try again
+    discard_ = false;
+}
+
+bool ufs_file_base::_is_unaligned(const void* buffer, offset_type offset,
+                                  size_type bytes) const
+{
+#if FOXXLL_WINDOWS
+    // files are not opened with O_DIRECT
+    tlx::unused(buffer, offset, bytes);
+    return false;
+#else
+    return need_alignment_ && (
+        offset % logical_block_size_ != 0 ||
+        bytes % logical_block_size_ != 0 ||
+        reinterpret_cast<size_t>(buffer) % memory_alignment_ != 0);
+#endif
+}
+
+void ufs_file_base::_serve_unaligned(
+    void* buffer, offset_type offset, size_type bytes,
+    request::read_or_write op)
+{
+    const offset_type block = logical_block_size_;
+    char* cbuffer = static_cast<char*>(buffer);
+
+    // the partial blocks of concurrent unaligned writes may overlap
+    std::unique_lock<std::mutex> lock(unaligned_mutex_, std::defer_lock);
+    if (op == request::WRITE)
+        lock.lock();
+
+    const offset_type core_begin = (offset + block - 1) / block * block;
+    const offset_type core_end = (offset + bytes) / block * block;
+
+    if (core_begin < core_end &&
+        reinterpret_cast<size_t>(cbuffer + (core_begin - offset)) %
+        memory_alignment_ == 0)
+    {
+        serve(cbuffer + (core_begin - offset), core_begin,
+              static_cast<size_type>(core_end - core_begin), op);
+        _serve_bounced(cbuffer, offset,
+                       static_cast<size_type>(core_begin - offset), op);
+        _serve_bounced(cbuffer + (core_end - offset), core_end,
+                       static_cast<size_type>(offset + bytes - core_end), op);
+    }
+    else
+    {
+        _serve_bounced(cbuffer, offset, bytes, op);
+    }
+}
+
+void ufs_file_base::_serve_bounced(
+    char* buffer, offset_type offset, size_type bytes,
+    request::read_or_write op)
+{
+    if (bytes == 0)
+        return;
+
+    static constexpr size_t max_bounce = 1024 * 1024;
+    const offset_type block = logical_block_size_;
+
+    bounce_buffer bounce(std::min<size_t>(
+                             max_bounce,
+                             (bytes + 2 * block - 1) / block * block),
+                         memory_alignment_);
+    const offset_type chunk = bounce.size() / block * block;
+
+    while (bytes > 0)
+    {
+        const offset_type begin = offset / block * block;
+        const offset_type end = std::min<offset_type>(
+            (offset + bytes + block - 1) / block * block, begin + chunk);
+        const size_type part = static_cast<size_type>(
+            std::min<offset_type>(bytes, end - offset));
+        const size_type len = static_cast<size_type>(end - begin);
+
+        if (op == request::READ)
+        {
+            serve(bounce.get(), begin, len, request::READ);
+            memcpy(buffer, bounce.get() + (offset - begin), part);
+        }
+        else
+        {
+            // read the partially written blocks, if they exist
+            const offset_type old_size = _size();
+            if (offset != begin) {
+                if (begin < old_size)
+                    serve(bounce.get(), begin, block, request::READ);
+                else
+                    memset(bounce.get(), 0, block);
+            }
+            if (offset + part != end && (offset == begin || len > block)) {
+                char* last = bounce.get() + (len - block);
+                if (end - block < old_size)
+                    serve(last, end - block, block, request::READ);
+                else
+                    memset(last, 0, block);
+            }
+
+            memcpy(bounce.get() + (offset - begin), buffer, part);
+            if (end > old_size && offset + part < end)
+            {
+                // the last block extends the file: only its written bytes go
+                // through the buffered descriptor. Truncating the padding
+                // afterwards would race with concurrent writes beyond
+                // old_size, which do not take unaligned_mutex_.
+                const offset_type last = end - block;
+                if (len > block)
+                    serve(bounce.get(), begin, len - block, request::WRITE);
+                _write_buffered(bounce.get() + (last - begin), last,
+                                static_cast<size_type>(offset + part - last));
+            }
+            else
+            {
+                serve(bounce.get(), begin, len, request::WRITE);
+            }
+        }
+
+        buffer += part;
+        offset += part;
+        bytes -= part;
+    }
+}
+
+void ufs_file_base::_write_buffered(
+    const char* buffer, offset_type offset, size_type bytes)
+{
+#if FOXXLL_WINDOWS
+    // files are not opened with O_DIRECT
+    tlx::unused(buffer, offset, bytes);
+#else
+    if (buffered_fd_ == -1)
+    {
+        std::unique_lock<std::mutex> fd_lock(fd_mutex_);
+        const int fd = ::open(filename_.c_str(), O_WRONLY);
+        if (fd < 0)
+            FOXXLL_THROW_ERRNO(io_error, "open() without O_DIRECT path=" << filename_);
+        buffered_fd_ = fd;
+    }
+
+    while (bytes > 0)
+    {
+        const ssize_t rc = ::pwrite(buffered_fd_, buffer, bytes,
+                                    static_cast<off_t>(offset));
+        if (rc < 0 && errno == EINTR)
+            continue;
+        if (rc <= 0)
+            FOXXLL_THROW_ERRNO(io_error, "pwrite() path=" << filename_ <<
+                               " fd=" << buffered_fd_ << " offset=" << offset <<
+                               " bytes=" << bytes);
+        buffer += rc;
+        offset += static_cast<offset_type>(rc);
+        bytes -= static_cast<size_type>(rc);
+    }
+#endif
+}
+
+void ufs_file_base::copy(offset_type offset, file* dst,
+                         offset_type dst_offset, size_type bytes)
+{
+    ufs_file_base* udst = dynamic_cast<ufs_file_base*>(dst);
+    if (udst && !is_device_ && !udst->is_device_ && bytes > 0 &&
+        _copy_offload(offset, udst, dst_offset, bytes))
+        return;
+
+    file::copy(offset, dst, dst_offset, bytes);
+}
+
+bool ufs_file_base::_copy_offload(offset_type offset, ufs_file_base* dst,
+                                  offset_type dst_offset, size_type bytes)
+{
+#if defined(__linux__) && (defined(FICLONERANGE) || FOXXLL_HAVE_COPY_FILE_RANGE)
+    if (!clone_ && !copy_range_)
+        return false;
+
+    file_stats* dst_stats = dst->get_file_stats();
+    file_stats_->read_started(bytes);
+    dst_stats->write_started(bytes);
+
+    bool done = false;
+    try {
+#if defined(FICLONERANGE)
+        if (clone_)
+        {
+            // share the extents, fails e.g. for ranges not aligned to the
+            // file system's blocks or across file systems
+            struct file_clone_range range;
+            range.src_fd = file_des_;
+            range.src_offset = offset;
+            range.src_length = bytes;
+            range.dest_offset = dst_offset;
+            if (::ioctl(dst->file_des_, FICLONERANGE, &range) == 0)
+                done = true;
+            else if (errno == EOPNOTSUPP || errno == ENOTTY || errno == ENOSYS)
+                clone_ = false;
+        }
+#endif
+#if FOXXLL_HAVE_COPY_FILE_RANGE
+        if (!done && copy_range_)
+        {
+            loff_t in = static_cast<loff_t>(offset);
+            loff_t out = static_cast<loff_t>(dst_offset);
+            size_type left = bytes;
+            while (left > 0)
+            {
+                ssize_t rc = ::copy_file_range(
+                    file_des_, &in, dst->file_des_, &out, left, 0);
+                if (rc > 0) {
+                    left -= static_cast<size_type>(rc);
+                    continue;
+                }
+                if (rc < 0 && errno == EINTR)
+                    continue;
+                FOXXLL_THROW_IF(rc == 0, io_error,
+                                "copy_file_range() reached the end of path=" <<
+                                filename_ << " at offset=" << in);
+                if (rc < 0 && left == bytes &&
+                    (errno == EXDEV || errno == EINVAL ||
+                     errno == EOPNOTSUPP || errno == ENOSYS))
+                {
+                    if (errno == EOPNOTSUPP || errno == ENOSYS)
+                        copy_range_ = false;
+                    break;
+                }
+                FOXXLL_THROW_ERRNO(
+                    io_error,
+                    " this=" << this <<
+                        " call=::copy_file_range(fd,offset,dst_fd,dst_offset,bytes)" <<
+                        " path=" << filename_ <<
+                        " dst_path=" << dst->filename_ <<
+                        " offset=" << in <<
+                        " dst_offset=" << out <<
+                        " bytes=" << left <<
+                        " rc=" << rc
+                );
+            }
+            done = (left == 0);
+        }
+#endif
+    }
+    catch (...) {
+        file_stats_->read_finished();
+        dst_stats->write_finished();
+        throw;
+    }
+
+    if (done) {
+        file_stats_->read_finished();
+        dst_stats->write_finished();
+    }
+    else {
+        file_stats_->read_canceled(bytes);
+        dst_stats->write_canceled(bytes);
+    }
+    return done;
+#else
+    tlx::unused(offset, dst, dst_offset, bytes);
+    return false;
+#endif
+}
+
 void ufs_file_base::close_remove()
 {
     close();
@@ -301,11 +695,48 @@ void ufs_file_base::unlink()
         FOXXLL_THROW_ERRNO(io_error, "unlink() path=" << filename_ << " fd=" << file_des_);
 }
 
+bool ufs_file_base::rename(const std::string& path)
+{
+    std::unique_lock<std::mutex> fd_lock(fd_mutex_);
+
+#if FOXXLL_HAVE_RENAMEAT2
+    if (::renameat2(AT_FDCWD, filename_.c_str(),
+                    AT_FDCWD, path.c_str(), RENAME_NOREPLACE) != 0)
+    {
+        if (errno == EEXIST)
+            return false;
+        if (errno != EINVAL && errno != ENOSYS)
+            FOXXLL_THROW_ERRNO(io_error, "renameat2() path=" << filename_ << " to=" << path);
+#endif
+        // the file system does not support RENAME_NOREPLACE, link() does
+        // not replace the target either
+        if (::link(filename_.c_str(), path.c_str()) != 0)
+        {
+            if (errno == EEXIST)
+                return false;
+            FOXXLL_THROW_ERRNO(io_error, "link() path=" << filename_ << " to=" << path);
+        }
+        if (::unlink(filename_.c_str()) != 0)
+            FOXXLL_THROW_ERRNO(io_error, "unlink() path=" << filename_);
+#if FOXXLL_HAVE_RENAMEAT2
+    }
+#endif
+
+    filename_ = path;
+    return true;
+}
+
 bool ufs_file_base::is_device() const
 {
     return is_device_;
 }
 
+bool ufs_file_base::discard_supported()
+{
+    std::unique_lock<std::mutex> fd_lock(fd_mutex_);
+    return discard_;
+}
+
 } // namespace foxxll
 
 /**************************************************************************/
@@ -18,6 +18,7 @@
 #ifndef FOXXLL_IO_UFS_FILE_BASE_HEADER
 #define FOXXLL_IO_UFS_FILE_BASE_HEADER
 
+#include <atomic>
 #include <mutex>
 #include <string>
 
@@ -31,29 +32,79 @@ namespace foxxll {
 //! Base for UNIX file system implementations.
 class ufs_file_base : public virtual file
 {
+    constexpr static bool debug = false;
+
 protected:
     std::mutex fd_mutex_; // sequentialize function calls involving file_des_
     int file_des_;        // file descriptor
     int mode_;            // open mode
-    const std::string filename_;
+    std::string filename_; // current path, changed by rename()
     bool is_device_;      //!< is special device node
+    bool discard_;        //!< whether discard() is supported
+    //! whether the file system may support cloning ranges
+    std::atomic<bool> clone_ { true };
+    //! whether copy_file_range() is supported
+    std::atomic<bool> copy_range_ { true };
+    //! serializes the read-modify-writes of unaligned writes
+    std::mutex unaligned_mutex_;
+    //! descriptor without O_DIRECT for the last bytes of unaligned writes
+    //! which extend the file, opened on first use under unaligned_mutex_
+    int buffered_fd_ = -1;
     ufs_file_base(const std::string& filename, int mode);
     void _after_open();
+    //! detect the alignment and preferred I/O size of the file or device
+    void _detect_alignment(size_t preferred_io_size);
     offset_type _size();
     void _set_size(offset_type newsize);
+    //! allocate the range [cur_size, newsize) of the file system and extend
+    //! the file, returns false if not supported by the file system.
+    bool _preallocate(offset_type cur_size, offset_type newsize);
     void close();
+    //! whether a request must be served by _serve_unaligned()
+    bool _is_unaligned(const void* buffer, offset_type offset,
+                       size_type bytes) const;
+    //! Serves a request which violates the alignment of direct I/O: the
+    //! aligned core is transferred directly if the buffer is aligned there,
+    //! the rest through bounce buffers, with a read-modify-write of partially
+    //! written logical blocks. Calls serve() with aligned requests only.
+    void _serve_unaligned(void* buffer, offset_type offset, size_type bytes,
+                          request::read_or_write op);
+    //! transfer a range through bounce buffers
+    void _serve_bounced(char* buffer, offset_type offset, size_type bytes,
+                        request::read_or_write op);
+    //! write a range through buffered_fd_, which needs no alignment
+    void _write_buffered(const char* buffer, offset_type offset,
+                         size_type bytes);
+    //! copy a range to dst by cloning it, or inside the kernel, returns
+    //! false if neither is supported and nothing was copied.
+    bool _copy_offload(offset_type offset, ufs_file_base* dst,
+                       offset_type dst_offset, size_type bytes);
 
 public:
     ~ufs_file_base();
     offset_type size() final;
     void set_size(offset_type newsize) final;
     void lock() final;
+    //! Punches a hole into regular files and trims the range of raw block
+    //! devices, where supported. Preallocated files keep their blocks.
+    void discard(offset_type offset, offset_type size) final;
+    //! Clones the range if both files are on a file system with reflinks
+    //! (FICLONERANGE), or copies it with copy_file_range(), before falling
+    //! back to file::copy().
+    void copy(offset_type offset, file* dst, offset_type dst_offset,
+              size_type bytes) override;
     const char * io_type() const override;
     void close_remove() final;
     //! unlink file without closing it.
     void unlink();
+    //! move the open file to path, later unlink() and close_remove() act on
+    //! the new path. Returns false, leaving the file in place, if path exists.
+    bool rename(const std::string& path);
     //! return true if file is special device node
     bool is_device() const;
+    //! return true unless discard() found that the file system or device does
+    //! not support it
+    bool discard_supported();
 };
 
 //! \}
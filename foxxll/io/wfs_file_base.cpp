@@ -123,6 +123,7 @@ wfs_file_base::wfs_file_base(const std::string& filename, int mode)
 {
     file_des_ = open_file_impl(filename, mode);
     need_alignment_ = (mode& file::DIRECT) != 0;
+    eof_truncate_ = (mode& file::EOF_TRUNCATE) != 0;
 
     if (!(mode & NO_LOCK))
     {
@@ -245,6 +246,22 @@ void wfs_file_base::close_remove()
     ::DeleteFileA(filename_.c_str());
 }
 
+bool wfs_file_base::rename(const std::string& path)
+{
+    std::unique_lock<std::mutex> fd_lock(fd_mutex_);
+
+    if (!::MoveFileExA(filename_.c_str(), path.c_str(), 0))
+    {
+        const DWORD error = ::GetLastError();
+        if (error == ERROR_ALREADY_EXISTS || error == ERROR_FILE_EXISTS)
+            return false;
+        FOXXLL_THROW_WIN_LASTERROR(io_error, "MoveFileEx() path=" << filename_ << " to=" << path);
+    }
+
+    filename_ = path;
+    return true;
+}
+
 } // namespace foxxll
 
 #endif // FOXXLL_WINDOWS
@@ -41,7 +41,7 @@ protected:
     std::mutex fd_mutex_;  // sequentialize function calls involving file_des_
     HANDLE file_des_;      // file descriptor
     int mode_;             // open mode
-    const std::string filename_;
+    std::string filename_; // current path, changed by rename()
     offset_type bytes_per_sector_;
     bool locked_;
     wfs_file_base(const std::string& filename, int mode);
@@ -55,6 +55,9 @@ public:
     void lock();
     const char * io_type() const;
     void close_remove();
+    //! move the open file to path, later close_remove() acts on the new path.
+    //! Returns false, leaving the file in place, if path exists.
+    bool rename(const std::string& path);
 };
 
 //! \}
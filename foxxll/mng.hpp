@@ -14,6 +14,7 @@
 #define FOXXLL_MNG_HEADER
 
 #include <foxxll/common/new_alloc.hpp>
+#include <foxxll/mng/block_alloc_strategy_dynamic.hpp>
 #include <foxxll/mng/block_manager.hpp>
 #include <foxxll/mng/typed_block.hpp>
 
@@ -17,7 +17,9 @@
 #ifndef FOXXLL_MNG_BID_HEADER
 #define FOXXLL_MNG_BID_HEADER
 
+#include <cassert>
 #include <cstring>
+#include <functional>
 #include <iomanip>
 #include <ostream>
 #include <sstream>
@@ -79,16 +81,18 @@ public:
 
     //! Writes data to the disk(s).
     request_ptr write(void* data, size_t data_size,
-                      completion_handler on_complete = completion_handler())
+                      completion_handler on_complete = completion_handler(),
+                      request::priority_class priority = request::DEMAND)
     {
-        return storage->awrite(data, offset, data_size, on_complete);
+        return storage->awrite(data, offset, data_size, on_complete, priority);
     }
 
     //! Reads data from the disk(s).
     request_ptr read(void* data, size_t data_size,
-                     completion_handler on_complete = completion_handler())
+                     completion_handler on_complete = completion_handler(),
+                     request::priority_class priority = request::DEMAND)
     {
-        return storage->aread(data, offset, data_size, on_complete);
+        return storage->aread(data, offset, data_size, on_complete, priority);
     }
 
     bool operator == (const BID<Size>& b) const
@@ -139,16 +143,18 @@ public:
 
     //! Writes data to the disk(s).
     request_ptr write(void* data, size_t data_size,
-                      completion_handler on_complete = completion_handler())
+                      completion_handler on_complete = completion_handler(),
+                      request::priority_class priority = request::DEMAND)
     {
-        return storage->awrite(data, offset, data_size, on_complete);
+        return storage->awrite(data, offset, data_size, on_complete, priority);
     }
 
     //! Reads data from the disk(s).
     request_ptr read(void* data, size_t data_size,
-                     completion_handler on_complete = completion_handler())
+                     completion_handler on_complete = completion_handler(),
+                     request::priority_class priority = request::DEMAND)
     {
-        return storage->aread(data, offset, data_size, on_complete);
+        return storage->aread(data, offset, data_size, on_complete, priority);
     }
 
     bool operator == (const BID<0>& b) const
@@ -194,9 +200,42 @@ std::ostream& operator << (std::ostream& s, const BID<BlockSize>& bid)
     return s;
 }
 
+//! Copies the block src to the block dst asynchronously, without passing the
+//! data through a user buffer. The copy is served by the disk queue of src,
+//! inside the kernel or by cloning the block where the files support it.
+template <size_t BlockSize>
+request_ptr copy_block(const BID<BlockSize>& src, const BID<BlockSize>& dst,
+                       completion_handler on_complete = completion_handler(),
+                       request::priority_class priority = request::DEMAND)
+{
+    assert(src.size == dst.size);
+    return src.storage->acopy(src.offset, dst.storage, dst.offset, src.size,
+                              on_complete, priority);
+}
+
 template <size_t BlockSize>
 using BIDArray = tlx::simple_vector<BID<BlockSize> >;
 
+//! Orders BIDs by the disk queue serving them, then by file and offset.
+//! Batches of requests submitted in this order reach each disk queue grouped
+//! together and in ascending offset order.
+struct bid_queue_order
+{
+    template <size_t BlockSize>
+    bool operator () (const BID<BlockSize>& a, const BID<BlockSize>& b) const
+    {
+        if (a.storage == b.storage)
+            return a.offset < b.offset;
+        if (!a.storage || !b.storage)
+            return std::less<file*>()(a.storage, b.storage);
+
+        int qa = a.storage->get_queue_id(), qb = b.storage->get_queue_id();
+        if (qa != qb)
+            return qa < qb;
+        return std::less<file*>()(a.storage, b.storage);
+    }
+};
+
 //! \}
 
 } // namespace foxxll
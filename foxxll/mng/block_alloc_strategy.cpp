@@ -0,0 +1,196 @@
+/***************************************************************************
+ *  foxxll/mng/block_alloc_strategy.cpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <foxxll/common/error_handling.hpp>
+#include <foxxll/mng/block_alloc_strategy.hpp>
+#include <foxxll/mng/block_alloc_strategy_dynamic.hpp>
+#include <foxxll/mng/block_manager.hpp>
+
+namespace foxxll {
+
+constexpr size_t load_balanced::weight_resolution;
+constexpr double load_balanced::busy_queue_length;
+
+void load_balanced::init(std::vector<size_t>& cycle) const
+{
+    block_manager* bm = block_manager::get_instance();
+
+    std::vector<block_manager::disk_load> load(diff_);
+    double sum_throughput = 0;
+    size_t num_measured = 0;
+    uint64_t max_free = 0;
+    for (size_t d = 0; d < diff_; ++d)
+    {
+        load[d] = bm->get_disk_load(begin_ + d);
+        if (load[d].throughput > 0) {
+            sum_throughput += load[d].throughput;
+            ++num_measured;
+        }
+        if (!load[d].autogrow)
+            max_free = std::max(max_free, load[d].free_bytes);
+    }
+    const double mean_throughput =
+        num_measured ? sum_throughput / num_measured : 1.0;
+
+    std::vector<double> weight(diff_);
+    double max_weight = 0;
+    for (size_t d = 0; d < diff_; ++d)
+    {
+        double w = load[d].throughput > 0 ? load[d].throughput
+                   : mean_throughput;
+        w /= 1.0 + load[d].queue_length / busy_queue_length;
+        if (!load[d].autogrow) {
+            w *= max_free ? static_cast<double>(load[d].free_bytes) /
+                 static_cast<double>(max_free) : 0.0;
+        }
+        weight[d] = w;
+        max_weight = std::max(max_weight, w);
+    }
+
+    // quantize weights, all disks are full: fall back to random_cyclic
+    std::vector<size_t> count(diff_);
+    size_t total = 0;
+    for (size_t d = 0; d < diff_; ++d)
+    {
+        if (max_weight <= 0)
+            count[d] = 1;
+        else if (weight[d] > 0)
+            count[d] = std::max<size_t>(
+                1, static_cast<size_t>(std::lround(
+                                           weight_resolution * weight[d] / max_weight)));
+        else
+            count[d] = 0;
+        total += count[d];
+    }
+
+    std::vector<size_t> perm(diff_);
+    for (size_t d = 0; d < diff_; ++d)
+        perm[d] = d;
+    std::shuffle(perm.begin(), perm.end(),
+                 std::default_random_engine { std::random_device { } () });
+
+    // smooth weighted round robin spreads each disk's entries evenly
+    std::vector<int64_t> current(diff_, 0);
+    cycle.clear();
+    cycle.reserve(total);
+    for (size_t k = 0; k < total; ++k)
+    {
+        size_t best = perm[0];
+        for (size_t j = 0; j < diff_; ++j)
+        {
+            const size_t d = perm[j];
+            current[d] += static_cast<int64_t>(count[d]);
+            if (current[d] > current[best])
+                best = d;
+        }
+        current[best] -= static_cast<int64_t>(total);
+        cycle.push_back(best);
+    }
+}
+
+/******************************************************************************/
+// dynamic_strategy
+
+using strategy_ptr = std::shared_ptr<const allocation_strategy_base>;
+
+//! number of disks a strategy allocates from
+static size_t num_disks(const striping& strategy)
+{
+    return strategy.diff_;
+}
+
+static size_t num_disks(const single_disk&)
+{
+    return 1;
+}
+
+//! returns nullptr if the strategy has no disks, e.g. random_cyclic_flash
+//! without flash devices
+template <typename Strategy>
+static strategy_ptr make_strategy(bool ranged, size_t begin, size_t end)
+{
+    Strategy strategy = ranged ? Strategy(begin, end) : Strategy();
+    if (num_disks(strategy) == 0)
+        return strategy_ptr();
+    return std::make_shared<allocation_strategy_adapter<Strategy> >(strategy);
+}
+
+static const struct {
+    const char* name;
+    strategy_ptr (* make)(bool ranged, size_t begin, size_t end);
+} strategy_table[] = {
+    { "striping", make_strategy<striping> },
+    { "fully_random", make_strategy<fully_random> },
+    { "simple_random", make_strategy<simple_random> },
+    { "random_cyclic", make_strategy<random_cyclic> },
+    { "random_cyclic_disk", make_strategy<random_cyclic_disk> },
+    { "random_cyclic_flash", make_strategy<random_cyclic_flash> },
+    { "load_balanced", make_strategy<load_balanced> },
+    { "single_disk", make_strategy<single_disk> },
+};
+
+static strategy_ptr create_strategy(
+    const std::string& name, bool ranged, size_t begin, size_t end)
+{
+    for (const auto& s : strategy_table)
+    {
+        if (name != s.name)
+            continue;
+
+        strategy_ptr strategy = s.make(ranged, begin, end);
+        FOXXLL_THROW_IF(!strategy, std::runtime_error,
+                        "Allocation strategy '" << name << "' has no disks "
+                        "to allocate from");
+        return strategy;
+    }
+    FOXXLL_THROW(std::runtime_error,
+                 "Unknown allocation strategy '" << name << "'");
+}
+
+dynamic_strategy::dynamic_strategy()
+    : impl_(create_strategy(config::get_instance()->alloc_strategy(),
+                            false, 0, 0))
+{ }
+
+dynamic_strategy::dynamic_strategy(size_t begin, size_t end)
+    : impl_(create_strategy(config::get_instance()->alloc_strategy(),
+                            true, begin, end))
+{ }
+
+dynamic_strategy::dynamic_strategy(const std::string& strategy)
+    : impl_(create_strategy(strategy, false, 0, 0))
+{ }
+
+dynamic_strategy::dynamic_strategy(
+    const std::string& strategy, size_t begin, size_t end)
+    : impl_(create_strategy(strategy, true, begin, end))
+{ }
+
+std::vector<std::string> dynamic_strategy::names()
+{
+    std::vector<std::string> result;
+    for (const auto& s : strategy_table)
+        result.emplace_back(s.name);
+    return result;
+}
+
+} // namespace foxxll
+
+/**************************************************************************/
@@ -15,6 +15,8 @@
 #define FOXXLL_MNG_BLOCK_ALLOC_STRATEGY_HEADER
 
 #include <algorithm>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <vector>
 
@@ -191,6 +193,73 @@ struct random_cyclic_flash : public random_cyclic
     }
 };
 
+/*!
+ * Load-aware randomized cycling parallel disk block allocation scheme functor.
+ *
+ * Disks are weighted by their measured throughput, reduced by the length of
+ * their request queue and by their remaining capacity relative to the other
+ * disks. The functor cycles through a sequence in which each disk occurs in
+ * proportion to its weight (quantized to weight_resolution steps), evenly
+ * interleaved and starting from a random permutation of the disks. Each cycle
+ * contains every disk which is not full at least once, hence any cycle of
+ * blocks can be accessed in parallel as with random_cyclic, which this
+ * strategy reduces to for identical disks.
+ *
+ * The weights are measured on the first use of the functor, not on its
+ * construction, which may happen while the block_manager is locked. Disks
+ * which have not served any I/O yet are assumed to have the mean throughput
+ * of the others.
+ *
+ * \remarks model of \b allocation_strategy concept
+ */
+struct load_balanced : public striping
+{
+    //! number of cycle entries of the disk with the highest weight
+    static constexpr size_t weight_resolution = 8;
+
+    //! queue length which halves the weight of a disk
+    static constexpr double busy_queue_length = 16.0;
+
+private:
+    //! cycle computed on first use, shared by the copies of the functor
+    struct lazy_cycle
+    {
+        std::once_flag once;
+        std::vector<size_t> cycle;
+    };
+    std::shared_ptr<lazy_cycle> cycle_;
+
+    //! measure the disks and compute the cycle
+    void init(std::vector<size_t>& cycle) const;
+
+public:
+    load_balanced(size_t begin, size_t end)
+        : striping(begin, end), cycle_(std::make_shared<lazy_cycle>())
+    { }
+
+    load_balanced()
+        : striping(), cycle_(std::make_shared<lazy_cycle>())
+    { }
+
+    //! Returns the sequence of disk offsets cycled through.
+    const std::vector<size_t> & cycle() const
+    {
+        std::call_once(cycle_->once, [this]() { init(cycle_->cycle); });
+        return cycle_->cycle;
+    }
+
+    size_t operator () (size_t i) const
+    {
+        const std::vector<size_t>& c = cycle();
+        return begin_ + c[i % c.size()];
+    }
+
+    static const char * name()
+    {
+        return "load-balanced randomized cycling striping";
+    }
+};
+
 //! 'Single disk' parallel disk block allocation scheme functor.
 //! \remarks model of \b allocation_strategy concept
 struct single_disk
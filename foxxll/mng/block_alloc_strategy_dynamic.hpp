@@ -0,0 +1,202 @@
+/***************************************************************************
+ *  foxxll/mng/block_alloc_strategy_dynamic.hpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef FOXXLL_MNG_BLOCK_ALLOC_STRATEGY_DYNAMIC_HEADER
+#define FOXXLL_MNG_BLOCK_ALLOC_STRATEGY_DYNAMIC_HEADER
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <foxxll/common/error_handling.hpp>
+#include <foxxll/mng/block_alloc_strategy.hpp>
+#include <foxxll/mng/block_alloc_strategy_interleaved.hpp>
+
+namespace foxxll {
+
+//! \addtogroup foxxll_alloc
+//! \{
+
+//! Interface of the allocation strategies wrapped by dynamic_strategy.
+class allocation_strategy_base
+{
+public:
+    virtual ~allocation_strategy_base() = default;
+
+    //! Returns the disk of the i-th block.
+    virtual size_t operator () (size_t i) const = 0;
+
+    //! Returns the descriptive name of the strategy.
+    virtual const char * name() const = 0;
+
+    //! Returns the strategy placing the blocks of nruns interleaved runs.
+    virtual std::shared_ptr<const allocation_strategy_base>
+    interleave(int nruns) const = 0;
+};
+
+//! Wraps an interleaved allocation strategy, which cannot be interleaved again.
+template <typename Interleaved>
+class interleaved_allocation_strategy final : public allocation_strategy_base
+{
+    Interleaved strategy_;
+    const char* name_;
+
+public:
+    interleaved_allocation_strategy(const Interleaved& strategy,
+                                    const char* name)
+        : strategy_(strategy), name_(name) { }
+
+    size_t operator () (size_t i) const final
+    {
+        return strategy_(i);
+    }
+
+    const char * name() const final
+    {
+        return name_;
+    }
+
+    std::shared_ptr<const allocation_strategy_base>
+    interleave(int /* nruns */) const final
+    {
+        FOXXLL_THROW(std::runtime_error,
+                     "Interleaved allocation strategy " << name_ <<
+                     " cannot be interleaved again.");
+    }
+};
+
+//! Wraps an allocation_strategy functor behind allocation_strategy_base.
+template <typename Strategy>
+class allocation_strategy_adapter final : public allocation_strategy_base
+{
+    Strategy strategy_;
+
+public:
+    explicit allocation_strategy_adapter(const Strategy& strategy)
+        : strategy_(strategy) { }
+
+    size_t operator () (size_t i) const final
+    {
+        return strategy_(i);
+    }
+
+    const char * name() const final
+    {
+        return Strategy::name();
+    }
+
+    std::shared_ptr<const allocation_strategy_base>
+    interleave(int nruns) const final
+    {
+        using interleaved = typename interleaved_alloc_traits<Strategy>::strategy;
+        return std::make_shared<interleaved_allocation_strategy<interleaved> >(
+            interleaved(nruns, strategy_), Strategy::name());
+    }
+};
+
+/*!
+ * Allocation strategy selected at run time by name, e.g. from the
+ * configuration file or the environment, which allows comparing placements
+ * without recompiling. Each block allocation costs one virtual call.
+ *
+ * Known names are striping, fully_random, simple_random, random_cyclic,
+ * random_cyclic_disk, random_cyclic_flash, load_balanced and single_disk. The
+ * default constructor selects config::alloc_strategy(), which is set by an
+ * "alloc_strategy=<name>" line in the .stxxl file or by the
+ * FOXXLL_ALLOC_STRATEGY environment variable, and defaults to random_cyclic.
+ *
+ * Copies share the wrapped strategy object.
+ *
+ * \remarks model of \b allocation_strategy concept
+ */
+class dynamic_strategy
+{
+    std::shared_ptr<const allocation_strategy_base> impl_;
+
+public:
+    //! Constructs the configured strategy over all disks of its kind.
+    dynamic_strategy();
+
+    //! Constructs the configured strategy over the disks [begin, end).
+    dynamic_strategy(size_t begin, size_t end);
+
+    //! Constructs a strategy by name over all disks of its kind, throws
+    //! std::runtime_error if the name is unknown.
+    explicit dynamic_strategy(const std::string& strategy);
+
+    //! Constructs a strategy by name over the disks [begin, end), throws
+    //! std::runtime_error if the name is unknown.
+    dynamic_strategy(const std::string& strategy, size_t begin, size_t end);
+
+    //! Wraps an existing strategy object.
+    explicit dynamic_strategy(
+        std::shared_ptr<const allocation_strategy_base> impl)
+        : impl_(std::move(impl)) { }
+
+    //! Wraps an allocation_strategy functor.
+    template <typename Strategy>
+    static dynamic_strategy wrap(const Strategy& strategy)
+    {
+        return dynamic_strategy(
+            std::make_shared<allocation_strategy_adapter<Strategy> >(strategy));
+    }
+
+    size_t operator () (size_t i) const
+    {
+        return (*impl_)(i);
+    }
+
+    const char * name() const
+    {
+        return impl_->name();
+    }
+
+    //! Returns the strategy placing the blocks of nruns interleaved runs.
+    dynamic_strategy interleave(int nruns) const
+    {
+        return dynamic_strategy(impl_->interleave(nruns));
+    }
+
+    //! Returns the names accepted by the constructors.
+    static std::vector<std::string> names();
+};
+
+//! Interleaved placement of the strategy selected by a dynamic_strategy.
+struct interleaved_dynamic
+{
+    dynamic_strategy strategy_;
+
+    interleaved_dynamic(int nruns, const dynamic_strategy& strategy)
+        : strategy_(strategy.interleave(nruns))
+    { }
+
+    size_t operator () (size_t i) const
+    {
+        return strategy_(i);
+    }
+};
+
+template <>
+struct interleaved_alloc_traits<dynamic_strategy>
+{
+    using strategy = interleaved_dynamic;
+};
+
+//! \}
+
+} // namespace foxxll
+
+#endif // !FOXXLL_MNG_BLOCK_ALLOC_STRATEGY_DYNAMIC_HEADER
+
+/**************************************************************************/
@@ -102,6 +102,28 @@ struct interleaved_random_cyclic : public interleaved_striping
     }
 };
 
+struct interleaved_load_balanced : public interleaved_striping
+{
+    std::vector<size_t> cycle_;
+    std::vector<size_t> offsets_;
+
+    interleaved_load_balanced(int nruns, const load_balanced& strategy)
+        : interleaved_striping(nruns, strategy.begin_, strategy.diff_),
+          cycle_(strategy.cycle())
+    {
+        // each run starts at a random position of the weighted cycle
+        std::default_random_engine rng { std::random_device { } () };
+        for (int i = 0; i < nruns; i++)
+            offsets_.push_back(rng() % cycle_.size());
+    }
+
+    size_t operator () (size_t i) const
+    {
+        return begin_disk_ +
+               cycle_[(i / nruns_ + offsets_[i % nruns_]) % cycle_.size()];
+    }
+};
+
 struct first_disk_only : public interleaved_striping
 {
     first_disk_only(int nruns, const single_disk& strategy)
@@ -156,6 +178,12 @@ struct interleaved_alloc_traits<random_cyclic_flash>
     using strategy = interleaved_random_cyclic;
 };
 
+template <>
+struct interleaved_alloc_traits<load_balanced>
+{
+    using strategy = interleaved_load_balanced;
+};
+
 template <>
 struct interleaved_alloc_traits<single_disk>
 {
@@ -12,6 +12,7 @@
  *  http://www.boost.org/LICENSE_1_0.txt)
  **************************************************************************/
 
+#include <cassert>
 #include <cstddef>
 #include <string>
 
@@ -20,6 +21,7 @@
 #include <foxxll/mng/block_manager.hpp>
 
 #include <foxxll/common/types.hpp>
+#include <foxxll/io/compacting_file.hpp>
 #include <foxxll/io/create_file.hpp>
 #include <foxxll/io/disk_queues.hpp>
 #include <foxxll/io/file.hpp>
@@ -44,6 +46,18 @@ block_manager::block_manager()
 
     uint64_t total_size = 0;
 
+    if (config->has_tier())
+    {
+        disk_config& cfg = config->tier_disk();
+
+        file_ptr cache = create_file(cfg, file::CREAT | file::RDWR);
+        tier_ = tlx::make_counting<hot_tier>(cache, cfg.size);
+
+        LOG1 << "Hot tier '" << cfg.path << "' is allocated, space: " <<
+        (cfg.size) / (1024 * 1024) <<
+            " MiB, I/O implementation: " << cfg.fileio_string();
+    }
+
     for (size_t i = 0; i < ndisks_; ++i)
     {
         disk_config& cfg = config->disk(i);
@@ -59,6 +73,14 @@ block_manager::block_manager()
             LOG1 << "Disk '" << cfg.path << "' is allocated, space: " <<
             (cfg.size) / (1024 * 1024) <<
                 " MiB, I/O implementation: " << cfg.fileio_string();
+
+            const file_ptr& f = disk_files_[i];
+            if (f->need_alignment() && f->memory_alignment() > BlockAlignment)
+            {
+                LOG1 << "Disk '" << cfg.path << "' requires buffers aligned "
+                    "to " << f->memory_alignment() << " bytes, blocks are "
+                    "aligned to " << BlockAlignment << " bytes only.";
+            }
         }
         catch (io_error&)
         {
@@ -70,8 +92,66 @@ block_manager::block_manager()
 
         total_size += cfg.size;
 
+        // polled direct I/O is issued by the base file, hence it needs the
+        // spin budget even if it is wrapped below.
+        const double poll_budget = cfg.poll * 1e-6;
+        disk_files_[i]->set_poll_budget(poll_budget);
+        const file* base_file = disk_files_[i].get();
+
+        // relocate the data of compacted disks through a segment map, the
+        // file is then served synchronously by the compacting_file's queue.
+        // The segment map is kept in memory only, hence the file must not
+        // outlive the block manager.
+        if (cfg.compact)
+        {
+            if (!cfg.autogrow || cfg.raw_device)
+            {
+                LOG1 << "Disk '" << cfg.path << "' is not compacted, "
+                    "it does not grow";
+            }
+            else if (!cfg.delete_on_exit)
+            {
+                LOG1 << "Disk '" << cfg.path << "' is not compacted, "
+                    "it is kept on exit but its segment map is not";
+            }
+            else
+            {
+                disk_files_[i] =
+                    tlx::make_counting<compacting_file>(disk_files_[i]);
+            }
+        }
+
+        // put regular disks behind the hot tier, this requires the disk to
+        // be served synchronously by the tiered_file's queue
+        if (tier_ && !cfg.flash)
+        {
+            if (cfg.io_impl == "linuxaio" ||
+                cfg.io_impl.compare(0, 12, "fileperblock") == 0)
+            {
+                LOG1 << "Disk '" << cfg.path << "' is not tiered, "
+                    "unsupported I/O implementation " << cfg.io_impl;
+            }
+            else
+            {
+                disk_files_[i] = tlx::make_counting<tiered_file>(
+                    disk_files_[i], tier_, !cfg.delete_on_exit);
+            }
+        }
+
+        // requests are waited on through the wrapper, which spins for their
+        // completion with its own budget.
+        if (disk_files_[i].get() != base_file)
+            disk_files_[i]->set_poll_budget(poll_budget);
+
         // create queue for the file.
-        disk_queues::get_instance()->make_queue(disk_files_[i].get());
+        disk_queues::get_instance()->make_queue(
+            disk_files_[i].get(), cfg.threads, cfg.max_threads);
+
+        if (cfg.max_bandwidth != 0 || cfg.max_iops != 0) {
+            disk_queues::get_instance()->set_rate_limit(
+                disk_files_[i]->get_queue_id(),
+                static_cast<double>(cfg.max_bandwidth), cfg.max_iops);
+        }
 
         block_allocators_[i] = new disk_block_allocator(disk_files_[i].get(), cfg);
     }
@@ -119,6 +199,29 @@ uint64_t block_manager::free_bytes() const
     return total;
 }
 
+block_manager::disk_load block_manager::get_disk_load(size_t disk) const
+{
+    assert(disk < ndisks_);
+
+    disk_load load;
+
+    const file_stats* stats = disk_files_[disk]->get_file_stats();
+    const double time = stats->get_read_time() + stats->get_write_time();
+    load.throughput =
+        time > 0 ? static_cast<double>(stats->get_read_bytes() +
+                                       stats->get_write_bytes()) / time
+        : 0.0;
+
+    load.queue_length = disk_queues::get_instance()->num_waiting_requests(
+        disk_files_[disk]->get_queue_id());
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    load.free_bytes = block_allocators_[disk]->free_bytes();
+    load.autogrow = block_allocators_[disk]->autogrow();
+
+    return load;
+}
+
 uint64_t block_manager::total_allocation() const
 {
     std::unique_lock<std::mutex> lock(mutex_);
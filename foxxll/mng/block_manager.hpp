@@ -29,6 +29,7 @@
 #include <foxxll/io/create_file.hpp>
 #include <foxxll/io/file.hpp>
 #include <foxxll/io/request.hpp>
+#include <foxxll/io/tiered_file.hpp>
 #include <foxxll/mng/bid.hpp>
 #include <foxxll/mng/block_alloc_strategy.hpp>
 #include <foxxll/mng/config.hpp>
@@ -76,6 +77,28 @@ public:
         BIDIterator bid_begin, BIDIterator bid_end,
         size_t alloc_offset = 0);
 
+    /*!
+     * Allocates new blocks in extents of physically contiguous blocks.
+     *
+     * The range [ \b bid_begin, \b bid_end) is cut into extents of \b
+     * extent_blocks consecutive blocks. The k-th extent is placed on the disk
+     * given by \b functor(alloc_offset + k), where its blocks are allocated in
+     * one contiguous region in their order, such that a run can be read back
+     * sequentially even after the free space has been fragmented. For BID<0>
+     * allocations, the objects' size field must be initialized.
+     *
+     * \param functor object of model of \b allocation_strategy concept
+     * \param bid_begin random access BID iterator object
+     * \param bid_end random access BID iterator object
+     * \param extent_blocks number of blocks per extent, 0 = the whole range
+     * \param alloc_offset advance for \b functor to line up partial allocations
+     */
+    template <typename DiskAssignFunctor, typename BIDIterator>
+    void new_extents(
+        const DiskAssignFunctor& functor,
+        BIDIterator bid_begin, BIDIterator bid_end,
+        size_t extent_blocks = 0, size_t alloc_offset = 0);
+
     /*!
      * Allocates a new block according to the strategy given by \b functor and
      * stores the block identifier to bid.
@@ -126,8 +149,29 @@ public:
     //! return maximum number of bytes allocated during program run.
     uint64_t maximum_allocation() const;
 
+    //! current load of a disk, as used by adaptive allocation strategies
+    struct disk_load
+    {
+        //! measured throughput of the disk's operations in bytes per second,
+        //! 0 if it has not served any I/O yet
+        double throughput;
+        //! number of requests waiting in the disk's queue
+        size_t queue_length;
+        //! free bytes on the disk
+        uint64_t free_bytes;
+        //! whether the disk grows if it is full
+        bool autogrow;
+    };
+
+    //! return the current load of a disk
+    disk_load get_disk_load(size_t disk) const;
+
     //! \}
 
+    //! Returns the hot tier caching segments of the regular disks, or
+    //! nullptr if no flash device is configured with 'tier'.
+    hot_tier * get_hot_tier() const { return tier_.get(); }
+
     ~block_manager();
 
 private:
@@ -142,6 +186,9 @@ private:
     //! one block allocator per disk
     tlx::simple_vector<disk_block_allocator*> block_allocators_;
 
+    //! hot tier in front of the regular disks, if configured
+    tlx::counting_ptr<hot_tier> tier_;
+
     //! total requested allocation in bytes
     uint64_t total_allocation_ = 0;
 
@@ -247,6 +294,64 @@ void block_manager::new_blocks(
     maximum_allocation_ = std::max(maximum_allocation_, current_allocation_);
 }
 
+template <typename DiskAssignFunctor, typename BIDIterator>
+void block_manager::new_extents(
+    const DiskAssignFunctor& functor,
+    BIDIterator bid_begin, BIDIterator bid_end,
+    size_t extent_blocks, size_t alloc_offset)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    const size_t bid_size = static_cast<size_t>(bid_end - bid_begin);
+    if (extent_blocks == 0)
+        extent_blocks = bid_size;
+
+    for (size_t first = 0, k = 0; first < bid_size; first += extent_blocks, ++k)
+    {
+        BIDIterator extent_begin = bid_begin + first;
+        BIDIterator extent_end =
+            bid_begin + std::min(first + extent_blocks, bid_size);
+
+        uint64_t extent_bytes = 0;
+        for (BIDIterator bid = extent_begin; bid != extent_end; ++bid)
+            extent_bytes += bid->size;
+
+        size_t disk_id = functor(alloc_offset + k);
+
+        if (!block_allocators_[disk_id]->has_available_space(extent_bytes))
+        {
+            // find disk (cyclically) that has enough free space for extent
+
+            for (size_t adv = 1; adv < ndisks_; ++adv)
+            {
+                size_t try_disk_id = (disk_id + adv) % ndisks_;
+                if (block_allocators_[try_disk_id]->has_available_space(
+                        extent_bytes))
+                {
+                    disk_id = try_disk_id;
+                    break;
+                }
+            }
+
+            // if no disk has free space, pick first selected by functor
+        }
+
+        block_allocators_[disk_id]->new_extent(extent_begin, extent_end);
+
+        for (BIDIterator bid = extent_begin; bid != extent_end; ++bid)
+        {
+            bid->storage = disk_files_[disk_id].get();
+
+            LOGC(verbose_block_life_cycle) << "BLC:new    " << *bid;
+
+            total_allocation_ += bid->size;
+            current_allocation_ += bid->size;
+        }
+    }
+
+    maximum_allocation_ = std::max(maximum_allocation_, current_allocation_);
+}
+
 template <size_t BlockSize>
 void block_manager::delete_block(const BID<BlockSize>& bid)
 {
@@ -261,8 +366,8 @@ void block_manager::delete_block(const BID<BlockSize>& bid)
 
     LOGC(verbose_block_life_cycle) << "BLC:delete " << bid;
     assert(bid.storage->get_allocator_id() >= 0);
+    // the allocator discards the block in the file
     block_allocators_[bid.storage->get_allocator_id()]->delete_block(bid);
-    disk_files_[bid.storage->get_allocator_id()]->discard(bid.offset, bid.size);
 
     current_allocation_ -= BlockSize;
 }
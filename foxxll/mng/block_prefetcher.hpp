@@ -87,6 +87,11 @@ protected:
     block_type * wait(size_t iblock)
     {
         LOG << "block_prefetcher: waiting block " << iblock;
+        if (!completed[iblock].is_on())
+        {
+            // the application is blocked on this read now
+            read_reqs[pref_buffer[iblock]]->set_priority(request::DEMAND);
+        }
         {
             stats::scoped_wait_timer wait_timer(stats::WAIT_OP_READ);
 
@@ -146,7 +151,8 @@ public:
                 " @ " << read_bids[i];
             read_reqs[i] = read_buffers[i].read(
                     read_bids[i],
-                    set_switch_handler(*(completed + prefetch_seq[i]), do_after_fetch)
+                    set_switch_handler(*(completed + prefetch_seq[i]), do_after_fetch),
+                    request::PREFETCH
                 );
             pref_buffer[prefetch_seq[i]] = i;
         }
@@ -192,7 +198,8 @@ public:
                 bid_type(*(consume_seq_begin + next_2_prefetch));
             read_reqs[ibuffer] = read_buffers[ibuffer].read(
                     read_bids[ibuffer],
-                    set_switch_handler(*(completed + next_2_prefetch), do_after_fetch)
+                    set_switch_handler(*(completed + next_2_prefetch), do_after_fetch),
+                    request::PREFETCH
                 );
         }
 
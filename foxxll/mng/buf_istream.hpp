@@ -14,6 +14,7 @@
 #define FOXXLL_MNG_BUF_ISTREAM_HEADER
 
 #include <algorithm>
+#include <utility>
 
 #include <foxxll/mng/async_schedule.hpp>
 #include <foxxll/mng/block_prefetcher.hpp>
@@ -52,7 +53,9 @@ protected:
 #endif
 
 public:
+    using value_type = typename block_type::value_type;
     using reference = typename block_type::reference;
+    using pointer = typename block_type::pointer;
     using self_type = buf_istream<block_type, bid_iterator_type>;
 
     //! Constructs input stream object.
@@ -150,6 +153,57 @@ public:
         return *this;
     }
 
+    //! Returns the contiguous range of records from the current record to the
+    //! end of the current block. The records can be processed in place, they
+    //! stay valid until the stream is advanced past them.
+    //! \return pointer to the current record and number of records in range
+    std::pair<pointer, size_t> next_span()
+    {
+#ifdef BUF_ISTREAM_CHECK_END
+        assert(not_finished);
+#endif
+        return std::pair<pointer, size_t>(
+            current_blk->elem + current_elem, block_type::size - current_elem);
+    }
+
+    //! Moves forward by \c n records, which must not exceed the range
+    //! returned by \c next_span().
+    //! \return reference to itself after the advance
+    self_type& consume(size_t n)
+    {
+        assert(current_elem + n <= block_type::size);
+
+        current_elem += n;
+
+        if (UNLIKELY(current_elem >= block_type::size))
+        {
+            current_elem = 0;
+#ifdef BUF_ISTREAM_CHECK_END
+            not_finished = prefetcher->block_consumed(current_blk);
+#else
+            prefetcher->block_consumed(current_blk);
+#endif
+        }
+        return *this;
+    }
+
+    //! Reads the next \c n records into \c dest, copying whole ranges of
+    //! each block at once.
+    //! \return reference to itself (stream object)
+    self_type& read_bulk(value_type* dest, size_t n)
+    {
+        while (n > 0)
+        {
+            std::pair<pointer, size_t> span = next_span();
+            size_t len = std::min(n, span.second);
+            std::copy(span.first, span.first + len, dest);
+            consume(len);
+            dest += len;
+            n -= len;
+        }
+        return *this;
+    }
+
     //! Frees used internal objects.
     ~buf_istream()
     {
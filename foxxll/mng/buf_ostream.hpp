@@ -13,6 +13,9 @@
 #ifndef FOXXLL_MNG_BUF_OSTREAM_HEADER
 #define FOXXLL_MNG_BUF_OSTREAM_HEADER
 
+#include <algorithm>
+#include <utility>
+
 #include <foxxll/mng/buf_writer.hpp>
 
 namespace foxxll {
@@ -38,8 +41,10 @@ protected:
     block_type* current_blk;
 
 public:
+    using value_type = typename block_type::value_type;
     using const_reference = typename block_type::const_reference;
     using reference = typename block_type::reference;
+    using pointer = typename block_type::pointer;
     using self_type = buf_ostream<block_type, bid_iterator_type>;
 
     //! Constructs output stream object.
@@ -98,12 +103,58 @@ public:
         return *this;
     }
 
+    //! Returns the contiguous range of unwritten records from the current
+    //! record to the end of the current block. The producer may fill the
+    //! records in place and then pass the count to \c commit().
+    //! \return pointer to the current record and number of records in range
+    std::pair<pointer, size_t> reserve_span()
+    {
+        return std::pair<pointer, size_t>(
+            current_blk->elem + current_elem, block_type::size - current_elem);
+    }
+
+    //! Moves forward by \c n records filled in place, which must not exceed
+    //! the range returned by \c reserve_span(). A completed block is handed
+    //! to the writer.
+    //! \return reference to itself after the advance
+    self_type& commit(size_t n)
+    {
+        assert(current_elem + n <= block_type::size);
+
+        current_elem += n;
+        if (UNLIKELY(current_elem >= block_type::size))
+        {
+            current_elem = 0;
+            current_blk = writer.write(current_blk, *(current_bid++));
+        }
+        return *this;
+    }
+
+    //! Writes out \c n records from \c src, copying whole ranges of each
+    //! block at once.
+    //! \return reference to itself (stream object)
+    self_type& write_bulk(const value_type* src, size_t n)
+    {
+        while (n > 0)
+        {
+            std::pair<pointer, size_t> span = reserve_span();
+            size_t len = std::min(n, span.second);
+            std::copy(src, src + len, span.first);
+            commit(len);
+            src += len;
+            n -= len;
+        }
+        return *this;
+    }
+
     //! Fill current block with padding and flush
     self_type & fill(const_reference record)
     {
-        while (current_elem != 0)
+        if (current_elem != 0)
         {
-            operator << (record);
+            std::pair<pointer, size_t> span = reserve_span();
+            std::fill(span.first, span.first + span.second, record);
+            commit(span.second);
         }
         return *this;
     }
@@ -13,11 +13,14 @@
 #ifndef FOXXLL_MNG_BUF_WRITER_HEADER
 #define FOXXLL_MNG_BUF_WRITER_HEADER
 
-#include <queue>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
 #include <vector>
 
 #include <foxxll/io/disk_queues.hpp>
 #include <foxxll/io/request_operations.hpp>
+#include <foxxll/mng/bid.hpp>
 
 namespace foxxll {
 
@@ -31,6 +34,12 @@ namespace foxxll {
 //! Encapsulates asynchronous buffered block writing engine.
 //!
 //! \c buffered_writer overlaps I/Os with filling of output buffer.
+//!
+//! Filled blocks are collected in one batch per disk queue. A batch is sorted
+//! by offset and submitted as soon as it holds its share of the write batch
+//! size, independently of the batches of other disks. Buffers are returned to
+//! the free list by the completion handlers of their write requests, so a
+//! slow disk only holds back its own buffers.
 template <typename BlockType>
 class buffered_writer
 {
@@ -45,41 +54,142 @@ protected:
     request_ptr* write_reqs;
     const size_t writebatchsize;
 
-    std::vector<size_t> free_write_blocks;            // contains free write blocks
-    std::vector<size_t> busy_write_blocks;            // blocks that are in writing, notice that if block is not in free_
-    // an not in busy then block is not yet filled
+    // contains free write blocks, only used by the writing thread
+    std::vector<size_t> free_write_blocks;
 
-    struct batch_entry
+    //! blocks of one disk queue waiting to be written
+    struct disk_batch
     {
-        int64_t offset;
-        size_t ibuffer;
-        batch_entry(int64_t o, size_t b) : offset(o), ibuffer(b) { }
+        int queue_id;
+        std::vector<size_t> blocks;
     };
-    struct batch_entry_cmp
+    //! batches of filled blocks, one per disk queue seen so far
+    std::vector<disk_batch> batches;
+    //! total number of blocks in all batches
+    size_t nbatched;
+
+    //! protects completed_write_blocks and nbusy
+    std::mutex mutex_;
+    //! signaled when a write request completes
+    std::condition_variable cv_;
+    //! blocks whose write request completed, filled by completion handlers
+    std::vector<size_t> completed_write_blocks;
+    //! number of blocks that are in writing
+    size_t nbusy;
+
+    //! completion handler returning the buffer to the writer
+    class write_completed_handler
     {
-        bool operator () (const batch_entry& a, const batch_entry& b) const
+        buffered_writer* writer_;
+        size_t ibuffer_;
+
+    public:
+        write_completed_handler(buffered_writer* writer, size_t ibuffer)
+            : writer_(writer), ibuffer_(ibuffer) { }
+
+        void operator () (request*, bool /* success */)
         {
-            return (a.offset > b.offset);
+            writer_->write_completed(ibuffer_);
         }
     };
 
-    using batch_type = std::priority_queue<batch_entry, std::vector<batch_entry>, batch_entry_cmp>;
-    batch_type batch_write_blocks;      // sorted sequence of blocks to write
+    void write_completed(size_t ibuffer)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        completed_write_blocks.push_back(ibuffer);
+        --nbusy;
+        // notify while holding the lock: the writer may be destroyed as
+        // soon as the lock is released after the last completion.
+        cv_.notify_one();
+    }
+
+    //! Sorts the batch by offset and submits all its write requests.
+    void flush_batch(disk_batch& batch)
+    {
+        if (batch.blocks.empty())
+            return;
+
+        LOG << "Flushing batch of " << batch.blocks.size()
+            << " blocks for queue " << batch.queue_id;
+
+        std::sort(batch.blocks.begin(), batch.blocks.end(),
+                  [this](const size_t& a, const size_t& b) {
+                      return bid_queue_order()(write_bids[a], write_bids[b]);
+                  });
+
+        nbatched -= batch.blocks.size();
+
+        for (const size_t& ibuffer : batch.blocks)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                ++nbusy;
+            }
+            try
+            {
+                write_reqs[ibuffer] = write_buffers[ibuffer].write(
+                    write_bids[ibuffer], write_completed_handler(this, ibuffer),
+                    request::WRITEBACK);
+            }
+            catch (...)
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                --nbusy;
+                throw;
+            }
+        }
+
+        batch.blocks.clear();
+    }
+
+    //! Submits the batches of all disks.
+    void flush_batches()
+    {
+        for (disk_batch& batch : batches)
+            flush_batch(batch);
+        assert(nbatched == 0);
+    }
+
+    //! Waits until all write requests have completed.
+    void wait_all_busy()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (nbusy != 0)
+            cv_.wait(lock);
+    }
+
+    //! Returns the batch of the given disk queue, adds one if it is new.
+    disk_batch& batch_of_queue(int queue_id)
+    {
+        for (disk_batch& batch : batches)
+        {
+            if (batch.queue_id == queue_id)
+                return batch;
+        }
+        batches.push_back(disk_batch());
+        batches.back().queue_id = queue_id;
+        batches.back().blocks.reserve(nwriteblocks);
+        return batches.back();
+    }
 
 public:
     //! Constructs an object.
     //! \param write_buf_size number of write buffers to use
     //! \param write_batch_size number of blocks to accumulate in
-    //!        order to flush write requests (bulk buffered writing)
+    //!        order to flush write requests (bulk buffered writing), this is
+    //!        divided evenly among the disks written to
     buffered_writer(size_t write_buf_size, size_t write_batch_size)
         : nwriteblocks((write_buf_size > 2) ? write_buf_size : 2),
-          writebatchsize(write_batch_size ? write_batch_size : 1)
+          writebatchsize(write_batch_size ? write_batch_size : 1),
+          nbatched(0), nbusy(0)
     {
         write_buffers = new block_type[nwriteblocks];
         write_reqs = new request_ptr[nwriteblocks];
 
         write_bids = new bid_type[nwriteblocks];
 
+        free_write_blocks.reserve(nwriteblocks);
+        completed_write_blocks.reserve(nwriteblocks);
         for (size_t i = 0; i < nwriteblocks; i++)
             free_write_blocks.push_back(i);
 
@@ -95,34 +205,35 @@ public:
     //! \return pointer to the block from the internal buffer pool
     block_type * get_free_block()
     {
-        size_t ibuffer;
-        for (auto it = busy_write_blocks.begin(); it != busy_write_blocks.end(); ++it)
+        if (UNLIKELY(free_write_blocks.empty()))
         {
-            if (write_reqs[ibuffer = (*it)]->poll())
-            {
-                busy_write_blocks.erase(it);
-                free_write_blocks.push_back(ibuffer);
+            std::unique_lock<std::mutex> lock(mutex_);
 
-                break;
+            if (completed_write_blocks.empty() && nbusy == 0)
+            {
+                // all other buffers wait in batches, submit them.
+                lock.unlock();
+                flush_batches();
+                lock.lock();
             }
-        }
-        if (UNLIKELY(free_write_blocks.empty()))
-        {
-            size_t size = busy_write_blocks.size();
-            request_ptr* reqs = new request_ptr[size];
-            size_t i = 0;
-            for ( ; i < size; ++i)
+
+            if (completed_write_blocks.empty())
             {
-                reqs[i] = write_reqs[busy_write_blocks[i]];
+                stats::scoped_wait_timer wait_timer(stats::WAIT_OP_WRITE);
+                while (completed_write_blocks.empty())
+                    cv_.wait(lock);
             }
-            size_t completed = wait_any(reqs, size);
-            size_t completed_global = busy_write_blocks[completed];
-            delete[] reqs;
-            busy_write_blocks.erase(busy_write_blocks.begin() + completed);
 
-            return (write_buffers + completed_global);
+            // take over all completed blocks, both vectors have capacity
+            // nwriteblocks, so no reallocation happens.
+            std::swap(free_write_blocks, completed_write_blocks);
+            lock.unlock();
+
+            for (const size_t& ibuffer : free_write_blocks)
+                write_reqs[ibuffer]->check_errors();
         }
-        ibuffer = free_write_blocks.back();
+
+        size_t ibuffer = free_write_blocks.back();
         free_write_blocks.pop_back();
 
         return (write_buffers + ibuffer);
@@ -134,55 +245,34 @@ public:
     //! \return pointer to the new free block from the pool
     block_type * write(block_type* filled_block, const bid_type& bid)          // writes filled_block and returns a new block
     {
-        if (batch_write_blocks.size() >= writebatchsize)
-        {
-            // flush batch
-            while (!batch_write_blocks.empty())
-            {
-                size_t ibuffer = batch_write_blocks.top().ibuffer;
-                batch_write_blocks.pop();
-
-                if (write_reqs[ibuffer].valid())
-                    write_reqs[ibuffer]->wait();
-
-                write_reqs[ibuffer] = write_buffers[ibuffer].write(write_bids[ibuffer]);
-
-                busy_write_blocks.push_back(ibuffer);
-            }
-        }
         LOG << "Adding write request to batch";
 
         size_t ibuffer = filled_block - write_buffers;
         write_bids[ibuffer] = bid;
-        batch_write_blocks.push(batch_entry(bid.offset, ibuffer));
+
+        disk_batch& batch = batch_of_queue(bid.storage->get_queue_id());
+        batch.blocks.push_back(ibuffer);
+        ++nbatched;
+
+        // each disk gets an equal share of the batch size
+        size_t disk_batch_size = std::max(
+            writebatchsize / batches.size(), size_t(1));
+        if (batch.blocks.size() >= disk_batch_size)
+            flush_batch(batch);
 
         return get_free_block();
     }
     //! Flushes not yet written buffers.
     void flush()
     {
-        size_t ibuffer;
-        while (!batch_write_blocks.empty())
-        {
-            ibuffer = batch_write_blocks.top().ibuffer;
-            batch_write_blocks.pop();
-
-            if (write_reqs[ibuffer].valid())
-                write_reqs[ibuffer]->wait();
+        flush_batches();
+        wait_all_busy();
 
-            write_reqs[ibuffer] = write_buffers[ibuffer].write(write_bids[ibuffer]);
-
-            busy_write_blocks.push_back(ibuffer);
-        }
-        for (auto it = busy_write_blocks.begin(); it != busy_write_blocks.end(); it++)
-        {
-            ibuffer = *it;
-            write_reqs[ibuffer]->wait();
-        }
+        for (size_t i = 0; i < nwriteblocks; i++)
+            write_reqs[i] = request_ptr();
 
-        assert(batch_write_blocks.empty());
+        completed_write_blocks.clear();
         free_write_blocks.clear();
-        busy_write_blocks.clear();
 
         for (size_t i = 0; i < nwriteblocks; i++)
             free_write_blocks.push_back(i);
@@ -191,24 +281,8 @@ public:
     //! Flushes not yet written buffers and frees used memory.
     ~buffered_writer()
     {
-        size_t ibuffer;
-        while (!batch_write_blocks.empty())
-        {
-            ibuffer = batch_write_blocks.top().ibuffer;
-            batch_write_blocks.pop();
-
-            if (write_reqs[ibuffer].valid())
-                write_reqs[ibuffer]->wait();
-
-            write_reqs[ibuffer] = write_buffers[ibuffer].write(write_bids[ibuffer]);
-
-            busy_write_blocks.push_back(ibuffer);
-        }
-        for (auto it = busy_write_blocks.begin(); it != busy_write_blocks.end(); it++)
-        {
-            ibuffer = *it;
-            write_reqs[ibuffer]->wait();
-        }
+        flush_batches();
+        wait_all_busy();
 
         delete[] write_reqs;
         delete[] write_buffers;
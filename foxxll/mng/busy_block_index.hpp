@@ -0,0 +1,325 @@
+/***************************************************************************
+ *  foxxll/mng/busy_block_index.hpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#ifndef FOXXLL_MNG_BUSY_BLOCK_INDEX_HEADER
+#define FOXXLL_MNG_BUSY_BLOCK_INDEX_HEADER
+
+#include <cassert>
+#include <cstdint>
+
+#include <iterator>
+#include <utility>
+#include <vector>
+
+#include <foxxll/io/request.hpp>
+
+namespace foxxll {
+
+//! \addtogroup foxxll_schedlayer
+//! \{
+
+/*!
+ * List of blocks with outstanding I/O requests, as kept by prefetch_pool and
+ * write_pool.
+ *
+ * Entries live in a slot array and are chained through index links stored in
+ * the entries themselves (an intrusive doubly-linked list in insertion order,
+ * slot 0 is the sentinel). Unused slots form an intrusive free list. A
+ * linear-probing hash table maps BIDs to slots, so that lookup and removal by
+ * BID are O(1). Memory is only allocated when the number of entries exceeds
+ * all previous maxima; in steady state no operation touches the heap.
+ *
+ * An entry may be removed from the BID index while staying in the list
+ * (unindex()), this is used for stale writes that are superseded by a newer
+ * write to the same BID.
+ */
+template <class BlockType>
+class busy_block_index
+{
+public:
+    using block_type = BlockType;
+    using bid_type = typename block_type::bid_type;
+
+    //! an entry of the busy list
+    struct entry
+    {
+        block_type* block = nullptr;
+        request_ptr req;
+        bid_type bid;
+
+        //! to make wait_any() and friends work on the busy list
+        operator request_ptr () const { return req; }
+
+    private:
+        friend class busy_block_index;
+
+        //! links in the busy list, or in the list of unused slots
+        size_t prev = 0, next = 0;
+        //! whether the entry is registered in the BID index
+        bool indexed = false;
+    };
+
+    //! bidirectional iterator over the busy list
+    class iterator
+    {
+    public:
+        using iterator_category = std::bidirectional_iterator_tag;
+        using value_type = entry;
+        using difference_type = std::ptrdiff_t;
+        using pointer = entry*;
+        using reference = entry&;
+
+        iterator() = default;
+
+        reference operator * () const { return index_->entries_[pos_]; }
+        pointer operator -> () const { return &index_->entries_[pos_]; }
+
+        iterator& operator ++ ()
+        {
+            pos_ = index_->entries_[pos_].next;
+            return *this;
+        }
+        iterator operator ++ (int)
+        {
+            iterator it = *this;
+            ++*this;
+            return it;
+        }
+        iterator& operator -- ()
+        {
+            pos_ = index_->entries_[pos_].prev;
+            return *this;
+        }
+        iterator operator -- (int)
+        {
+            iterator it = *this;
+            --*this;
+            return it;
+        }
+
+        bool operator == (const iterator& b) const { return pos_ == b.pos_; }
+        bool operator != (const iterator& b) const { return pos_ != b.pos_; }
+
+    private:
+        friend class busy_block_index;
+
+        iterator(busy_block_index* index, size_t pos)
+            : index_(index), pos_(pos) { }
+
+        busy_block_index* index_ = nullptr;
+        size_t pos_ = 0;
+    };
+
+protected:
+    //! marks an empty cell in the hash table
+    static constexpr size_t empty_cell = 0;
+
+    //! slot array, slot 0 is the sentinel of the busy list
+    std::vector<entry> entries_;
+
+    //! head of the intrusive list of unused slots (0 = none)
+    size_t unused_ = 0;
+
+    //! number of entries in the busy list
+    size_t size_ = 0;
+
+    //! open-addressing hash table of slot numbers, size is a power of two
+    std::vector<size_t> table_;
+
+    //! number of entries in the hash table
+    size_t indexed_size_ = 0;
+
+    static size_t hash(const bid_type& bid)
+    {
+        uint64_t x = uint64_t(bid.offset) ^
+                     (uint64_t(reinterpret_cast<uintptr_t>(bid.storage)) *
+                      0x9E3779B97F4A7C15ull);
+        x ^= x >> 32;
+        x *= 0xD6E8FEB86659FD93ull;
+        x ^= x >> 32;
+        return static_cast<size_t>(x);
+    }
+
+    size_t mask() const { return table_.size() - 1; }
+
+    //! insert slot into the hash table, which must have a free cell
+    void table_insert(size_t slot)
+    {
+        size_t i = hash(entries_[slot].bid) & mask();
+        while (table_[i] != empty_cell)
+            i = (i + 1) & mask();
+        table_[i] = slot;
+    }
+
+    //! find the hash table cell of bid, or an empty cell
+    size_t table_find(const bid_type& bid) const
+    {
+        size_t i = hash(bid) & mask();
+        while (table_[i] != empty_cell && entries_[table_[i]].bid != bid)
+            i = (i + 1) & mask();
+        return i;
+    }
+
+    //! remove the hash table cell i using backward shift deletion
+    void table_erase(size_t i)
+    {
+        size_t j = i;
+        while (true)
+        {
+            j = (j + 1) & mask();
+            if (table_[j] == empty_cell)
+                break;
+            size_t home = hash(entries_[table_[j]].bid) & mask();
+            // move cell j to i if its home position is not in (i, j]
+            if (((j - home) & mask()) >= ((j - i) & mask()))
+            {
+                table_[i] = table_[j];
+                i = j;
+            }
+        }
+        table_[i] = empty_cell;
+    }
+
+    //! grow slot array and hash table (the only allocating operation)
+    void grow()
+    {
+        size_t old_slots = entries_.size();
+        size_t new_slots = 2 * old_slots;
+        entries_.resize(new_slots);
+        // chain new slots into the unused list
+        for (size_t s = new_slots - 1; s >= old_slots; --s)
+        {
+            entries_[s].next = unused_;
+            unused_ = s;
+        }
+        // keep load factor of the hash table at most 1/2
+        table_.assign(2 * new_slots, size_t(empty_cell));
+        for (size_t s = entries_[0].next; s != 0; s = entries_[s].next)
+        {
+            if (entries_[s].indexed)
+                table_insert(s);
+        }
+    }
+
+public:
+    //! Constructs an empty index with capacity for init_capacity entries.
+    explicit busy_block_index(size_t init_capacity = 1)
+        : entries_(1), table_(2, size_t(empty_cell))
+    {
+        while (entries_.size() <= init_capacity)
+            grow();
+    }
+
+    //! non-copyable: delete copy-constructor
+    busy_block_index(const busy_block_index&) = delete;
+    //! non-copyable: delete assignment operator
+    busy_block_index& operator = (const busy_block_index&) = delete;
+
+    void swap(busy_block_index& obj)
+    {
+        std::swap(entries_, obj.entries_);
+        std::swap(unused_, obj.unused_);
+        std::swap(size_, obj.size_);
+        std::swap(table_, obj.table_);
+        std::swap(indexed_size_, obj.indexed_size_);
+    }
+
+    iterator begin() { return iterator(this, entries_[0].next); }
+    iterator end() { return iterator(this, 0); }
+
+    //! Returns the number of entries in the busy list.
+    size_t size() const { return size_; }
+
+    //! Returns the number of entries that can be found by BID.
+    size_t indexed_size() const { return indexed_size_; }
+
+    bool empty() const { return size_ == 0; }
+
+    //! Appends an entry to the busy list and registers it in the BID index,
+    //! the bid must not already be indexed.
+    iterator push_back(block_type* block, const request_ptr& req,
+                       const bid_type& bid)
+    {
+        assert(find(bid) == end());
+        if (unused_ == 0)
+            grow();
+
+        size_t s = unused_;
+        entry& e = entries_[s];
+        unused_ = e.next;
+
+        e.block = block;
+        e.req = req;
+        e.bid = bid;
+        e.indexed = true;
+
+        // link in front of the sentinel
+        e.next = 0;
+        e.prev = entries_[0].prev;
+        entries_[e.prev].next = s;
+        entries_[0].prev = s;
+        ++size_;
+
+        table_insert(s);
+        ++indexed_size_;
+        return iterator(this, s);
+    }
+
+    //! Returns the indexed entry of bid, or end().
+    iterator find(const bid_type& bid)
+    {
+        size_t slot = table_[table_find(bid)];
+        return iterator(this, slot);
+    }
+
+    //! Removes an entry from the BID index but keeps it in the busy list.
+    void unindex(iterator it)
+    {
+        entry& e = *it;
+        if (!e.indexed)
+            return;
+        size_t i = table_find(e.bid);
+        assert(table_[i] == it.pos_);
+        table_erase(i);
+        e.indexed = false;
+        --indexed_size_;
+    }
+
+    //! Removes an entry from the busy list and the BID index, releases its
+    //! request and returns the iterator to the next entry.
+    iterator erase(iterator it)
+    {
+        assert(it != end());
+        unindex(it);
+
+        size_t s = it.pos_;
+        entry& e = entries_[s];
+        size_t next = e.next;
+        entries_[e.prev].next = e.next;
+        entries_[e.next].prev = e.prev;
+        --size_;
+
+        e.block = nullptr;
+        e.req = request_ptr();
+        e.next = unused_;
+        unused_ = s;
+        return iterator(this, next);
+    }
+};
+
+//! \}
+
+} // namespace foxxll
+
+#endif // !FOXXLL_MNG_BUSY_BLOCK_INDEX_HEADER
+
+/**************************************************************************/
@@ -47,7 +47,10 @@ static inline bool exist_file(const std::string& path)
 }
 
 config::config()
-    : is_initialized(false)
+    : first_flash(0),
+      is_initialized(false),
+      alloc_strategy_("random_cyclic"),
+      alloc_strategy_set_(false)
 {
     LOG1 << get_version_string_long();
     print_library_version_mismatch();
@@ -64,6 +67,14 @@ config::~config()
             unlink(it->path.c_str());
         }
     }
+    for (const disk_config& it : tier_list)
+    {
+        if (it.delete_on_exit)
+        {
+            LOG1 << "Removing tier file: " << it.path;
+            unlink(it.path.c_str());
+        }
+    }
 }
 
 void config::initialize()
@@ -74,6 +85,10 @@ void config::initialize()
         find_config();
     }
 
+    const char* strategy = getenv("FOXXLL_ALLOC_STRATEGY");
+    if (strategy && *strategy && !alloc_strategy_set_)
+        alloc_strategy_ = strategy;
+
     max_device_id_ = 0;
 
     is_initialized = true;
@@ -155,10 +170,21 @@ void config::load_config_file(const std::string& config_path)
         // skip comments
         if (line.size() == 0 || line[0] == '#') continue;
 
+        // select the allocation strategy of dynamic_strategy
+        const std::string strategy_key = "alloc_strategy=";
+        if (line.compare(0, strategy_key.size(), strategy_key) == 0)
+        {
+            if (!alloc_strategy_set_)
+                alloc_strategy_ = line.substr(strategy_key.size());
+            continue;
+        }
+
         disk_config entry;
         entry.parse_line(line); // throws on errors
 
-        if (!entry.flash)
+        if (entry.tier)
+            add_tier(entry);
+        else if (!entry.flash)
             disks_list.push_back(entry);
         else
             flash_list.push_back(entry);
@@ -177,12 +203,51 @@ void config::load_config_file(const std::string& config_path)
     }
 }
 
+config& config::set_alloc_strategy(const std::string& name)
+{
+    alloc_strategy_ = name;
+    alloc_strategy_set_ = true;
+    return *this;
+}
+
 config& config::add_disk(const disk_config& cfg)
 {
+    if (cfg.tier) {
+        add_tier(cfg);
+        return *this;
+    }
+    // disks keep the order in which they are added, hence the disk ranges
+    // require the flash devices to be added last
+    if (!cfg.flash && first_flash != static_cast<unsigned>(disks_list.size())) {
+        FOXXLL_THROW(
+            std::runtime_error,
+            "Disk '" << cfg.path << "' is added after a flash device."
+        );
+    }
     disks_list.push_back(cfg);
+    if (!cfg.flash)
+        ++first_flash;
     return *this;
 }
 
+void config::add_tier(const disk_config& cfg)
+{
+    if (!cfg.flash) {
+        FOXXLL_THROW(
+            std::runtime_error,
+            "Disk '" << cfg.path << "' with parameter 'tier' is not a flash device."
+        );
+    }
+    if (!tier_list.empty()) {
+        FOXXLL_THROW(
+            std::runtime_error,
+            "Only one flash device may be configured as tier, found '" <<
+                tier_list.front().path << "' and '" << cfg.path << "'."
+        );
+    }
+    tier_list.push_back(cfg);
+}
+
 unsigned int config::max_device_id()
 {
     return max_device_id_;
@@ -211,6 +276,13 @@ std::pair<unsigned, unsigned> config::flash_range() const
     return std::pair<unsigned, unsigned>(first_flash, static_cast<unsigned>(disks_list.size()));
 }
 
+disk_config& config::tier_disk()
+{
+    check_initialized();
+    assert(has_tier());
+    return tier_list.front();
+}
+
 disk_config& config::disk(size_t disk)
 {
     check_initialized();
@@ -277,17 +349,30 @@ external_size_type config::total_size() const
 
 ////////////////////////////////////////////////////////////////////////////////
 
+constexpr unsigned int disk_config::default_poll;
+
 disk_config::disk_config()
     : size(0),
       autogrow(true),
       delete_on_exit(false),
       direct(DIRECT_TRY),
       flash(false),
+      tier(false),
+      compact(false),
+      prealloc(false),
+      discard(false),
+      grow_step(0),
       queue(file::DEFAULT_QUEUE),
       device_id(file::DEFAULT_DEVICE_ID),
       raw_device(false),
       unlink_on_open(false),
-      queue_length(0)
+      queue_length(0),
+      aio_completion(AIO_GETEVENTS),
+      poll(0),
+      threads(1),
+      max_threads(0),
+      max_bandwidth(0),
+      max_iops(0)
 { }
 
 disk_config::disk_config(const std::string& _path, external_size_type _size,
@@ -299,11 +384,22 @@ disk_config::disk_config(const std::string& _path, external_size_type _size,
       delete_on_exit(false),
       direct(DIRECT_TRY),
       flash(false),
+      tier(false),
+      compact(false),
+      prealloc(false),
+      discard(false),
+      grow_step(0),
       queue(file::DEFAULT_QUEUE),
       device_id(file::DEFAULT_DEVICE_ID),
       raw_device(false),
       unlink_on_open(false),
-      queue_length(0)
+      queue_length(0),
+      aio_completion(AIO_GETEVENTS),
+      poll(0),
+      threads(1),
+      max_threads(0),
+      max_bandwidth(0),
+      max_iops(0)
 {
     parse_fileio();
 }
@@ -314,11 +410,22 @@ disk_config::disk_config(const std::string& line)
       delete_on_exit(false),
       direct(DIRECT_TRY),
       flash(false),
+      tier(false),
+      compact(false),
+      prealloc(false),
+      discard(false),
+      grow_step(0),
       queue(file::DEFAULT_QUEUE),
       device_id(file::DEFAULT_DEVICE_ID),
       raw_device(false),
       unlink_on_open(false),
-      queue_length(0)
+      queue_length(0),
+      aio_completion(AIO_GETEVENTS),
+      poll(0),
+      threads(1),
+      max_threads(0),
+      max_bandwidth(0),
+      max_iops(0)
 {
     parse_line(line);
 }
@@ -347,6 +454,11 @@ void disk_config::parse_line(const std::string& line)
     delete_on_exit = false;
     direct = DIRECT_TRY;
     // flash is already set
+    tier = false;
+    compact = false;
+    prealloc = false;
+    discard = false;
+    grow_step = 0;
     queue = file::DEFAULT_QUEUE;
     device_id = file::DEFAULT_DEVICE_ID;
     unlink_on_open = false;
@@ -419,6 +531,27 @@ void disk_config::parse_fileio()
         if (*p == "") {
             // skip blank options
         }
+        else if (eq[0] == "aio_completion")
+        {
+            if (io_impl != "linuxaio") {
+                FOXXLL_THROW(
+                    std::runtime_error, "Parameter '" << *p << "' "
+                        "is only valid for fileio linuxaio "
+                        "in disk configuration file."
+                );
+            }
+
+            if (eq[1] == "getevents") aio_completion = AIO_GETEVENTS;
+            else if (eq[1] == "ring") aio_completion = AIO_RING;
+            else if (eq[1] == "eventfd") aio_completion = AIO_EVENTFD;
+            else
+            {
+                FOXXLL_THROW(
+                    std::runtime_error,
+                    "Invalid parameter '" << *p << "' in disk configuration file."
+                );
+            }
+        }
         else if (*p == "autogrow" || *p == "noautogrow" || eq[0] == "autogrow")
         {
             // TODO: which fileio implementation support autogrow?
@@ -461,6 +594,51 @@ void disk_config::parse_fileio()
                 );
             }
         }
+        else if (eq[0] == "grow_step")
+        {
+            if (!tlx::parse_si_iec_units(eq[1], &grow_step)) {
+                FOXXLL_THROW(
+                    std::runtime_error,
+                    "Invalid parameter '" << *p << "' in disk configuration file."
+                );
+            }
+        }
+        else if (*p == "poll" || eq[0] == "poll")
+        {
+            if (*p == "poll") {
+                poll = default_poll;
+            }
+            else {
+                // strtoul() accepts an empty value and a sign, hence only
+                // plain digits are valid.
+                char* endp;
+                poll = static_cast<unsigned int>(strtoul(eq[1].c_str(), &endp, 10));
+                if (eq[1].empty() ||
+                    eq[1].find_first_not_of("0123456789") != std::string::npos ||
+                    (endp && *endp != 0))
+                {
+                    FOXXLL_THROW(
+                        std::runtime_error,
+                        "Invalid parameter '" << *p << "' in disk configuration file."
+                    );
+                }
+            }
+        }
+        else if (*p == "prealloc")
+        {
+            if (!(io_impl == "syscall" || io_impl == "linuxaio" ||
+                  io_impl == "mmap" || io_impl == "fileperblock_syscall" ||
+                  io_impl == "fileperblock_mmap"))
+            {
+                FOXXLL_THROW(std::runtime_error, "Parameter '" << *p << "' invalid for fileio '" << io_impl << "' in disk configuration file.");
+            }
+
+            prealloc = true;
+        }
+        else if (*p == "discard")
+        {
+            discard = true;
+        }
         else if (eq[0] == "queue")
         {
             if (io_impl == "linuxaio") {
@@ -495,6 +673,56 @@ void disk_config::parse_fileio()
                 );
             }
         }
+        else if (eq[0] == "max_bandwidth")
+        {
+            if (!tlx::parse_si_iec_units(eq[1], &max_bandwidth)) {
+                FOXXLL_THROW(
+                    std::runtime_error,
+                    "Invalid parameter '" << *p << "' in disk configuration file."
+                );
+            }
+        }
+        else if (eq[0] == "max_iops")
+        {
+            char* endp;
+            max_iops = static_cast<unsigned int>(strtoul(eq[1].c_str(), &endp, 10));
+            if (endp && *endp != 0) {
+                FOXXLL_THROW(
+                    std::runtime_error,
+                    "Invalid parameter '" << *p << "' in disk configuration file."
+                );
+            }
+        }
+        else if (eq[0] == "max_threads")
+        {
+            if (io_impl == "linuxaio") {
+                FOXXLL_THROW(std::runtime_error, "Parameter '" << *p << "' invalid for fileio '" << io_impl << "' in disk configuration file.");
+            }
+
+            char* endp;
+            max_threads = static_cast<unsigned int>(strtoul(eq[1].c_str(), &endp, 10));
+            if ((endp && *endp != 0) || max_threads == 0) {
+                FOXXLL_THROW(
+                    std::runtime_error,
+                    "Invalid parameter '" << *p << "' in disk configuration file."
+                );
+            }
+        }
+        else if (eq[0] == "threads")
+        {
+            if (io_impl == "linuxaio") {
+                FOXXLL_THROW(std::runtime_error, "Parameter '" << *p << "' invalid for fileio '" << io_impl << "' in disk configuration file.");
+            }
+
+            char* endp;
+            threads = static_cast<unsigned int>(strtoul(eq[1].c_str(), &endp, 10));
+            if ((endp && *endp != 0) || threads == 0) {
+                FOXXLL_THROW(
+                    std::runtime_error,
+                    "Invalid parameter '" << *p << "' in disk configuration file."
+                );
+            }
+        }
         else if (eq[0] == "device_id" || eq[0] == "devid")
         {
             char* endp;
@@ -506,6 +734,20 @@ void disk_config::parse_fileio()
                 );
             }
         }
+        else if (*p == "tier")
+        {
+            tier = true;
+        }
+        else if (*p == "compact")
+        {
+            if (io_impl == "linuxaio" ||
+                io_impl.compare(0, 12, "fileperblock") == 0)
+            {
+                FOXXLL_THROW(std::runtime_error, "Parameter '" << *p << "' invalid for fileio '" << io_impl << "' in disk configuration file.");
+            }
+
+            compact = true;
+        }
         else if (*p == "raw_device")
         {
             if (!(io_impl == "syscall")) {
@@ -564,6 +806,26 @@ std::string disk_config::fileio_string() const
         oss << " flash";
     }
 
+    if (tier) {
+        oss << " tier";
+    }
+
+    if (compact) {
+        oss << " compact";
+    }
+
+    if (prealloc) {
+        oss << " prealloc";
+    }
+
+    if (discard) {
+        oss << " discard";
+    }
+
+    if (grow_step != 0) {
+        oss << " grow_step=" << grow_step;
+    }
+
     if (queue != file::DEFAULT_QUEUE && queue != file::DEFAULT_LINUXAIO_QUEUE) {
         oss << " queue=" << queue;
     }
@@ -584,6 +846,33 @@ std::string disk_config::fileio_string() const
         oss << " queue_length=" << queue_length;
     }
 
+    if (aio_completion == AIO_RING) {
+        oss << " aio_completion=ring";
+    }
+    else if (aio_completion == AIO_EVENTFD) {
+        oss << " aio_completion=eventfd";
+    }
+
+    if (poll != 0) {
+        oss << " poll=" << poll;
+    }
+
+    if (threads != 1) {
+        oss << " threads=" << threads;
+    }
+
+    if (max_threads != 0) {
+        oss << " max_threads=" << max_threads;
+    }
+
+    if (max_bandwidth != 0) {
+        oss << " max_bandwidth=" << max_bandwidth;
+    }
+
+    if (max_iops != 0) {
+        oss << " max_iops=" << max_iops;
+    }
+
     return oss.str();
 }
 
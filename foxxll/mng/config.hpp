@@ -88,6 +88,31 @@ public:
     //! marks flash drives (configuration entries with flash= instead of disk=)
     bool flash;
 
+    //! use the flash drive as hot tier which caches frequently accessed
+    //! segments of the regular disks, instead of allocating blocks on it
+    bool tier;
+
+    //! keep an autogrow disk file compact: relocate its data towards the start
+    //! of the file in the background and truncate it, see compacting_file.
+    //! Only in effect for disks which are deleted on exit, as the relocations
+    //! are not persisted.
+    bool compact;
+
+    //! allocate the file system blocks when growing the disk file (with
+    //! fallocate) instead of growing it sparse, see file::PREALLOC. With
+    //! fileperblock, spare block files are also prepared in the background.
+    bool prealloc;
+
+    //! discard deleted blocks in the disk file (punch holes or trim the
+    //! device) from a background thread before their space is reused. Off by
+    //! default, deleted blocks are then free at once.
+    bool discard;
+
+    //! grow an autogrow disk file ahead of demand in steps of this many bytes
+    //! from a background thread, such that block allocations do not wait for
+    //! the file to grow. 0 = grow on demand.
+    external_size_type grow_step;
+
     //! select request queue for disk. Use different queues for files on
     //! different disks. queue=-1 -> default queue (one for each disk).
     int queue;
@@ -105,6 +130,39 @@ public:
     //! desired queue length for linuxaio_file and linuxaio_queue
     int queue_length;
 
+    //! how the linuxaio_queue collects completion events: in io_getevents()
+    //! (getevents), from the completion ring mapped into the process (ring),
+    //! or from the ring after waking up on an eventfd (eventfd). The values
+    //! match linuxaio_queue::completion_mode.
+    enum aio_completion_type {
+        AIO_GETEVENTS = 0, AIO_RING = 1, AIO_EVENTFD = 2
+    } aio_completion;
+
+    //! microseconds for which waits for the disk's requests spin for the
+    //! completion before sleeping, and whether direct I/O polls for it (see
+    //! file::set_poll_budget()). 0 = sleep at once, "poll" without a value
+    //! selects default_poll.
+    unsigned int poll;
+
+    //! spin budget of the "poll" option without a value
+    static constexpr unsigned int default_poll = 50;
+
+    //! number of worker threads serving the disk's request queue, not
+    //! available for linuxaio which has its own queue
+    unsigned int threads;
+
+    //! if larger than threads, the number of active worker threads is
+    //! adapted at runtime between threads and max_threads, 0 = fixed
+    unsigned int max_threads;
+
+    //! bandwidth limit of the disk's request queue in bytes per second,
+    //! 0 = unlimited
+    external_size_type max_bandwidth;
+
+    //! limit of I/O operations per second of the disk's request queue,
+    //! 0 = unlimited
+    unsigned int max_iops;
+
     //! \}
 };
 
@@ -121,12 +179,21 @@ class config : public singleton<config>
     //! list of configured disks
     disk_list_type disks_list;
 
+    //! flash device configured as hot tier, not in disks_list (at most one)
+    disk_list_type tier_list;
+
     //! In disks_list, flash devices come after all regular disks
     unsigned first_flash;
 
     //! Finished initializing config
     bool is_initialized;
 
+    //! name of the allocation strategy selected by dynamic_strategy
+    std::string alloc_strategy_;
+
+    //! alloc_strategy_ was set by set_alloc_strategy()
+    bool alloc_strategy_set_;
+
     //! Constructor: this must be inlined to print the header version
     //! string.
     config();
@@ -141,6 +208,10 @@ class config : public singleton<config>
     //! configuration file, or load a default config if everything fails.
     void initialize();
 
+    //! Set the hot tier, throws std::runtime_error if cfg is not a flash
+    //! device or a tier is already configured.
+    void add_tier(const disk_config& cfg);
+
 public:
     //! \name Initialization Functions
     //! \{
@@ -159,12 +230,18 @@ public:
     //! Load default configuration.
     void load_default_config();
 
-    //! Add a disk to the configuration list.
+    //! Add a disk to the configuration list, or set the hot tier if
+    //! cfg.tier is set. Disks keep the order in which they are added, flash
+    //! devices must be added after all regular disks, otherwise
+    //! std::runtime_error is thrown.
     //!
     //! \warning This function should only be used during initialization, as it
     //! has no effect after construction of block_manager.
     config & add_disk(const disk_config& cfg);
 
+    //! Select the allocation strategy of dynamic_strategy by name.
+    config & set_alloc_strategy(const std::string& name);
+
     //! \}
 
 protected:
@@ -210,6 +287,15 @@ public:
     //! \return range [begin, end) of flash device indices
     std::pair<unsigned, unsigned> flash_range() const;
 
+    //! Returns whether a flash device is configured as hot tier.
+    bool has_tier() const
+    {
+        return !tier_list.empty();
+    }
+
+    //! Returns the disk_config of the hot tier, see has_tier().
+    disk_config & tier_disk();
+
     //! Returns mutable disk_config structure for additional disk parameters
     disk_config & disk(size_t disk);
 
@@ -240,6 +326,17 @@ public:
     //! Returns the total size over all disks
     external_size_type total_size() const;
 
+    //! Returns the name of the allocation strategy selected by
+    //! dynamic_strategy: set by set_alloc_strategy(), by the environment
+    //! variable FOXXLL_ALLOC_STRATEGY, or by an "alloc_strategy=<name>" line
+    //! in the configuration file, in this order of precedence. Defaults to
+    //! random_cyclic.
+    const std::string & alloc_strategy()
+    {
+        check_initialized();
+        return alloc_strategy_;
+    }
+
     //! \}
 };
 
@@ -11,10 +11,13 @@
  *  http://www.boost.org/LICENSE_1_0.txt)
  **************************************************************************/
 
+#include <algorithm>
 #include <cassert>
+#include <iterator>
 #include <map>
 #include <ostream>
 #include <utility>
+#include <vector>
 
 #include <foxxll/common/error_handling.hpp>
 #include <foxxll/common/exceptions.hpp>
@@ -62,6 +65,40 @@ void disk_block_allocator::deallocation_error(
     dump();
 }
 
+//! whether [pos, pos + size) overlaps a region of the map
+static bool overlaps_region(
+    const std::map<uint64_t, uint64_t>& regions, uint64_t pos, uint64_t size)
+{
+    auto succ = regions.upper_bound(pos);
+    if (succ != regions.end() && succ->first < pos + size)
+        return true;
+    if (succ == regions.begin())
+        return false;
+    auto pred = std::prev(succ);
+    return pred->first + pred->second > pos;
+}
+
+void disk_block_allocator::check_deallocation(
+    uint64_t block_pos, uint64_t block_size) const
+{
+    if (overlaps_region(free_space_, block_pos, block_size)) {
+        FOXXLL_THROW2(
+            bad_ext_alloc, "disk_block_allocator::check_corruption",
+            "Error: double deallocation of external memory, trying to deallocate "
+            "region " << block_pos << " + " << block_size << " which overlaps "
+            "empty space"
+        );
+    }
+    if (overlaps_region(pending_, block_pos, block_size)) {
+        FOXXLL_THROW2(
+            bad_ext_alloc, "disk_block_allocator::check_corruption",
+            "Error: double deallocation of external memory, trying to deallocate "
+            "region " << block_pos << " + " << block_size << " which overlaps "
+            "a deleted block"
+        );
+    }
+}
+
 void disk_block_allocator::add_free_region(uint64_t block_pos, uint64_t block_size)
 {
     LOG << "Deallocating a block with size: " << block_size << " position: " << block_pos;
@@ -109,7 +146,7 @@ void disk_block_allocator::add_free_region(uint64_t block_pos, uint64_t block_si
                 // coalesce with predecessor
                 region_size += (*pred).second;
                 region_pos = (*pred).first;
-                free_space_.erase(pred);
+                erase_free_region(pred);
             }
         }
         else {
@@ -120,7 +157,7 @@ void disk_block_allocator::add_free_region(uint64_t block_pos, uint64_t block_si
                 if ((*succ).first == region_pos + region_size) {
                     // coalesce with successor
                     region_size += (*succ).second;
-                    free_space_.erase(succ);
+                    erase_free_region(succ);
                     succ = pred;
                 }
 
@@ -133,7 +170,7 @@ void disk_block_allocator::add_free_region(uint64_t block_pos, uint64_t block_si
                         // coalesce with predecessor
                         region_size += (*pred).second;
                         region_pos = (*pred).first;
-                        free_space_.erase(pred);
+                        erase_free_region(pred);
                     }
                 }
             }
@@ -141,14 +178,154 @@ void disk_block_allocator::add_free_region(uint64_t block_pos, uint64_t block_si
                 if ((*succ).first == region_pos + region_size) {
                     // coalesce with successor
                     region_size += (*succ).second;
-                    free_space_.erase(succ);
+                    erase_free_region(succ);
                 }
             }
         }
     }
 
-    free_space_[region_pos] = region_size;
+    insert_free_region(region_pos, region_size);
     free_bytes_ += block_size;
+
+    update_free_space_stats();
+}
+
+void disk_block_allocator::shrink_file()
+{
+    if (!autogrow_ || growing_ || disk_bytes_ <= cfg_bytes_ || free_space_.empty())
+        return;
+
+    space_map_type::iterator last = std::prev(free_space_.end());
+    if (last->first + last->second != disk_bytes_)
+        return;
+
+    const uint64_t region_pos = last->first;
+    // keep the headroom of the background growth
+    const uint64_t new_size = std::max(cfg_bytes_, region_pos + grow_step_);
+    if (new_size >= disk_bytes_)
+        return;
+
+    const uint64_t released = disk_bytes_ - new_size;
+
+    // hysteresis: do not shrink and grow the file in turns
+    if (released < disk_bytes_ / 8)
+        return;
+
+    LOG << "disk_block_allocator::shrink_file() releasing " << released <<
+        " bytes, new size " << new_size;
+
+    erase_free_region(last);
+    if (new_size > region_pos)
+        insert_free_region(region_pos, new_size - region_pos);
+
+    free_bytes_ -= released;
+    disk_bytes_ = new_size;
+    storage_->set_size(disk_bytes_);
+
+    update_free_space_stats();
+}
+
+void disk_block_allocator::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    while (true)
+    {
+        cv_.wait(lock, [this]() {
+                     return stop_ || !discards_.empty() || need_growth();
+                 });
+
+        if (!discards_.empty())
+            discard_blocks(lock);
+        else if (stop_)
+            break;
+        else
+            grow_ahead(lock);
+    }
+}
+
+void disk_block_allocator::grow_ahead(std::unique_lock<std::mutex>& lock)
+{
+    // grow the file without holding the lock, allocations from the free
+    // space continue meanwhile
+    const uint64_t old_size = disk_bytes_;
+    const uint64_t step = grow_step_;
+    growing_ = true;
+    lock.unlock();
+
+    bool ok = true;
+    try {
+        storage_->set_size(old_size + step);
+    }
+    catch (const io_error& e) {
+        LOG1 << "disk_block_allocator: error growing the file ahead of "
+            "demand, growing on demand: " << e.what();
+        ok = false;
+    }
+
+    lock.lock();
+    growing_ = false;
+
+    if (ok) {
+        assert(disk_bytes_ == old_size);
+        add_free_region(old_size, step);
+        disk_bytes_ += step;
+
+        LOG << "disk_block_allocator::grow_ahead() grew the file to " <<
+            disk_bytes_ << ", free:" << free_bytes_;
+    }
+    else {
+        grow_step_ = 0;
+    }
+
+    cv_.notify_all();
+}
+
+void disk_block_allocator::discard_blocks(std::unique_lock<std::mutex>& lock)
+{
+    std::vector<place> batch;
+    batch.swap(discards_);
+    discarding_ = true;
+
+    // blocks deleted on shutdown are not discarded anymore
+    const bool discard = !stop_;
+
+    lock.unlock();
+
+    std::sort(batch.begin(), batch.end());
+
+    if (discard)
+    {
+        for (const place& p : batch)
+        {
+            try {
+                storage_->discard(p.first, p.second);
+            }
+            catch (const io_error& e) {
+                LOG1 << "disk_block_allocator: error discarding " <<
+                    p.second << " bytes at " << p.first << ": " << e.what();
+            }
+        }
+    }
+
+    lock.lock();
+
+    for (const place& p : batch)
+    {
+        // double deallocations were rejected by delete_block()
+        add_free_region(p.first, p.second);
+        pending_.erase(p.first);
+        discard_bytes_ -= p.second;
+    }
+
+    LOG << "disk_block_allocator::discard_blocks() freed " << batch.size() <<
+        " blocks, free:" << free_bytes_ << " total:" << disk_bytes_;
+
+    discarding_ = false;
+    ++discard_rounds_;
+
+    shrink_file();
+    cv_.notify_all();
 }
 
 } // namespace foxxll
@@ -18,10 +18,15 @@
 
 #include <algorithm>
 #include <cassert>
+#include <condition_variable>
 #include <map>
+#include <iterator>
 #include <mutex>
 #include <ostream>
+#include <set>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include <tlx/logger.hpp>
 
@@ -29,6 +34,7 @@
 #include <foxxll/common/exceptions.hpp>
 #include <foxxll/common/types.hpp>
 #include <foxxll/io/file.hpp>
+#include <foxxll/io/iostats.hpp>
 #include <foxxll/mng/bid.hpp>
 #include <foxxll/mng/config.hpp>
 
@@ -41,6 +47,24 @@ namespace foxxll {
  * This class manages allocation of blocks onto a single disk. It contains a map
  * of all currently allocated blocks. The block_manager selects which of the
  * disk_block_allocator objects blocks are drawn from.
+ *
+ * The number of extents allocations are placed in and the fragmentation of the
+ * free space are recorded in the file_stats of the disk.
+ *
+ * If the disk_config enables discard, deleted blocks are discarded in the file
+ * (e.g. by punching holes or trimming the device) in batches by a background
+ * thread and only become free space afterwards, such that they are not
+ * overwritten before. Otherwise they are free at once.
+ *
+ * If the disk_config sets a grow_step, an autogrow file is grown ahead of
+ * demand by the background thread, which keeps at least grow_step bytes free,
+ * such that allocations only wait for the file to grow if they outrun it.
+ *
+ * Growth steps are rounded up to the file's optimal I/O size (e.g. the stripe
+ * width), such that new extents start at its boundaries.
+ *
+ * The background thread is only started if discards or background growth are
+ * enabled.
  */
 class disk_block_allocator
 {
@@ -50,10 +74,17 @@ public:
     disk_block_allocator(file* storage, const disk_config& cfg)
         : cfg_bytes_(cfg.size),
           storage_(storage),
-          autogrow_(cfg.autogrow)
+          autogrow_(cfg.autogrow),
+          discard_(cfg.discard),
+          io_size_(storage->optimal_io_size() % BlockAlignment == 0
+                   ? storage->optimal_io_size() : 0),
+          grow_step_(cfg.autogrow ? round_up_io(cfg.grow_step) : 0)
     {
         // initial growth to configured file size
         grow_file(cfg.size);
+
+        if (discard_ || grow_step_ != 0)
+            thread_ = std::thread(&disk_block_allocator::run, this);
     }
 
     //! non-copyable: delete copy-constructor
@@ -63,6 +94,16 @@ public:
 
     ~disk_block_allocator()
     {
+        if (thread_.joinable())
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+            cv_.notify_all();
+            thread_.join();
+        }
+
         if (disk_bytes_ > cfg_bytes_) { // reduce to original size
             storage_->set_size(cfg_bytes_);
         }
@@ -73,21 +114,27 @@ public:
 
     bool has_available_space(uint64_t bytes) const
     {
-        return autogrow_ || free_bytes_ >= bytes;
+        std::unique_lock<std::mutex> lock(mutex_);
+        return autogrow_ || free_bytes_ + discard_bytes_ >= bytes;
     }
 
+    //! Returns the free bytes, including deleted blocks waiting to be
+    //! discarded.
     uint64_t free_bytes() const
     {
-        return free_bytes_;
+        std::unique_lock<std::mutex> lock(mutex_);
+        return free_bytes_ + discard_bytes_;
     }
 
     uint64_t used_bytes() const
     {
-        return disk_bytes_ - free_bytes_;
+        std::unique_lock<std::mutex> lock(mutex_);
+        return disk_bytes_ - free_bytes_ - discard_bytes_;
     }
 
     uint64_t total_bytes() const
     {
+        std::unique_lock<std::mutex> lock(mutex_);
         return disk_bytes_;
     }
 
@@ -100,6 +147,27 @@ public:
     template <typename BIDIterator>
     void new_blocks(BIDIterator begin, BIDIterator end);
 
+    //! Allocates the blocks [begin, end) in this order in one contiguous
+    //! extent, taken from the smallest free region which is large enough.
+    //! Grows the file if no region fits, and only if it cannot grow falls back
+    //! to new_blocks(), which splits the extent.
+    template <typename BIDIterator>
+    void new_extent(BIDIterator begin, BIDIterator end);
+
+    //! Returns the number of free regions.
+    size_t free_regions() const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return free_space_.size();
+    }
+
+    //! Returns the size of the largest free region.
+    uint64_t largest_free_region() const
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return free_by_size_.empty() ? 0 : free_by_size_.rbegin()->first;
+    }
+
     template <size_t BlockSize>
     void delete_blocks(const BIDArray<BlockSize>& bids)
     {
@@ -116,7 +184,29 @@ public:
             ">(pos=" << bid.offset << ", size=" << bid.size <<
             "), free:" << free_bytes_ << " total:" << disk_bytes_;
 
-        add_free_region(bid.offset, bid.size);
+        const uint64_t size = bid.size;
+        // throws before anything is queued or discarded
+        check_deallocation(bid.offset, size);
+
+        if (!discard_) {
+            add_free_region(bid.offset, size);
+            shrink_file();
+            return;
+        }
+
+        discards_.emplace_back(bid.offset, size);
+        pending_[bid.offset] = size;
+        discard_bytes_ += size;
+
+        lock.unlock();
+        cv_.notify_all();
+    }
+
+    //! Waits until the blocks deleted so far are discarded and free.
+    void flush()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        wait_for_background(lock);
     }
 
 private:
@@ -124,14 +214,73 @@ private:
     using place = std::pair<uint64_t, uint64_t>;
     using space_map_type = std::map<uint64_t, uint64_t>;
 
-    std::mutex mutex_;
+    mutable std::mutex mutex_;
     //! map of free space as places
     space_map_type free_space_;
+    //! free regions as pairs (size, offset), for best-fit allocation
+    std::set<place> free_by_size_;
     uint64_t free_bytes_ = 0;
     uint64_t disk_bytes_ = 0;
     uint64_t cfg_bytes_;
     file* storage_;
     bool autogrow_;
+    //! whether deleted blocks are discarded before they become free
+    const bool discard_;
+    //! unit the file is grown in, 0 = BlockAlignment
+    const uint64_t io_size_;
+
+    //! step of the background growth, 0 = grow on demand
+    uint64_t grow_step_;
+    //! whether the background thread is growing the file without holding
+    //! the mutex_, disk_bytes_ must not change meanwhile
+    bool growing_ = false;
+
+    //! deleted blocks waiting to be discarded, as pairs (offset, size)
+    std::vector<place> discards_;
+    //! deleted blocks of discards_ and of the running discard round, which
+    //! are not yet free, to detect double deallocations
+    space_map_type pending_;
+    //! bytes of discards_ and of the running discard round
+    uint64_t discard_bytes_ = 0;
+    //! whether the background thread is discarding blocks
+    bool discarding_ = false;
+    //! number of finished discard rounds
+    uint64_t discard_rounds_ = 0;
+
+    bool stop_ = false;
+    //! signaled on work for the background thread and when it finished a
+    //! growth step or discard round
+    std::condition_variable cv_;
+    std::thread thread_;
+
+    //! main loop of the background thread
+    void run();
+
+    //! grow the file by grow_step_, expects the mutex_ to be locked
+    void grow_ahead(std::unique_lock<std::mutex>& lock);
+
+    //! discard the deleted blocks and add them to the free space, expects
+    //! the mutex_ to be locked
+    void discard_blocks(std::unique_lock<std::mutex>& lock);
+
+    // whether the free space fell below grow_step_, expects the mutex_ to be
+    // locked
+    bool need_growth() const
+    {
+        return grow_step_ != 0 && free_bytes_ + discard_bytes_ < grow_step_;
+    }
+
+    // wait for a running growth step and until the blocks deleted so far are
+    // free, before growing the file synchronously
+    void wait_for_background(std::unique_lock<std::mutex>& lock)
+    {
+        // blocks deleted during a running round are discarded by the next one
+        const uint64_t rounds = discard_rounds_ + (discarding_ ? 2 : 1);
+        cv_.wait(lock, [&]() {
+                     return !growing_ &&
+                     (discard_bytes_ == 0 || discard_rounds_ >= rounds);
+                 });
+    }
 
     void dump() const;
 
@@ -140,9 +289,66 @@ private:
         const space_map_type::iterator& pred,
         const space_map_type::iterator& succ) const;
 
+    // throw bad_ext_alloc if the block overlaps free space or a deleted block
+    // waiting to be discarded, expects the mutex_ to be locked
+    void check_deallocation(uint64_t block_pos, uint64_t block_size) const;
+
     // expects the mutex_ to be locked to prevent concurrent access
     void add_free_region(uint64_t block_pos, uint64_t block_size);
 
+    // insert or remove an entry of both free_space_ and free_by_size_,
+    // expects the mutex_ to be locked
+    void insert_free_region(uint64_t region_pos, uint64_t region_size)
+    {
+        free_space_[region_pos] = region_size;
+        free_by_size_.emplace(region_size, region_pos);
+    }
+
+    void erase_free_region(space_map_type::iterator region)
+    {
+        free_by_size_.erase(place(region->second, region->first));
+        free_space_.erase(region);
+    }
+
+    // take the first size bytes of a free region, expects the mutex_ to be
+    // locked
+    void take_free_region(space_map_type::iterator region, uint64_t size)
+    {
+        const uint64_t region_pos = region->first;
+        const uint64_t region_size = region->second;
+        erase_free_region(region);
+
+        if (region_size > size)
+            insert_free_region(region_pos + size, region_size - size);
+
+        assert(free_bytes_ >= size);
+        free_bytes_ -= size;
+
+        if (need_growth())
+            cv_.notify_all();
+    }
+
+    // report the free space to the disk's file_stats, expects the mutex_ to
+    // be locked
+    void update_free_space_stats()
+    {
+        storage_->get_file_stats()->free_space_changed(
+            free_bytes_, static_cast<unsigned>(free_space_.size()),
+            free_by_size_.empty() ? 0 : free_by_size_.rbegin()->first);
+    }
+
+    // give free space at the end of an autogrown file back, but not below the
+    // configured size. expects the mutex_ to be locked
+    void shrink_file();
+
+    //! round up a growth of the file to the optimal I/O size
+    uint64_t round_up_io(uint64_t bytes) const
+    {
+        if (io_size_ == 0)
+            return bytes;
+        return (bytes + io_size_ - 1) / io_size_ * io_size_;
+    }
+
     // expects the mutex_ to be locked to prevent concurrent access
     void grow_file(uint64_t extend_bytes)
     {
@@ -174,6 +380,10 @@ void disk_block_allocator::new_blocks(BIDIterator begin, BIDIterator end)
         ", blocks: " << (end - begin) <<
         ", requested_size=" << requested_size;
 
+    // deleted blocks become free after they are discarded
+    if (free_bytes_ < requested_size)
+        wait_for_background(lock);
+
     if (free_bytes_ < requested_size)
     {
         if (!autogrow_) {
@@ -189,18 +399,27 @@ void disk_block_allocator::new_blocks(BIDIterator begin, BIDIterator end)
             " bytes requested, " << free_bytes_ <<
             " bytes free. Trying to extend the external memory space...";
 
-        grow_file(requested_size);
+        grow_file(round_up_io(requested_size));
     }
 
     // dump();
 
-    space_map_type::iterator space =
-        std::find_if(
-            free_space_.begin(), free_space_.end(),
-            [requested_size](const place& entry) {
-                return (entry.second >= requested_size);
-            }
-        );
+    auto find_space = [this, requested_size]() {
+                          return std::find_if(
+                              free_space_.begin(), free_space_.end(),
+                              [requested_size](const place& entry) {
+                                  return (entry.second >= requested_size);
+                              }
+                          );
+                      };
+
+    space_map_type::iterator space = find_space();
+
+    if (space == free_space_.end() && discard_bytes_ != 0)
+    {
+        wait_for_background(lock);
+        space = find_space();
+    }
 
     if (space == free_space_.end() && begin + 1 == end)
     {
@@ -213,35 +432,26 @@ void disk_block_allocator::new_blocks(BIDIterator begin, BIDIterator end)
                 " bytes free. Trying to extend the external memory space...";
         }
 
-        grow_file(begin->size);
+        wait_for_background(lock);
+        grow_file(round_up_io(begin->size));
 
-        space = std::find_if(
-                free_space_.begin(), free_space_.end(),
-                [requested_size](const place& entry) {
-                    return (entry.second >= requested_size);
-                }
-            );
+        space = find_space();
     }
 
     if (space != free_space_.end())
     {
         uint64_t region_pos = (*space).first;
-        uint64_t region_size = (*space).second;
-        free_space_.erase(space);
-
-        if (region_size > requested_size)
-            free_space_[region_pos + requested_size] = region_size - requested_size;
+        take_free_region(space, requested_size);
 
         for (uint64_t pos = region_pos; begin != end; ++begin)
         {
             begin->offset = pos;
             pos += begin->size;
         }
-
-        assert(free_bytes_ >= requested_size);
-        free_bytes_ -= requested_size;
         //dump();
 
+        storage_->get_file_stats()->blocks_allocated(1, 0);
+        update_free_space_stats();
         return;
     }
 
@@ -251,6 +461,7 @@ void disk_block_allocator::new_blocks(BIDIterator begin, BIDIterator end)
 
     assert(end - begin > 1);
 
+    storage_->get_file_stats()->blocks_allocated(0, 1);
     lock.unlock();
 
     BIDIterator middle = begin + ((end - begin) / 2);
@@ -258,6 +469,71 @@ void disk_block_allocator::new_blocks(BIDIterator begin, BIDIterator end)
     new_blocks(middle, end);
 }
 
+template <typename BIDIterator>
+void disk_block_allocator::new_extent(BIDIterator begin, BIDIterator end)
+{
+    if (begin == end)
+        return;
+
+    uint64_t requested_size = 0;
+
+    for (BIDIterator cur = begin; cur != end; ++cur)
+        requested_size += cur->size;
+
+    std::unique_lock<std::mutex> lock(mutex_);
+
+    LOG << "disk_block_allocator::new_extent"
+        ", free:" << free_bytes_ << " total:" << disk_bytes_ <<
+        ", blocks: " << (end - begin) <<
+        ", requested_size=" << requested_size;
+
+    auto fit = free_by_size_.lower_bound(place(requested_size, 0));
+
+    if (fit == free_by_size_.end() && (autogrow_ || discard_bytes_ != 0))
+    {
+        // wait for deleted blocks to become free and for a running growth
+        wait_for_background(lock);
+        fit = free_by_size_.lower_bound(place(requested_size, 0));
+    }
+
+    if (fit == free_by_size_.end() && autogrow_)
+    {
+        // grow the free region at the end of the file, if any
+        uint64_t tail = 0;
+        if (!free_space_.empty())
+        {
+            space_map_type::const_iterator last = std::prev(free_space_.end());
+            if (last->first + last->second == disk_bytes_)
+                tail = last->second;
+        }
+
+        LOG << "No free region of " << requested_size << " bytes, growing "
+            "the external memory space by " << requested_size - tail;
+
+        grow_file(round_up_io(requested_size - tail));
+        fit = free_by_size_.lower_bound(place(requested_size, 0));
+    }
+
+    if (fit == free_by_size_.end())
+    {
+        // the extent is split, new_blocks() checks for free space
+        lock.unlock();
+        return new_blocks(begin, end);
+    }
+
+    uint64_t region_pos = fit->second;
+    take_free_region(free_space_.find(region_pos), requested_size);
+
+    for (uint64_t pos = region_pos; begin != end; ++begin)
+    {
+        begin->offset = pos;
+        pos += begin->size;
+    }
+
+    storage_->get_file_stats()->blocks_allocated(1, 0);
+    update_free_space_stats();
+}
+
 //! \}
 
 } // namespace foxxll
@@ -15,13 +15,14 @@
 #define FOXXLL_MNG_PREFETCH_POOL_HEADER
 
 #include <algorithm>
-#include <list>
-#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include <tlx/logger.hpp>
 
+#include <foxxll/common/timer.hpp>
 #include <foxxll/config.hpp>
+#include <foxxll/mng/busy_block_index.hpp>
 #include <foxxll/mng/write_pool.hpp>
 
 namespace foxxll {
@@ -40,49 +41,31 @@ public:
     using bid_type = typename block_type::bid_type;
 
 protected:
-    struct bid_hash
-    {
-        size_t operator () (const bid_type& bid) const noexcept
-        {
-            size_t result = size_t(bid.storage) +
-                size_t(bid.offset & 0xffffffff) +
-                size_t(bid.offset >> 32);
-            return result;
-        }
-#if FOXXLL_MSVC
-        bool operator () (const bid_type& a, const bid_type& b) const noexcept
-        {
-            return (a.storage < b.storage) || (a.storage == b.storage && a.offset < b.offset);
-        }
-        enum
-        {                               // parameters for hash table
-            bucket_size = 4,            // 0 < bucket_size
-            min_buckets = 8             // min_buckets = 2 ^^ N, 0 < N
-        };
-#endif
-    };
     using busy_entry = std::pair<block_type*, request_ptr>;
-    using unordered_map_type = typename std::unordered_map<bid_type, busy_entry, bid_hash>;
-    using free_blocks_iterator = typename std::list<block_type*>::iterator;
-    using busy_blocks_iterator = typename unordered_map_type::iterator;
+    using busy_blocks_type = busy_block_index<block_type>;
+    using busy_blocks_iterator = typename busy_blocks_type::iterator;
 
-    //! contains free prefetch blocks
-    std::list<block_type*> free_blocks;
+    //! contains free prefetch blocks, used as a stack
+    std::vector<block_type*> free_blocks;
 
     //! blocks that are in reading or already read but not retrieved by user
-    unordered_map_type busy_blocks;
+    busy_blocks_type busy_blocks;
+
+    //! scratch space for batch hints, kept to avoid reallocation
+    std::vector<busy_blocks_iterator> batch;
 
-    //! count number of free blocks, since traversing the std::list is slow.
-    size_t free_blocks_size;
+    //! seconds after which a hinted read which was not yet issued is dropped
+    //! by the disk queue, 0 = never
+    double hint_timeout = 0.0;
 
 public:
     //! Constructs pool.
     //! \param init_size initial number of blocks in the pool
     explicit prefetch_pool(size_t init_size = 1)
-        : free_blocks_size(init_size)
+        : busy_blocks(init_size)
     {
-        size_t i = 0;
-        for ( ; i < init_size; ++i)
+        free_blocks.reserve(init_size);
+        for (size_t i = 0; i < init_size; ++i)
             free_blocks.push_back(new block_type);
     }
 
@@ -94,8 +77,9 @@ public:
     void swap(prefetch_pool& obj)
     {
         std::swap(free_blocks, obj.free_blocks);
-        std::swap(busy_blocks, obj.busy_blocks);
-        std::swap(free_blocks_size, obj.free_blocks_size);
+        busy_blocks.swap(obj.busy_blocks);
+        std::swap(batch, obj.batch);
+        std::swap(hint_timeout, obj.hint_timeout);
     }
 
     //! Waits for completion of all ongoing read requests and frees memory.
@@ -112,8 +96,8 @@ public:
             busy_blocks_iterator i2 = busy_blocks.begin();
             for ( ; i2 != busy_blocks.end(); ++i2)
             {
-                i2->second.second->wait();
-                delete i2->second.first;
+                i2->req->wait();
+                delete i2->block;
             }
         }
         catch (...)
@@ -123,13 +107,13 @@ public:
     //! Returns number of owned blocks.
     size_t size() const
     {
-        return free_blocks_size + busy_blocks.size();
+        return free_blocks.size() + busy_blocks.size();
     }
 
     //! Returns the number of free prefetching blocks.
     size_t free_size() const
     {
-        return free_blocks_size;
+        return free_blocks.size();
     }
 
     //! Returns the number of busy prefetching blocks.
@@ -142,10 +126,24 @@ public:
     void add(block_type*& block)
     {
         free_blocks.push_back(block);
-        ++free_blocks_size;
         block = nullptr; // prevent caller from using the block any further
     }
 
+    //! Sets the time in seconds after which a hinted read which the disk
+    //! queue has not yet issued is dropped instead, 0 disables expiry. Hints
+    //! which are not read by then were likely too speculative, dropping them
+    //! saves their bandwidth. Reading a dropped block reissues the read.
+    void set_hint_timeout(double seconds)
+    {
+        hint_timeout = seconds;
+    }
+
+    //! Returns the timeout of hinted reads in seconds, 0 = never.
+    double get_hint_timeout() const
+    {
+        return hint_timeout;
+    }
+
     //! Take out a block from the pool, one unhinted free block must be
     //! available.
     //! \return pointer to the block. Ownership of the block goes to the caller.
@@ -155,7 +153,6 @@ public:
 
         block_type* p = free_blocks.back();
         free_blocks.pop_back();
-        --free_blocks_size;
         return p;
     }
 
@@ -179,14 +176,13 @@ public:
             return true;
         }
 
-        if (free_blocks_size) //  only if we have a free block
+        if (!free_blocks.empty()) //  only if we have a free block
         {
-            --free_blocks_size;
             block_type* block = free_blocks.back();
             free_blocks.pop_back();
             LOG << "prefetch_pool::hint bid=" << bid << " => prefetching";
-            request_ptr req = block->read(bid);
-            busy_blocks[bid] = busy_entry(block, req);
+            request_ptr req = prefetch(block, bid);
+            busy_blocks.push_back(block, req, bid);
             return true;
         }
         LOG << "prefetch_pool::hint bid=" << bid << " => no free blocks for prefetching";
@@ -217,9 +213,8 @@ public:
             return true;
         }
 
-        if (free_blocks_size) //  only if we have a free block
+        if (!free_blocks.empty()) //  only if we have a free block
         {
-            --free_blocks_size;
             block_type* block = free_blocks.back();
             free_blocks.pop_back();
             if (w_pool.has_request(bid))
@@ -228,18 +223,51 @@ public:
                 LOG << "prefetch_pool::hint2 bid=" << bid << " was in write cache at " << wp_request.first;
                 assert(wp_request.first != 0);
                 w_pool.add(block);  //in exchange
-                busy_blocks[bid] = wp_request;
+                busy_blocks.push_back(wp_request.first, wp_request.second, bid);
                 return true;
             }
             LOG << "prefetch_pool::hint2 bid=" << bid << " => prefetching";
-            request_ptr req = block->read(bid);
-            busy_blocks[bid] = busy_entry(block, req);
+            request_ptr req = prefetch(block, bid);
+            busy_blocks.push_back(block, req, bid);
             return true;
         }
         LOG << "prefetch_pool::hint2 bid=" << bid << " => no free blocks for prefetching";
         return false;
     }
 
+    /*!
+     * Gives hints for prefetching a sequence of blocks. Equivalent to calling
+     * \c hint for each block in turn, but the read requests are submitted
+     * after all lookups, grouped per disk and in ascending offset order.
+     *
+     * \param bids_begin begin of the sequence of blocks to be prefetched
+     * \param bids_end end of the sequence of blocks to be prefetched
+     * \return number of blocks which are hinted after the call
+     */
+    template <typename BidIterator>
+    size_t hint(BidIterator bids_begin, BidIterator bids_end)
+    {
+        return hint_batch(bids_begin, bids_end, nullptr);
+    }
+
+    /*!
+     * Gives hints for prefetching a sequence of blocks, taking blocks that
+     * are currently written from the write pool. Equivalent to calling \c
+     * hint for each block in turn, but the read requests are submitted after
+     * all lookups, grouped per disk and in ascending offset order.
+     *
+     * \param bids_begin begin of the sequence of blocks to be prefetched
+     * \param bids_end end of the sequence of blocks to be prefetched
+     * \param w_pool The corresponding write pool
+     * \return number of blocks which are hinted after the call
+     */
+    template <typename BidIterator>
+    size_t hint(BidIterator bids_begin, BidIterator bids_end,
+                write_pool<block_type>& w_pool)
+    {
+        return hint_batch(bids_begin, bids_end, &w_pool);
+    }
+
     //! Cancel a hint request in case the block is no longer desired.
     bool invalidate(bid_type bid)
     {
@@ -249,12 +277,11 @@ public:
 
         // cancel request if it is a read request, there might be
         // write requests 'stolen' from a write_pool that may not be canceled
-        if (cache_el->second.second->op() == request::READ)
-            cache_el->second.second->cancel();
+        if (cache_el->req->op() == request::READ)
+            cache_el->req->cancel();
         // finish the request
-        cache_el->second.second->wait();
-        ++free_blocks_size;
-        free_blocks.push_back(cache_el->second.first);
+        cache_el->req->wait();
+        free_blocks.push_back(cache_el->block);
         busy_blocks.erase(cache_el);
         return true;
     }
@@ -274,7 +301,7 @@ public:
         if (cache_el == busy_blocks.end())
             return request_ptr(); // invalid pointer
         else
-            return cache_el->second.second;
+            return cache_el->req;
     }
 
     //! Returns true if the blocks was hinted and the request is finished.
@@ -310,12 +337,11 @@ public:
 
         // cached
         LOG << "prefetch_pool::read bid=" << bid << " => copy in cache exists";
-        ++free_blocks_size;
         free_blocks.push_back(block);
-        block = cache_el->second.first;
-        request_ptr result = cache_el->second.second;
+        block = cache_el->block;
+        request_ptr result = cache_el->req;
         busy_blocks.erase(cache_el);
-        return result;
+        return claim(block, bid, result);
     }
 
     request_ptr read(block_type*& block, bid_type bid, write_pool<block_type>& w_pool)
@@ -326,12 +352,11 @@ public:
         {
             // cached
             LOG << "prefetch_pool::read bid=" << bid << " => copy in cache exists";
-            ++free_blocks_size;
             free_blocks.push_back(block);
-            block = cache_el->second.first;
-            request_ptr result = cache_el->second.second;
+            block = cache_el->block;
+            request_ptr result = cache_el->req;
             busy_blocks.erase(cache_el);
-            return result;
+            return claim(block, bid, result);
         }
 
         // try w_pool cache
@@ -342,6 +367,7 @@ public:
             assert(wp_request.first != 0);
             w_pool.add(block);  //in exchange
             block = wp_request.first;
+            wp_request.second->set_priority(request::DEMAND);
             return wp_request.second;
         }
 
@@ -361,22 +387,114 @@ public:
         int64_t diff = int64_t(new_size) - int64_t(size());
         if (diff > 0)
         {
-            free_blocks_size += diff;
             while (--diff >= 0)
                 free_blocks.push_back(new block_type);
 
             return size();
         }
 
-        while (diff < 0 && free_blocks_size > 0)
+        while (diff < 0 && !free_blocks.empty())
         {
             ++diff;
-            --free_blocks_size;
             delete free_blocks.back();
             free_blocks.pop_back();
         }
         return size();
     }
+
+protected:
+    //! issue a hinted read with the current expiry
+    request_ptr prefetch(block_type* block, const bid_type& bid)
+    {
+        request_ptr req = block->read(
+            bid, completion_handler(), request::PREFETCH);
+        if (hint_timeout > 0)
+            req->set_deadline(timestamp() + hint_timeout);
+        return req;
+    }
+
+    //! promote the hinted request of a block the caller is about to wait for,
+    //! reissue the read if the disk queue dropped it
+    request_ptr claim(block_type* block, const bid_type& bid,
+                      const request_ptr& req)
+    {
+        if (req->set_priority(request::DEMAND) || !req->dropped())
+            return req;
+
+        LOG << "prefetch_pool::read bid=" << bid << " => hint expired, retrieving to " << block;
+        return block->read(bid);
+    }
+
+    template <typename BidIterator>
+    size_t hint_batch(BidIterator bids_begin, BidIterator bids_end,
+                      write_pool<block_type>* w_pool)
+    {
+        size_t hinted = 0;
+        batch.clear();
+
+        for ( ; bids_begin != bids_end; ++bids_begin)
+        {
+            const bid_type& bid = *bids_begin;
+
+            // if block is already hinted, no need to hint it again
+            if (in_prefetching(bid)) {
+                LOG << "prefetch_pool::hint_batch bid=" << bid << " was already cached";
+                ++hinted;
+                continue;
+            }
+
+            if (free_blocks.empty()) {
+                LOG << "prefetch_pool::hint_batch bid=" << bid << " => no free blocks for prefetching";
+                continue;
+            }
+
+            block_type* block = free_blocks.back();
+            free_blocks.pop_back();
+            ++hinted;
+
+            if (w_pool && w_pool->has_request(bid))
+            {
+                busy_entry wp_request = w_pool->steal_request(bid);
+                LOG << "prefetch_pool::hint_batch bid=" << bid << " was in write cache at " << wp_request.first;
+                assert(wp_request.first != 0);
+                w_pool->add(block);  //in exchange
+                busy_blocks.push_back(wp_request.first, wp_request.second, bid);
+                continue;
+            }
+
+            // register block now, the read is issued after all lookups
+            batch.push_back(busy_blocks.push_back(block, request_ptr(), bid));
+        }
+
+        std::sort(batch.begin(), batch.end(),
+                  [](const busy_blocks_iterator& a, const busy_blocks_iterator& b) {
+                      return bid_queue_order()(a->bid, b->bid);
+                  });
+
+        try
+        {
+            for (busy_blocks_iterator& it : batch)
+            {
+                LOG << "prefetch_pool::hint_batch bid=" << it->bid << " => prefetching";
+                it->req = prefetch(it->block, it->bid);
+            }
+        }
+        catch (...)
+        {
+            // unregister the blocks whose reads were not issued
+            for (busy_blocks_iterator& it : batch)
+            {
+                if (it->req.valid())
+                    continue;
+                free_blocks.push_back(it->block);
+                busy_blocks.erase(it);
+            }
+            batch.clear();
+            throw;
+        }
+
+        return hinted;
+    }
 };
 
 //! \}
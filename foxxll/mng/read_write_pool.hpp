@@ -14,7 +14,9 @@
 #define FOXXLL_MNG_READ_WRITE_POOL_HEADER
 
 #include <algorithm>
+#include <iterator>
 #include <utility>
+#include <vector>
 
 #include <tlx/define.hpp>
 
@@ -43,6 +45,9 @@ protected:
     prefetch_pool_type* p_pool;
     bool delete_pools;
 
+    //! scratch space for re-hinting blocks after batch writes
+    std::vector<bid_type> rehint_bids;
+
 public:
     //! Constructs pool.
     //! \param init_size_prefetch initial number of blocks in the prefetch pool
@@ -64,6 +69,7 @@ public:
         std::swap(w_pool, obj.w_pool);
         std::swap(p_pool, obj.p_pool);
         std::swap(delete_pools, obj.delete_pools);
+        std::swap(rehint_bids, obj.rehint_bids);
     }
 
     //! Waits for completion of all ongoing requests and frees memory.
@@ -115,6 +121,34 @@ public:
         return result;
     }
 
+    //! Passes a sequence of blocks to the pool for writing. The write
+    //! requests are submitted grouped per disk, stale copies in the prefetch
+    //! pool are invalidated and re-hinted in one batch.
+    //! \param blocks_begin begin of the sequence of blocks to write.
+    //! Ownership of the blocks goes to the pool, the pointers are set to
+    //! nullptr.
+    //! \param blocks_end end of the sequence of blocks to write
+    //! \param bids_begin locations, where to write the blocks
+    template <typename BlockIterator, typename BidIterator>
+    void write(BlockIterator blocks_begin, BlockIterator blocks_end,
+               BidIterator bids_begin)
+    {
+        BidIterator bids_end = bids_begin;
+        std::advance(bids_end, std::distance(blocks_begin, blocks_end));
+
+        w_pool->write(blocks_begin, blocks_end, bids_begin);
+
+        rehint_bids.clear();
+        for ( ; bids_begin != bids_end; ++bids_begin)
+        {
+            if (p_pool->invalidate(*bids_begin))
+                rehint_bids.push_back(*bids_begin);
+        }
+
+        if (!rehint_bids.empty())
+            p_pool->hint(rehint_bids.begin(), rehint_bids.end(), *w_pool);
+    }
+
     //! Take out a block from the pool.
     //! \return pointer to the block. Ownership of the block goes to the caller.
     block_type * steal()
@@ -142,6 +176,18 @@ public:
         return p_pool->hint(bid, *w_pool);
     }
 
+    //! Gives hints for prefetching a sequence of blocks. The lookups in the
+    //! write and prefetch pools are done in one pass, the resulting reads are
+    //! submitted grouped per disk and in ascending offset order.
+    //! \param bids_begin begin of the sequence of blocks to be prefetched
+    //! \param bids_end end of the sequence of blocks to be prefetched
+    //! \return number of blocks which are hinted after the call
+    template <typename BidIterator>
+    size_t hint(BidIterator bids_begin, BidIterator bids_end)
+    {
+        return p_pool->hint(bids_begin, bids_end, *w_pool);
+    }
+
     //! Cancel a hint request in case the block is no longer desired.
     bool invalidate(bid_type bid)
     {
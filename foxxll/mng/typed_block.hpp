@@ -292,54 +292,66 @@ public:
      * Writes block to the disk(s).
      * \param bid block identifier, points the file(disk) and position
      * \param on_complete completion handler
+     * \param priority quality of service class of the request
      * \return \c pointer_ptr object to track status I/O operation after the call
      */
     request_ptr write(const bid_type& bid,
-                      completion_handler on_complete = completion_handler())
+                      completion_handler on_complete = completion_handler(),
+                      request::priority_class priority = request::DEMAND)
     {
         LOGC(debug_block_life_cycle) << "BLC:write  " << bid;
-        return bid.storage->awrite(this, bid.offset, raw_size, on_complete);
+        return bid.storage->awrite(this, bid.offset, raw_size, on_complete,
+                                   priority);
     }
 
     /*!
      * Reads block from the disk(s).
      * \param bid block identifier, points the file(disk) and position
      * \param on_complete completion handler
+     * \param priority quality of service class of the request
      * \return \c pointer_ptr object to track status I/O operation after the call
      */
     request_ptr read(const bid_type& bid,
-                     completion_handler on_complete = completion_handler())
+                     completion_handler on_complete = completion_handler(),
+                     request::priority_class priority = request::DEMAND)
     {
         LOGC(debug_block_life_cycle) << "BLC:read   " << bid;
-        return bid.storage->aread(this, bid.offset, raw_size, on_complete);
+        return bid.storage->aread(this, bid.offset, raw_size, on_complete,
+                                  priority);
     }
 
     /*!
      * Writes block to the disk(s).
      * \param bid block identifier, points the file(disk) and position
      * \param on_complete completion handler
+     * \param priority quality of service class of the request
      * \return \c pointer_ptr object to track status I/O operation after the call
      */
     request_ptr write(const BID<0>& bid,
-                      completion_handler on_complete = completion_handler())
+                      completion_handler on_complete = completion_handler(),
+                      request::priority_class priority = request::DEMAND)
     {
         LOGC(debug_block_life_cycle) << "BLC:write  " << bid;
         assert(bid.size >= raw_size);
-        return bid.storage->awrite(this, bid.offset, raw_size, on_complete);
+        return bid.storage->awrite(this, bid.offset, raw_size, on_complete,
+                                   priority);
     }
 
     /*!
      * Reads block from the disk(s).
      * \param bid block identifier, points the file(disk) and position
      * \param on_complete completion handler
+     * \param priority quality of service class of the request
      * \return \c pointer_ptr object to track status I/O operation after the call
      */
     request_ptr read(const BID<0>& bid,
-                     completion_handler on_complete = completion_handler())
+                     completion_handler on_complete = completion_handler(),
+                     request::priority_class priority = request::DEMAND)
     {
         LOGC(debug_block_life_cycle) << "BLC:read   " << bid;
         assert(bid.size >= raw_size);
-        return bid.storage->aread(this, bid.offset, raw_size, on_complete);
+        return bid.storage->aread(this, bid.offset, raw_size, on_complete,
+                                  priority);
     }
 
     static void* operator new (size_t bytes)
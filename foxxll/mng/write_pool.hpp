@@ -17,13 +17,15 @@
 #include <cassert>
 
 #include <algorithm>
-#include <list>
 #include <utility>
+#include <vector>
 
 #include <tlx/define.hpp>
 
 #include <foxxll/config.hpp>
 #include <foxxll/io/request_operations.hpp>
+#include <foxxll/mng/bid.hpp>
+#include <foxxll/mng/busy_block_index.hpp>
 
 #define FOXXLL_VERBOSE_WPOOL(msg) LOG << "write_pool[" << static_cast<void*>(this) << "]" << msg
 
@@ -42,34 +44,32 @@ public:
     using block_type = BlockType;
     using bid_type = typename block_type::bid_type;
 
-    // a hack to make wait_any work with busy_entry type
-    struct busy_entry
+    using busy_blocks_type = busy_block_index<block_type>;
+    using busy_entry = typename busy_blocks_type::entry;
+    using busy_blocks_iterator = typename busy_blocks_type::iterator;
+
+protected:
+    // contains free write blocks, used as a stack
+    std::vector<block_type*> free_blocks;
+    // blocks that are in writing, indexed by bid
+    busy_blocks_type busy_blocks;
+
+    struct batch_entry
     {
         block_type* block;
-        request_ptr req;
         bid_type bid;
-
-        busy_entry() : block(nullptr) { }
-        busy_entry(const busy_entry& a) : block(a.block), req(a.req), bid(a.bid) { }
-        busy_entry(block_type*& bl, request_ptr& r, bid_type& bi)
-            : block(bl), req(r), bid(bi) { }
-
-        operator request_ptr () { return req; }
+        size_t pos;
     };
-    using free_blocks_iterator = typename std::list<block_type*>::iterator;
-    using busy_blocks_iterator = typename std::list<busy_entry>::iterator;
-
-protected:
-    // contains free write blocks
-    std::list<block_type*> free_blocks;
-    // blocks that are in writing
-    std::list<busy_entry> busy_blocks;
+    // scratch space for batch writes, kept to avoid reallocation
+    std::vector<batch_entry> batch;
 
 public:
     //! Constructs pool.
     //! \param init_size initial number of blocks in the pool
     explicit write_pool(size_t init_size = 1)
+        : busy_blocks(init_size)
     {
+        free_blocks.reserve(init_size);
         for (size_t i = 0; i < init_size; ++i)
         {
             free_blocks.push_back(new block_type);
@@ -85,7 +85,8 @@ public:
     void swap(write_pool& obj)
     {
         std::swap(free_blocks, obj.free_blocks);
-        std::swap(busy_blocks, obj.busy_blocks);
+        busy_blocks.swap(obj.busy_blocks);
+        std::swap(batch, obj.batch);
     }
 
     //! Waits for completion of all ongoing write requests and frees memory.
@@ -107,10 +108,7 @@ public:
             for (busy_blocks_iterator i2 = busy_blocks.begin(); i2 != busy_blocks.end(); ++i2)
             {
                 i2->req->wait();
-                if (free_blocks.empty())
-                    FOXXLL_VERBOSE_WPOOL("  delete busy block=(empty)");
-                else
-                    FOXXLL_VERBOSE_WPOOL("  delete busy block=" << free_blocks.back());
+                FOXXLL_VERBOSE_WPOOL("  delete busy block=" << i2->block);
                 delete i2->block;
             }
         }
@@ -130,24 +128,56 @@ public:
     request_ptr write(block_type*& block, bid_type bid)
     {
         FOXXLL_VERBOSE_WPOOL("::write: " << block << " @ " << bid);
-        for (busy_blocks_iterator i2 = busy_blocks.begin(); i2 != busy_blocks.end(); ++i2)
+        busy_blocks_iterator i2 = busy_blocks.find(bid);
+        if (i2 != busy_blocks.end())
         {
-            if (i2->bid == bid) {
-                assert(i2->block != block);
-                FOXXLL_VERBOSE_WPOOL("WAW dependency");
-                // try to cancel the obsolete request
-                i2->req->cancel();
-                // invalidate the bid of the stale write request,
-                // prevents prefetch_pool from stealing a stale block
-                i2->bid.storage = 0;
-            }
+            assert(i2->block != block);
+            FOXXLL_VERBOSE_WPOOL("WAW dependency");
+            // try to cancel the obsolete request
+            i2->req->cancel();
+            // remove the stale write request from the index,
+            // prevents prefetch_pool from stealing a stale block
+            busy_blocks.unindex(i2);
         }
-        request_ptr result = block->write(bid);
-        busy_blocks.push_back(busy_entry(block, result, bid));
+        request_ptr result = block->write(
+            bid, completion_handler(), request::WRITEBACK);
+        busy_blocks.push_back(block, result, bid);
         block = nullptr; // prevent caller from using the block any further
         return result;
     }
 
+    //! Passes a sequence of blocks to the pool for writing. Equivalent to
+    //! calling \c write for each block in turn, but the write requests are
+    //! submitted grouped per disk and in ascending offset order.
+    //! \param blocks_begin begin of the sequence of blocks to write.
+    //! Ownership of the blocks goes to the pool, the pointers are set to
+    //! nullptr.
+    //! \param blocks_end end of the sequence of blocks to write
+    //! \param bids_begin locations, where to write the blocks
+    template <typename BlockIterator, typename BidIterator>
+    void write(BlockIterator blocks_begin, BlockIterator blocks_end,
+               BidIterator bids_begin)
+    {
+        batch.clear();
+        for (size_t pos = 0; blocks_begin != blocks_end;
+             ++blocks_begin, ++bids_begin, ++pos)
+        {
+            batch.push_back(batch_entry { *blocks_begin, *bids_begin, pos });
+            *blocks_begin = nullptr; // prevent caller from using the block any further
+        }
+
+        // later writes to the same bid must be issued last
+        std::sort(batch.begin(), batch.end(),
+                  [](const batch_entry& a, const batch_entry& b) {
+                      if (a.bid == b.bid)
+                          return a.pos < b.pos;
+                      return bid_queue_order()(a.bid, b.bid);
+                  });
+
+        for (batch_entry& e : batch)
+            write(e.block, e.bid);
+    }
+
     //! Take out a block from the pool.
     //! \return pointer to the block. Ownership of the block goes to the caller.
     block_type * steal()
@@ -161,6 +191,11 @@ public:
             return p;
         }
         FOXXLL_VERBOSE_WPOOL("::steal : all " << busy_blocks.size() << " are busy");
+        // Completion is a property of the requests, not of the BIDs, hence
+        // waiting for any write has to visit the whole busy list; the BID
+        // index does not help here. The scan does not allocate.
+        // the caller is blocked until the oldest write completes
+        busy_blocks.begin()->req->set_priority(request::DEMAND);
         busy_blocks_iterator completed = wait_any(busy_blocks.begin(), busy_blocks.end());
         assert(completed != busy_blocks.end()); // we got something reasonable from wait_any
         assert(completed->req->poll());         // and it is *really* completed
@@ -193,34 +228,28 @@ public:
 
     bool has_request(bid_type bid)
     {
-        for (busy_blocks_iterator i2 = busy_blocks.begin(); i2 != busy_blocks.end(); ++i2)
-        {
-            if (i2->bid == bid)
-                return true;
-        }
-        return false;
+        return busy_blocks.find(bid) != busy_blocks.end();
     }
 
     // returns a block and a (potentially unfinished) I/O request associated with it
     std::pair<block_type*, request_ptr> steal_request(bid_type bid)
     {
-        for (busy_blocks_iterator i2 = busy_blocks.begin(); i2 != busy_blocks.end(); ++i2)
+        busy_blocks_iterator i2 = busy_blocks.find(bid);
+        if (i2 == busy_blocks.end())
         {
-            if (i2->bid == bid)
-            {
-                // remove busy block from list, request has not yet been waited for!
-                block_type* blk = i2->block;
-                request_ptr req = i2->req;
-                busy_blocks.erase(i2);
-
-                FOXXLL_VERBOSE_WPOOL("::steal_request block=" << blk);
-                // hand over block and (unfinished) request to caller
-                return std::pair<block_type*, request_ptr>(blk, req);
-            }
+            FOXXLL_VERBOSE_WPOOL("::steal_request NOT FOUND");
+            // not matching request found, return a dummy
+            return std::pair<block_type*, request_ptr>(nullptr, request_ptr());
         }
-        FOXXLL_VERBOSE_WPOOL("::steal_request NOT FOUND");
-        // not matching request found, return a dummy
-        return std::pair<block_type*, request_ptr>(nullptr, request_ptr());
+
+        // remove busy block from list, request has not yet been waited for!
+        block_type* blk = i2->block;
+        request_ptr req = i2->req;
+        busy_blocks.erase(i2);
+
+        FOXXLL_VERBOSE_WPOOL("::steal_request block=" << blk);
+        // hand over block and (unfinished) request to caller
+        return std::pair<block_type*, request_ptr>(blk, req);
     }
 
     void add(block_type*& block)
@@ -231,6 +260,8 @@ public:
     }
 
 protected:
+    //! Moves the blocks of all completed writes to the free list, polls each
+    //! busy request once and does not allocate.
     void check_all_busy()
     {
         busy_blocks_iterator cur = busy_blocks.begin();
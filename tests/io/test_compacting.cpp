@@ -0,0 +1,149 @@
+/***************************************************************************
+ *  tests/io/test_compacting.cpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <foxxll/common/aligned_alloc.hpp>
+#include <foxxll/io.hpp>
+
+//! \example io/test_compacting.cpp
+//! This tests that discarded segments of a compacting_file are released, that
+//! compaction moves the remaining segments to the start of the base file and
+//! truncates it, and that the contents are unaffected.
+
+using foxxll::compacting_file;
+
+static const size_t segment_size = 1024 * 1024;
+
+//! write a distinct pattern into a segment
+void fill(foxxll::file_ptr file, char* buffer, size_t seg)
+{
+    memset(buffer, static_cast<int>(seg + 1), segment_size);
+    file->awrite(buffer, seg * segment_size, segment_size)->wait();
+}
+
+//! check the pattern of a segment, 0 = unmapped
+void check(foxxll::file_ptr file, char* buffer, size_t seg, int value)
+{
+    file->aread(buffer, seg * segment_size, segment_size)->wait();
+    die_unequal(buffer[0], static_cast<char>(value));
+    die_unequal(buffer[segment_size - 1], static_cast<char>(value));
+}
+
+//! threads writing, checking and discarding their own segments during
+//! background compaction
+void stress(foxxll::file_ptr file, size_t thread, size_t num_threads)
+{
+    char* buffer = static_cast<char*>(
+        foxxll::aligned_alloc<4096>(segment_size));
+    std::default_random_engine rng(static_cast<unsigned>(thread));
+
+    for (size_t i = 0; i < 200; ++i)
+    {
+        const size_t seg = thread + num_threads * (rng() % 8);
+        if (rng() % 4 == 0) {
+            file->discard(seg * segment_size, segment_size);
+            check(file, buffer, seg, 0);
+        }
+        else {
+            fill(file, buffer, seg);
+            check(file, buffer, seg, static_cast<int>(seg + 1));
+        }
+    }
+
+    foxxll::aligned_dealloc<4096>(buffer);
+}
+
+int main()
+{
+    char* buffer = static_cast<char*>(
+        foxxll::aligned_alloc<4096>(segment_size));
+
+    foxxll::file_ptr base = tlx::make_counting<foxxll::memory_file>(45);
+
+    {
+        tlx::counting_ptr<compacting_file> file =
+            tlx::make_counting<compacting_file>(base, segment_size, 0.0);
+        file->set_size(8 * segment_size);
+        die_unequal(file->base_segments(), 0u);
+
+        for (size_t s = 0; s < 8; ++s)
+            fill(file, buffer, s);
+        die_unequal(file->base_segments(), 8u);
+        die_unequal(file->mapped_segments(), 8u);
+
+        // discarded segments are released, the tail is truncated at once
+        file->discard(1 * segment_size, 3 * segment_size);
+        die_unequal(file->mapped_segments(), 5u);
+        file->discard(7 * segment_size, segment_size);
+        die_unequal(file->base_segments(), 7u);
+        die_unequal(base->size(), 7 * segment_size);
+
+        // partially discarded segments stay
+        file->discard(4 * segment_size, segment_size / 2);
+        die_unequal(file->mapped_segments(), 4u);
+
+        // segments 6, 5 and 4 move into the free base segments 1, 2 and 3
+        die_unequal(file->compact(), 3u);
+        die_unequal(file->relocations(), 3u);
+        die_unequal(file->base_segments(), 4u);
+        die_unequal(base->size(), 4 * segment_size);
+        die_unequal(file->compact(), 0u);
+
+        check(file, buffer, 0, 1);
+        check(file, buffer, 1, 0);
+        check(file, buffer, 5, 6);
+        check(file, buffer, 6, 7);
+        check(file, buffer, 7, 0);
+        file->aread(buffer, 4 * segment_size + segment_size / 2,
+                    segment_size / 2)->wait();
+        die_unequal(buffer[0], static_cast<char>(5));
+
+        // writing an unmapped segment fills the first free base segment
+        fill(file, buffer, 2);
+        die_unequal(file->base_segments(), 5u);
+
+        // shrinking the file releases the segments behind the end
+        file->set_size(5 * segment_size);
+        die_unequal(file->mapped_segments(), 3u);
+        check(file, buffer, 2, 3);
+    }
+
+    {
+        // concurrent I/O during background compaction
+        const size_t num_threads = 4;
+        tlx::counting_ptr<compacting_file> file =
+            tlx::make_counting<compacting_file>(base, segment_size, 0.001);
+        file->set_size(8 * num_threads * segment_size);
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t)
+            threads.emplace_back(stress, file, t, num_threads);
+        for (std::thread& t : threads)
+            t.join();
+
+        LOG1 << "relocations during I/O: " << file->relocations();
+    }
+
+    foxxll::aligned_dealloc<4096>(buffer);
+    base->close_remove();
+
+    return 0;
+}
+
+/**************************************************************************/
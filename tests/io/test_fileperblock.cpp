@@ -0,0 +1,119 @@
+/***************************************************************************
+ *  tests/io/test_fileperblock.cpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <foxxll/common/aligned_alloc.hpp>
+#include <foxxll/io.hpp>
+
+using foxxll::file;
+
+static const size_t size = 1024 * 384;
+
+// renamed files are removed by their new path, as fileperblock_file does
+// with the spare files it moves into place
+void test_rename(const std::string& path)
+{
+    foxxll::file_ptr file10 = tlx::make_counting<foxxll::syscall_file>(
+            path + "_spare", file::CREAT | file::RDWR
+        );
+    die_unless(dynamic_cast<foxxll::ufs_file_base*>(file10.get())->rename(path));
+    die_if(std::ifstream(path + "_spare").good());
+    die_unless(std::ifstream(path).good());
+
+    // an existing target is not replaced
+    foxxll::file_ptr file11 = tlx::make_counting<foxxll::syscall_file>(
+            path + "_spare", file::CREAT | file::RDWR
+        );
+    die_if(dynamic_cast<foxxll::ufs_file_base*>(file11.get())->rename(path));
+    die_unless(std::ifstream(path + "_spare").good());
+    file11->close_remove();
+    die_if(std::ifstream(path + "_spare").good());
+    file10->close_remove();
+    die_if(std::ifstream(path).good());
+}
+
+// fileperblock_file keeps two block files open and prepares spare files
+void test_fileperblock(const std::string& path, char* buffer)
+{
+    using fpb_file = foxxll::fileperblock_file<foxxll::syscall_file>;
+    tlx::counting_ptr<fpb_file> file3(
+        new fpb_file(path,
+                     file::CREAT | file::RDWR | file::DIRECT | file::PREALLOC,
+                     2, file::NO_ALLOCATOR, file::DEFAULT_DEVICE_ID, 2));
+    file3->lock();
+
+    for (unsigned i = 0; i < 4; i++) {
+        memset(buffer, static_cast<int>(i + 1), size);
+        file3->awrite(buffer, i * size, size)->wait();
+    }
+    die_unequal(file3->open_files(), 2u);
+
+    for (unsigned i = 0; i < 4; i++) {
+        file3->aread(buffer, i * size, size)->wait();
+        die_unequal(buffer[size - 1], static_cast<char>(i + 1));
+    }
+    file3->aread(buffer, 3 * size, size)->wait();
+    die_unequal(file3->cache_hits(), 1u);
+
+    // a block which has a file keeps it, spare files are not moved onto it
+    memset(buffer, 9, size);
+    file3->awrite(buffer, 0, size)->wait();
+    file3->aread(buffer, 0, size)->wait();
+    die_unequal(buffer[size - 1], 9);
+
+    // discarded blocks are closed and read back zeros
+    file3->discard(3 * size, size);
+    die_unequal(file3->open_files(), 1u);
+    file3->aread(buffer, 3 * size, size)->wait();
+    die_unequal(buffer[0], 0);
+
+    // copies between block files, and from another file
+    foxxll::file_ptr file4 = tlx::make_counting<foxxll::memory_file>(4);
+    memset(buffer, 7, size);
+    file4->awrite(buffer, 0, size)->wait();
+    file3->acopy(size, file3.get(), 4 * size, size)->wait();
+    file4->acopy(0, file3.get(), 5 * size, size)->wait();
+    file3->aread(buffer, 4 * size, size)->wait();
+    die_unequal(buffer[size - 1], 2);
+    file3->aread(buffer, 5 * size, size)->wait();
+    die_unequal(buffer[size - 1], 7);
+    file4->close_remove();
+
+    for (unsigned i = 0; i < 6; i++)
+        file3->discard(i * size, size);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        LOG1 << "Usage: " << argv[0] << " tempdir";
+        return -1;
+    }
+
+    auto* buffer = static_cast<char*>(foxxll::aligned_alloc<4096>(size));
+
+    test_rename(std::string(argv[1]) + "/test_fileperblock_rename");
+    test_fileperblock(std::string(argv[1]) + "/test_fileperblock", buffer);
+
+    foxxll::aligned_dealloc<4096>(buffer);
+
+    return 0;
+}
+
+/**************************************************************************/
@@ -11,14 +11,21 @@
  *  http://www.boost.org/LICENSE_1_0.txt)
  **************************************************************************/
 
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <limits>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <tlx/die.hpp>
 #include <tlx/logger.hpp>
 
 #include <foxxll/common/aligned_alloc.hpp>
 #include <foxxll/io.hpp>
+#include <foxxll/io/bounce_buffer.hpp>
+#include <foxxll/mng/bid.hpp>
 
 //! \example io/test_io.cpp
 //! This is an example of use of \c \<foxxll\> files, requests, and
@@ -34,6 +41,276 @@ struct my_handler
     }
 };
 
+// alignment detected when opening the file
+void test_alignment(foxxll::file_ptr file)
+{
+    const size_t block_size = file->logical_block_size();
+    LOG1 << "logical block size " << block_size <<
+        ", physical block size " << file->physical_block_size() <<
+        ", memory alignment " << file->memory_alignment() <<
+        ", optimal I/O size " << file->optimal_io_size();
+    die_unless(block_size > 0 && (block_size & (block_size - 1)) == 0);
+    die_unless(file->memory_alignment() > 0);
+    die_unless(file->physical_block_size() >= block_size);
+}
+
+// throttle the queue of the file to 100 requests per second
+void test_throttle(foxxll::file_ptr file, char* buffer, int size)
+{
+    foxxll::disk_queues::get_instance()->set_rate_limit(
+        file->get_queue_id(), 0, 100);
+
+    foxxll::stats_data stats_begin(*foxxll::stats::get_instance());
+    double start = foxxll::timestamp();
+
+    foxxll::request_ptr req[16];
+    for (unsigned i = 0; i < 16; i++)
+        req[i] = file->awrite(buffer, i * size, size, my_handler());
+    wait_all(req, 16);
+
+    double elapsed = foxxll::timestamp() - start;
+    foxxll::stats_data stats_diff =
+        foxxll::stats_data(*foxxll::stats::get_instance()) - stats_begin;
+
+    LOG1 << "throttled 16 requests to 100/s in " << elapsed << " s";
+    die_unless(elapsed >= 0.1);
+    die_unless(stats_diff.get_throttle_count() > 0);
+    die_unless(stats_diff.get_throttle_time() > 0);
+
+    foxxll::disk_queues::get_instance()->set_rate_limit(
+        file->get_queue_id(), 0, 0);
+}
+
+// a discarded range keeps the file size and reads zeros where the file
+// system supports punching holes
+void test_discard(foxxll::file_ptr file, char* buffer, int size)
+{
+    const foxxll::file::offset_type file_size = file->size();
+
+    memset(buffer, 1, size);
+    file->awrite(buffer, size, size)->wait();
+    file->discard(size, size);
+    memset(buffer, 2, size);
+    file->aread(buffer, size, size)->wait();
+
+    die_unequal(file->size(), file_size);
+    auto* ufs = dynamic_cast<foxxll::ufs_file_base*>(file.get());
+    if (ufs && ufs->discard_supported()) {
+        for (int i = 0; i < size; ++i)
+            die_unequal(buffer[i], 0);
+    }
+    else {
+        die_unless(buffer[0] == buffer[size - 1]);
+    }
+    LOG1 << "discarded range reads " << static_cast<int>(buffer[0]);
+}
+
+// copies within a file, to and from a memory_file, and of a block
+void test_copy(foxxll::file_ptr file, char* buffer, int size)
+{
+    memset(buffer, 7, size);
+    file->awrite(buffer, 2 * size, size)->wait();
+    file->acopy(2 * size, file.get(), 4 * size, size)->wait();
+    memset(buffer, 0, size);
+    file->aread(buffer, 4 * size, size)->wait();
+    die_unequal(buffer[0], 7);
+    die_unequal(buffer[size - 1], 7);
+
+    foxxll::file_ptr file4 = tlx::make_counting<foxxll::memory_file>(4);
+    file->acopy(4 * size, file4.get(), size, size)->wait();
+    die_unequal(file4->size(), 2u * size);
+    file4->acopy(size, file.get(), 5 * size, size)->wait();
+
+    // copies into the file are served by the queue of file4, but throttled
+    // by the rate limits of the file's queue
+    {
+        die_unless(file4->get_queue_id() != file->get_queue_id());
+        foxxll::disk_queues::get_instance()->set_rate_limit(
+            file->get_queue_id(), 0, 100);
+
+        foxxll::stats_data stats_begin(*foxxll::stats::get_instance());
+        foxxll::request_ptr req[16];
+        for (unsigned i = 0; i < 16; i++)
+            req[i] = file4->acopy(size, file.get(), 5 * size, size);
+        wait_all(req, 16);
+        foxxll::stats_data stats_diff =
+            foxxll::stats_data(*foxxll::stats::get_instance()) - stats_begin;
+        die_unless(stats_diff.get_throttle_count() > 0);
+
+        foxxll::disk_queues::get_instance()->set_rate_limit(
+            file->get_queue_id(), 0, 0);
+    }
+
+    foxxll::BID<0> src(file.get(), 5 * size, size);
+    foxxll::BID<0> dst(file.get(), 6 * size, size);
+    foxxll::copy_block(src, dst)->wait();
+    memset(buffer, 0, size);
+    dst.read(buffer, size)->wait();
+    die_unequal(buffer[size - 1], 7);
+
+    // the copy fallback moves ranges larger than its bounce buffer in
+    // chunks
+    const size_t big = 5 * 512 * 1024 + 3;
+    std::vector<char> data(big);
+    for (size_t i = 0; i < big; ++i)
+        data[i] = static_cast<char>(i % 251);
+    foxxll::file_ptr file7 = tlx::make_counting<foxxll::memory_file>(4);
+    file4->set_size(big);
+    file7->set_size(big + 1);
+    file4->awrite(data.data(), 0, big)->wait();
+    file4->acopy(0, file7.get(), 1, big)->wait();
+    std::vector<char> check(big);
+    file7->aread(check.data(), 1, big)->wait();
+    die_unless(check == data);
+
+    file7->close_remove();
+    file4->close_remove();
+}
+
+// unaligned requests on direct I/O files keep the neighboring bytes and
+// do not extend the file beyond their end
+void test_unaligned(foxxll::file_ptr file, char* buffer, int size)
+{
+    // bounce buffers follow the memory alignment of the file
+    for (size_t alignment : { size_t(512), size_t(65536) }) {
+        foxxll::bounce_buffer b(1000, alignment);
+        die_unless(reinterpret_cast<size_t>(b.get()) %
+                   std::max(alignment, foxxll::BlockAlignment) == 0);
+        die_unless(b.size() >= 1000);
+    }
+
+    const size_t n = 1000;
+    memset(buffer, 3, size);
+    file->awrite(buffer, 8 * size, size)->wait();
+
+    for (size_t i = 0; i < n; ++i)
+        buffer[1 + i] = static_cast<char>(i);
+    file->awrite(buffer + 1, 8 * size + 100, n)->wait();
+
+    memset(buffer, 0, size);
+    file->aread(buffer + 3, 8 * size + 99, n + 2)->wait();
+    die_unequal(buffer[3], 3);
+    for (size_t i = 0; i < n; ++i)
+        die_unequal(buffer[4 + i], static_cast<char>(i));
+    die_unequal(buffer[4 + n], 3);
+
+    memset(buffer, 5, size);
+    const foxxll::file::offset_type end = file->size() + 10;
+    file->awrite(buffer + 1, end - n, n)->wait();
+    die_unequal(file->size(), end);
+    memset(buffer, 0, size);
+    file->aread(buffer + 2, end - n, n)->wait();
+    die_unequal(buffer[2], 5);
+    die_unequal(buffer[2 + n - 1], 5);
+}
+
+// reads past the end of the file are truncated at the end with EOF_TRUNCATE
+void test_eof(const std::string& path, char* buffer, int size)
+{
+    const size_t tail = 1000;
+    foxxll::file_ptr file6 = tlx::make_counting<foxxll::syscall_file>(
+            path, file::CREAT | file::RDWR | file::TRUNC | file::EOF_TRUNCATE
+        );
+    memset(buffer, 8, size);
+    file6->awrite(buffer, 0, 4096 + tail)->wait();
+
+    memset(buffer, 1, size);
+    const foxxll::external_size_type read_bytes =
+        file6->get_file_stats()->get_read_bytes();
+    foxxll::request_ptr r = file6->aread(buffer, 4096, 8192);
+    r->wait();
+    die_unequal(r->transferred(), tail);
+    die_unequal(buffer[tail - 1], 8);
+    die_unequal(buffer[tail], 1);
+    die_unequal(file6->get_file_stats()->get_read_bytes(),
+                read_bytes + tail);
+    r = file6->aread(buffer, 8192, 4096);
+    r->wait();
+    die_unequal(r->transferred(), 0u);
+    file6->close_remove();
+}
+
+#if FOXXLL_HAVE_MMAP_FILE
+// unaligned requests on an mmap_file, and reads past its end are filled with
+// zeroes
+void test_mmap_file(foxxll::file_ptr file, char* buffer, int size)
+{
+    const size_t n = 1000;
+    for (size_t i = 0; i < n; ++i)
+        buffer[1 + i] = static_cast<char>(i);
+    file->awrite(buffer + 1, 100, n)->wait();
+    file->aread(buffer + 7, 100, n)->wait();
+    die_unequal(buffer[7], buffer[1]);
+
+    memset(buffer, 1, size);
+    file->aread(buffer, file->size() - 100, 4096)->wait();
+    die_unequal(buffer[4095], 0);
+}
+#endif
+
+// waits for requests of a file with a poll budget spin for the completion
+void test_poll(foxxll::file_ptr file, char* buffer, const std::string& path)
+{
+    foxxll::file_stats* fs = file->get_file_stats();
+    const unsigned polls = fs->get_poll_count();
+    const unsigned hits = fs->get_poll_hits();
+    const double poll_time = fs->get_poll_time();
+    file->set_poll_budget(0.01);
+    for (unsigned i = 0; i < 16; i++)
+        file->aread(buffer, i * 4096, 4096)->wait();
+    // the completion handler keeps the request from completing for longer
+    // than the budget, so its wait() spins for all of it
+    file->aread(buffer, 0, 4096, [](foxxll::request*, bool) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                })->wait();
+    file->set_poll_budget(0.0);
+
+    LOG1 << "polled waits " << fs->get_poll_count() - polls <<
+        ", completed while spinning " << fs->get_poll_hits() - hits <<
+        ", spinning time " << fs->get_poll_time() - poll_time << " s";
+    die_unless(fs->get_poll_count() - polls >= 1);
+    die_unless(fs->get_poll_count() - polls <= 17);
+    die_unless(fs->get_poll_hits() - hits < fs->get_poll_count() - polls);
+    die_unless(fs->get_poll_time() - poll_time >= 0.01);
+
+    // waits for a disk without a poll budget sleep at once, files of the
+    // same device share their file_stats
+    foxxll::file_ptr file12(new foxxll::syscall_file(
+                                path,
+                                foxxll::file::CREAT | foxxll::file::RDWR |
+                                foxxll::file::DIRECT,
+                                foxxll::file::DEFAULT_QUEUE,
+                                foxxll::file::NO_ALLOCATOR, 12));
+    file12->set_size(16 * 4096);
+    for (unsigned i = 0; i < 16; i++)
+        file12->aread(buffer, i * 4096, 4096)->wait();
+    die_unequal(file12->get_file_stats()->get_poll_count(), 0u);
+    die_unequal(file12->get_file_stats()->get_poll_time(), 0.0);
+    file12->close_remove();
+}
+
+// queue ids outside of the dispatch table of disk_queues are served too
+void test_queue_ids(foxxll::file_ptr file, char* buffer, int size,
+                    const std::string& path)
+{
+    const int queue_id = 100000;
+    foxxll::disk_queues* queues = foxxll::disk_queues::get_instance();
+    die_unless(queues->get_queue(file->get_queue_id()) != nullptr);
+    die_unless(queues->get_queue(queue_id) == nullptr);
+
+    foxxll::file_ptr file9 = tlx::make_counting<foxxll::syscall_file>(
+            path, foxxll::file::CREAT | foxxll::file::RDWR, queue_id
+        );
+    memset(buffer, 9, size);
+    file9->awrite(buffer, 0, size)->wait();
+    memset(buffer, 0, size);
+    file9->aread(buffer, 0, size)->wait();
+    die_unequal(buffer[size - 1], 9);
+    die_unless(queues->get_queue(queue_id) != nullptr);
+    die_unequal(queues->num_waiting_requests(queue_id), 0u);
+    file9->close_remove();
+}
+
 int main(int argc, char** argv)
 {
     if (argc < 2)
@@ -79,6 +356,18 @@ int main(int argc, char** argv)
 
     wait_all(req, 16);
 
+    test_alignment(file2);
+    test_throttle(file2, buffer, size);
+    test_discard(file2, buffer, size);
+    test_copy(file2, buffer, size);
+    test_unaligned(file2, buffer, size);
+    test_eof(tempfilename[1] + ".eof", buffer, size);
+#if FOXXLL_HAVE_MMAP_FILE
+    test_mmap_file(file1, buffer, size);
+#endif
+    test_poll(file2, buffer, tempfilename[1] + ".nopoll");
+    test_queue_ids(file2, buffer, size, tempfilename[1] + ".queue");
+
     foxxll::aligned_dealloc<4096>(buffer);
 
     LOG1 << foxxll::stats::get_ref();
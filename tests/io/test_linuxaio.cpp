@@ -0,0 +1,226 @@
+/***************************************************************************
+ *  tests/io/test_linuxaio.cpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <condition_variable>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <foxxll/common/aligned_alloc.hpp>
+#include <foxxll/io.hpp>
+
+using foxxll::file;
+
+static const size_t block = 4096;
+
+// unaligned requests keep the neighboring bytes
+void test_unaligned(const std::string& path, char* buffer)
+{
+    const size_t n = 1000;
+    foxxll::file_ptr file5 = tlx::make_counting<foxxll::linuxaio_file>(
+            path, file::CREAT | file::RDWR | file::DIRECT
+        );
+    file5->set_size(4 * block);
+    memset(buffer, 6, 4 * block);
+    file5->awrite(buffer + 1, 100, n)->wait();
+    memset(buffer, 0, 4 * block);
+    file5->aread(buffer + 5, 100, n)->wait();
+    die_unequal(buffer[5], 6);
+    die_unequal(buffer[5 + n - 1], 6);
+    file5->close_remove();
+}
+
+// reads past the end of the file are filled with zeroes, or truncated at
+// the end with EOF_TRUNCATE
+void test_eof(const std::string& path, char* buffer)
+{
+    const size_t tail = 1000;
+    for (int mode : { 0, int(file::EOF_TRUNCATE) })
+    {
+        foxxll::file_ptr file7 = tlx::make_counting<foxxll::linuxaio_file>(
+                path, file::CREAT | file::RDWR | file::TRUNC | file::DIRECT | mode
+            );
+        memset(buffer, 8, 4 * block);
+        file7->awrite(buffer, 0, block + tail)->wait();
+
+        memset(buffer, 1, 4 * block);
+        foxxll::request_ptr r = file7->aread(buffer, block, 2 * block);
+        r->wait();
+        die_unequal(buffer[tail - 1], 8);
+        if (mode) {
+            die_unequal(r->transferred(), tail);
+        }
+        else {
+            die_unequal(r->transferred(), 2 * block);
+            die_unequal(buffer[tail], 0);
+            die_unequal(buffer[2 * block - 1], 0);
+        }
+        file7->close_remove();
+    }
+}
+
+// a read which transferred less than requested posts the rest, here as the
+// file is extended after the kernel read up to its end
+void test_short_read(const std::string& path, char* buffer)
+{
+    foxxll::file_ptr file11 = tlx::make_counting<foxxll::linuxaio_file>(
+            path, file::CREAT | file::RDWR | file::TRUNC | file::DIRECT
+        );
+    auto* queue = static_cast<foxxll::linuxaio_queue*>(
+        foxxll::disk_queues::get_instance()->get_queue(
+            file11->get_queue_id()));
+    const uint64_t resubmitted = queue->num_resubmitted();
+    memset(buffer, 4, 2 * block);
+    file11->awrite(buffer, 0, 2 * block)->wait();
+
+    // hold up the completion of further requests in a handler
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool entered = false, release = false;
+    foxxll::request_ptr first = file11->aread(
+            buffer + 4 * block, 0, block,
+            [&](foxxll::request*, bool) {
+                std::unique_lock<std::mutex> lock(mutex);
+                entered = true;
+                cv.notify_all();
+                cv.wait(lock, [&]() { return release; });
+            });
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [&]() { return entered; });
+    }
+
+    memset(buffer, 1, 3 * block);
+    foxxll::request_ptr r = file11->aread(buffer, block, 3 * block);
+
+    // the kernel fixed the length of the read before it transferred the
+    // first block, which is followed by the end of the file
+    volatile char* first_block = buffer;
+    while (first_block[block - 1] != 4)
+        std::this_thread::yield();
+
+    std::vector<char> tail(2 * block, 9);
+    std::ofstream out(path, std::ios::binary | std::ios::app);
+    out.write(tail.data(), static_cast<std::streamsize>(tail.size()));
+    out.close();
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        release = true;
+        cv.notify_all();
+    }
+
+    first->wait();
+    r->wait();
+    die_unequal(r->transferred(), 3 * block);
+    die_unequal(buffer[block - 1], 4);
+    die_unequal(buffer[block], 9);
+    die_unequal(buffer[3 * block - 1], 9);
+    die_unequal(queue->num_resubmitted(), resubmitted + 1);
+    file11->close_remove();
+}
+
+// a read across the end of a file, whose size is not a multiple of the
+// request, ends there and fills the rest with zeros
+void test_unaligned_eof(const std::string& path, char* buffer)
+{
+    {
+        std::vector<char> data(2 * block + 100, 5);
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size()));
+    }
+    foxxll::file_ptr file13 = tlx::make_counting<foxxll::linuxaio_file>(
+            path, file::RDWR
+        );
+    auto* queue = static_cast<foxxll::linuxaio_queue*>(
+        foxxll::disk_queues::get_instance()->get_queue(
+            file13->get_queue_id()));
+    const uint64_t resubmitted = queue->num_resubmitted();
+
+    memset(buffer, 1, 3 * block);
+    foxxll::request_ptr r = file13->aread(buffer, 0, 3 * block);
+    r->wait();
+    die_unequal(r->transferred(), 3 * block);
+    die_unequal(buffer[2 * block + 99], 5);
+    die_unequal(buffer[2 * block + 100], 0);
+    die_unequal(buffer[3 * block - 1], 0);
+    die_unequal(queue->num_resubmitted(), resubmitted);
+    file13->close_remove();
+}
+
+// queues reading the completion ring, and waking up on an eventfd
+void test_completion_modes(const std::string& path, char* buffer)
+{
+    for (auto mode : { foxxll::linuxaio_queue::RING_COMPLETION,
+                       foxxll::linuxaio_queue::EVENTFD_COMPLETION })
+    {
+        foxxll::file_ptr file8(new foxxll::linuxaio_file(
+                                   path, file::CREAT | file::RDWR | file::DIRECT,
+                                   10 + mode, file::NO_ALLOCATOR,
+                                   file::DEFAULT_DEVICE_ID, 8, mode));
+        foxxll::request_ptr req[16];
+        for (unsigned i = 0; i < 16; i++) {
+            memset(buffer + i * block, static_cast<int>(i), block);
+            req[i] = file8->awrite(buffer + i * block, i * block, block);
+        }
+        wait_all(req, 16);
+
+        memset(buffer, 0xff, 16 * block);
+        for (unsigned i = 0; i < 16; i++)
+            req[i] = file8->aread(buffer + i * block, i * block, block);
+        wait_all(req, 16);
+        for (unsigned i = 0; i < 16; i++)
+            die_unequal(buffer[i * block + block - 1], static_cast<char>(i));
+
+        auto* queue = dynamic_cast<foxxll::linuxaio_queue*>(
+                foxxll::disk_queues::get_instance()->get_queue(10 + mode));
+        die_unless(queue != nullptr);
+        // the queue falls back to io_getevents() only if the kernel's
+        // completion ring has an unknown layout
+        if (queue->get_completion_mode() ==
+            foxxll::linuxaio_queue::GETEVENTS_COMPLETION)
+            LOG1 << "linuxaio completion mode " << mode <<
+                " not supported by the kernel, skipped";
+        else
+            die_unequal(queue->get_completion_mode(), mode);
+        file8->close_remove();
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        LOG1 << "Usage: " << argv[0] << " tempdir";
+        return -1;
+    }
+
+    const std::string path = std::string(argv[1]) + "/test_linuxaio";
+    auto* buffer = static_cast<char*>(foxxll::aligned_alloc<4096>(16 * block));
+
+    test_unaligned(path + ".aio", buffer);
+    test_eof(path + ".eof", buffer);
+    test_short_read(path + ".short", buffer);
+    test_unaligned_eof(path + ".eof", buffer);
+    test_completion_modes(path + ".ring", buffer);
+
+    foxxll::aligned_dealloc<4096>(buffer);
+
+    return 0;
+}
+
+/**************************************************************************/
@@ -0,0 +1,158 @@
+/***************************************************************************
+ *  tests/io/test_qos.cpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <foxxll/common/aligned_alloc.hpp>
+#include <foxxll/io.hpp>
+
+//! \example io/test_qos.cpp
+//! This tests the order in which a disk queue serves requests of different
+//! priority classes, and that expired prefetches are dropped.
+
+using foxxll::request;
+
+//! records the completion order of requests, the first request blocks the
+//! (single) worker thread until the gate is opened
+struct completion_log
+{
+    std::mutex gate;
+    std::atomic<bool> blocked { false };
+
+    std::mutex mutex;
+    std::vector<int> order;
+};
+
+struct log_completion
+{
+    completion_log* log;
+    int id;
+
+    void operator () (request*, bool success)
+    {
+        die_unless(success);
+        if (id < 0) {
+            log->blocked = true;
+            std::unique_lock<std::mutex> lock(log->gate);
+            return;
+        }
+        std::unique_lock<std::mutex> lock(log->mutex);
+        log->order.push_back(id);
+    }
+};
+
+int main()
+{
+    const size_t size = 4096;
+    const int num = 8;
+
+    char* buffer = static_cast<char*>(foxxll::aligned_alloc<4096>(size));
+    memset(buffer, 0, size);
+
+    // a fresh queue with one worker thread
+    foxxll::file_ptr file = tlx::make_counting<foxxll::memory_file>(42);
+    file->set_size(size * (2 * num + 1));
+
+    completion_log log;
+    std::unique_lock<std::mutex> gate(log.gate);
+
+    std::vector<foxxll::request_ptr> reqs;
+    reqs.push_back(file->awrite(buffer, 0, size, log_completion { &log, -1 }));
+
+    while (!log.blocked)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    // ids 0..num-1 are prefetches, num..2*num-1 demand reads
+    for (int i = 0; i < num; ++i)
+        reqs.push_back(file->aread(buffer, (i + 1) * size, size,
+                                   log_completion { &log, i },
+                                   request::PREFETCH));
+    for (int i = num; i < 2 * num; ++i)
+        reqs.push_back(file->aread(buffer, (i + 1) * size, size,
+                                   log_completion { &log, i }));
+
+    // the application now needs the last prefetch
+    reqs[num]->set_priority(request::DEMAND);
+    die_unequal(reqs[num]->priority(), request::DEMAND);
+
+    gate.unlock();
+    foxxll::wait_all(reqs.begin(), reqs.end());
+
+    die_unequal(log.order.size(), size_t(2 * num));
+
+    // all demand reads and the promoted prefetch are served before the
+    // remaining prefetches, each class in FIFO order
+    size_t pos = 0;
+    for (int i = num; i < 2 * num; ++i)
+        die_unequal(log.order[pos++], i);
+    die_unequal(log.order[pos++], num - 1);
+    for (int i = 0; i < num - 1; ++i)
+        die_unequal(log.order[pos++], i);
+
+    // expired prefetches are dropped before being issued
+    reqs.clear();
+    gate.lock();
+    log.blocked = false;
+    reqs.push_back(file->awrite(buffer, 0, size, log_completion { &log, -1 }));
+
+    while (!log.blocked)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+    reqs.push_back(file->aread(buffer, size, size, foxxll::completion_handler(),
+                               request::PREFETCH));
+    reqs.back()->set_deadline(foxxll::timestamp());
+    reqs.push_back(file->aread(buffer, 2 * size, size,
+                               foxxll::completion_handler(), request::PREFETCH));
+    reqs.back()->set_deadline(foxxll::timestamp() + 3600);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    gate.unlock();
+    foxxll::wait_all(reqs.begin(), reqs.end());
+
+    die_unless(reqs[1]->dropped());
+    die_if(reqs[2]->dropped());
+    die_unequal(file->get_file_stats()->get_drop_count(), 1u);
+    die_unequal(file->get_file_stats()->get_drop_bytes(), size);
+
+    // priorities are changed while the requests complete, and after their
+    // file was closed
+    for (int i = 0; i < 1000; ++i)
+    {
+        foxxll::file_ptr f = tlx::make_counting<foxxll::memory_file>(42);
+        f->set_size(size);
+        foxxll::request_ptr req = f->aread(
+                buffer, 0, size, foxxll::completion_handler(), request::PREFETCH);
+        request::priority_class c = request::DEMAND;
+        while (!req->poll()) {
+            req->set_priority(c);
+            c = (c == request::DEMAND) ? request::PREFETCH : request::DEMAND;
+        }
+        req->wait();
+        f->close_remove();
+        f = nullptr;
+        die_if(req->set_priority(request::WRITEBACK));
+    }
+
+    foxxll::aligned_dealloc<4096>(buffer);
+    file->close_remove();
+
+    return 0;
+}
+
+/**************************************************************************/
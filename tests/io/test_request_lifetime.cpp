@@ -0,0 +1,65 @@
+/***************************************************************************
+ *  tests/io/test_request_lifetime.cpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#include <tlx/die.hpp>
+
+#include <foxxll/common/aligned_alloc.hpp>
+#include <foxxll/io.hpp>
+
+//! \example io/test_request_lifetime.cpp
+//! This tests that a file stays alive while the completion handler of one of
+//! its requests runs, although its owner dropped it once the request was
+//! reported as done.
+
+using foxxll::file;
+
+int main()
+{
+    const size_t size = 4096;
+    char* buffer = static_cast<char*>(foxxll::aligned_alloc<4096>(size));
+    memset(buffer, 0, size);
+
+    for (int i = 0; i < 16; ++i)
+    {
+        std::atomic<file::offset_type> seen_size { 0 };
+
+        foxxll::file_ptr f = tlx::make_counting<foxxll::memory_file>(42);
+        f->set_size(2 * size);
+
+        foxxll::request_ptr req = f->aread(
+                buffer, 0, size,
+                [&seen_size](foxxll::request* r, bool success) {
+                    die_unless(success);
+                    // the owner drops the file while the handler still runs
+                    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                    seen_size = r->get_file()->size();
+                });
+
+        while (!req->poll())
+            std::this_thread::yield();
+        f = nullptr;
+
+        req->wait();
+        die_unequal(seen_size.load(), 2 * size);
+    }
+
+    foxxll::aligned_dealloc<4096>(buffer);
+
+    return 0;
+}
+
+/**************************************************************************/
@@ -0,0 +1,213 @@
+/***************************************************************************
+ *  tests/io/test_tiered.cpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <foxxll/common/aligned_alloc.hpp>
+#include <foxxll/io.hpp>
+
+//! \example io/test_tiered.cpp
+//! This tests the migration of hot segments of a slow file to a hot tier and
+//! back, and that the contents of the file are unaffected.
+
+using foxxll::hot_tier;
+using foxxll::request;
+
+static const size_t segment_size = 1024 * 1024;
+static const size_t num_segments = 8;
+
+//! write a distinct pattern into each segment
+void fill(foxxll::file_ptr file, char* buffer, unsigned seed)
+{
+    for (size_t s = 0; s < num_segments; ++s)
+    {
+        memset(buffer, static_cast<int>(seed + s), segment_size);
+        file->awrite(buffer, s * segment_size, segment_size)->wait();
+    }
+}
+
+//! check the patterns, reading across segment boundaries
+void check(foxxll::file_ptr file, char* buffer, unsigned seed)
+{
+    const size_t half = segment_size / 2;
+    for (size_t s = 0; s + 1 < num_segments; ++s)
+    {
+        file->aread(buffer, s * segment_size + half, segment_size)->wait();
+        die_unequal(buffer[0], static_cast<char>(seed + s));
+        die_unequal(buffer[half - 1], static_cast<char>(seed + s));
+        die_unequal(buffer[half], static_cast<char>(seed + s + 1));
+        die_unequal(buffer[segment_size - 1], static_cast<char>(seed + s + 1));
+    }
+}
+
+//! read a segment count times
+void touch(foxxll::file_ptr file, char* buffer, size_t seg, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        file->aread(buffer, seg * segment_size, segment_size)->wait();
+}
+
+//! threads writing and checking their own segments during background
+//! migration, serving the I/O directly such that it runs concurrently
+void stress(foxxll::file_ptr file, size_t thread, size_t num_threads)
+{
+    char* buffer = static_cast<char*>(
+        foxxll::aligned_alloc<4096>(segment_size));
+    std::default_random_engine rng(static_cast<unsigned>(thread));
+    std::vector<char> expected(4, 0);
+
+    for (size_t i = 0; i < 400; ++i)
+    {
+        const size_t k = rng() % expected.size();
+        const size_t seg = thread + num_threads * k;
+        if (rng() % 4 == 0) {
+            expected[k] = static_cast<char>(i);
+            memset(buffer, expected[k], segment_size);
+            file->serve(buffer, seg * segment_size, segment_size,
+                        request::WRITE);
+        }
+        else {
+            file->serve(buffer, seg * segment_size, segment_size,
+                        request::READ);
+            die_unequal(buffer[0], expected[k]);
+            die_unequal(buffer[segment_size - 1], expected[k]);
+        }
+    }
+
+    foxxll::aligned_dealloc<4096>(buffer);
+}
+
+int main()
+{
+    char* buffer = static_cast<char*>(
+        foxxll::aligned_alloc<4096>(segment_size));
+
+    foxxll::file_ptr base = tlx::make_counting<foxxll::memory_file>(43);
+    base->set_size(num_segments * segment_size);
+
+    {
+        // two slots, migrations are triggered explicitly
+        tlx::counting_ptr<hot_tier> tier = tlx::make_counting<hot_tier>(
+            tlx::make_counting<foxxll::memory_file>(44),
+            2 * segment_size, segment_size, 0.0);
+        die_unequal(tier->num_slots(), 2u);
+
+        foxxll::file_ptr file =
+            tlx::make_counting<foxxll::tiered_file>(base, tier);
+
+        fill(file, buffer, 1);
+        check(file, buffer, 1);
+
+        // segments 3 and 5 become hot and are promoted
+        touch(file, buffer, 3, 8);
+        touch(file, buffer, 5, 8);
+        die_unequal(tier->migrate(), 2u);
+        die_unequal(tier->used_slots(), 2u);
+        die_unequal(tier->promotions(), 2u);
+
+        uint64_t hits = tier->hits();
+        touch(file, buffer, 3, 4);
+        die_unequal(tier->hits(), hits + 4);
+
+        // writes to cached segments go to the hot tier
+        fill(file, buffer, 11);
+        check(file, buffer, 11);
+
+        // segment 6 becomes much hotter and replaces the colder cached
+        // segment 5, which is written back to the slow file
+        touch(file, buffer, 6, 32);
+        die_unequal(tier->migrate(), 1u);
+        die_unequal(tier->evictions(), 1u);
+        die_unequal(tier->writebacks(), 1u);
+
+        base->aread(buffer, 5 * segment_size, segment_size)->wait();
+        die_unequal(buffer[0], static_cast<char>(11 + 5));
+
+        check(file, buffer, 11);
+    }
+
+    // closing the tiered file writes back the remaining dirty segments
+    check(base, buffer, 11);
+
+    {
+        // discarded and truncated segments are dropped from the hot tier
+        // without being written back
+        tlx::counting_ptr<hot_tier> tier = tlx::make_counting<hot_tier>(
+            tlx::make_counting<foxxll::memory_file>(46),
+            2 * segment_size, segment_size, 0.0);
+        foxxll::file_ptr base2 = tlx::make_counting<foxxll::memory_file>(47);
+        base2->set_size(num_segments * segment_size);
+
+        foxxll::file_ptr file =
+            tlx::make_counting<foxxll::tiered_file>(base2, tier);
+
+        fill(file, buffer, 1);
+        touch(file, buffer, 2, 8);
+        touch(file, buffer, 7, 8);
+        die_unequal(tier->migrate(), 2u);
+        fill(file, buffer, 21);
+
+        file->discard(2 * segment_size, segment_size);
+        die_unequal(tier->used_slots(), 1u);
+        file->aread(buffer, 2 * segment_size, segment_size)->wait();
+        die_if(buffer[0] == static_cast<char>(21 + 2) &&
+               buffer[segment_size - 1] == static_cast<char>(21 + 2));
+
+        file->set_size(6 * segment_size);
+        die_unequal(tier->used_slots(), 0u);
+        die_unequal(tier->writebacks(), 0u);
+        die_unequal(base2->size(), 6 * segment_size);
+
+        base2->aread(buffer, 5 * segment_size, segment_size)->wait();
+        die_unequal(buffer[0], static_cast<char>(21 + 5));
+
+        base2->close_remove();
+    }
+
+    {
+        // concurrent I/O during background migration
+        const size_t num_threads = 4;
+        tlx::counting_ptr<hot_tier> tier = tlx::make_counting<hot_tier>(
+            tlx::make_counting<foxxll::memory_file>(48),
+            2 * segment_size, segment_size, 0.001);
+        foxxll::file_ptr base3 = tlx::make_counting<foxxll::memory_file>(49);
+        base3->set_size(4 * num_threads * segment_size);
+
+        foxxll::file_ptr file =
+            tlx::make_counting<foxxll::tiered_file>(base3, tier);
+        memset(buffer, 0, segment_size);
+        for (size_t s = 0; s < 4 * num_threads; ++s)
+            file->awrite(buffer, s * segment_size, segment_size)->wait();
+
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < num_threads; ++t)
+            threads.emplace_back(stress, file, t, num_threads);
+        for (std::thread& t : threads)
+            t.join();
+
+        LOG1 << "promotions during I/O: " << tier->promotions();
+        base3->close_remove();
+    }
+
+    foxxll::aligned_dealloc<4096>(buffer);
+    base->close_remove();
+
+    return 0;
+}
+
+/**************************************************************************/
@@ -0,0 +1,84 @@
+/***************************************************************************
+ *  tests/io/test_worker_scaling.cpp
+ *
+ *  Part of FOXXLL. See http://foxxll.org
+ *
+ *  Copyright (C) 2026 agent <agent@local>
+ *
+ *  Distributed under the Boost Software License, Version 1.0.
+ *  (See accompanying file LICENSE_1_0.txt or copy at
+ *  http://www.boost.org/LICENSE_1_0.txt)
+ **************************************************************************/
+
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include <tlx/die.hpp>
+#include <tlx/logger.hpp>
+
+#include <foxxll/common/aligned_alloc.hpp>
+#include <foxxll/io.hpp>
+#include <foxxll/io/request_queue_impl_qwqr.hpp>
+
+//! \example io/test_worker_scaling.cpp
+//! This tests that the controller of a disk queue with a variable number of
+//! worker threads adds workers while requests queue up and their service
+//! time stays the same, and removes them when the service time rises.
+
+using foxxll::request;
+
+//! service time of each request in microseconds, spent in its completion
+//! handler, which is part of the request's service
+static std::atomic<int> delay_us { 1000 };
+
+//! submit num requests at once and wait for them
+void run_requests(foxxll::file_ptr file, char* buffer, size_t num)
+{
+    std::vector<foxxll::request_ptr> reqs;
+    for (size_t i = 0; i < num; ++i)
+        reqs.push_back(file->aread(buffer, 0, 4096, [](request*, bool) {
+                                       std::this_thread::sleep_for(
+                                           std::chrono::microseconds(delay_us));
+                                   }));
+    for (foxxll::request_ptr& r : reqs)
+        r->wait();
+}
+
+int main()
+{
+    // the maximum must not be less than the minimum
+    die_unless_throws(foxxll::request_queue_impl_qwqr(4, 2),
+                      std::invalid_argument);
+
+    char* buffer = static_cast<char*>(foxxll::aligned_alloc<4096>(4096));
+
+    foxxll::file_ptr file = tlx::make_counting<foxxll::memory_file>(50);
+    file->set_size(4096);
+    foxxll::disk_queues::get_instance()->make_queue(file.get(), 1, 4);
+
+    auto* queue = dynamic_cast<foxxll::request_queue_impl_qwqr*>(
+        foxxll::disk_queues::get_instance()->get_queue(file->get_queue_id()));
+    die_unless(queue != nullptr);
+    die_unequal(queue->num_active_workers(), 1u);
+
+    // a backlog at constant service time: additive increase up to the maximum
+    run_requests(file, buffer, 200);
+    LOG1 << "workers with backlog: " << queue->num_active_workers();
+    die_unequal(queue->num_active_workers(), 4u);
+
+    // the service time rises tenfold: multiplicative decrease to the minimum
+    delay_us = 10000;
+    run_requests(file, buffer, 64);
+    LOG1 << "workers after congestion: " << queue->num_active_workers();
+    die_unequal(queue->num_active_workers(), 1u);
+
+    file->close_remove();
+    foxxll::aligned_dealloc<4096>(buffer);
+
+    return 0;
+}
+
+/**************************************************************************/
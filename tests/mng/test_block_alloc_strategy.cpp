@@ -13,6 +13,7 @@
  **************************************************************************/
 
 #include <sstream>
+#include <string>
 
 #include <tlx/logger.hpp>
 
@@ -51,10 +52,73 @@ void test_strategy()
     LOG1 << ss.str();
 }
 
+//! every cycle of the load-balanced strategy must contain all disks which are
+//! not full in proportion to their weight, and nothing else
+void test_load_balanced()
+{
+    foxxll::load_balanced s(1, 3);
+    const std::vector<size_t>& cycle = s.cycle();
+
+    die_unless(cycle.size() >= 2);
+    die_unless(cycle.size() <= 2 * foxxll::load_balanced::weight_resolution);
+
+    std::vector<size_t> count(2);
+    for (size_t i = 0; i < cycle.size(); ++i)
+    {
+        die_unless(s(i) >= 1 && s(i) < 3);
+        die_unequal(s(i), s(i + cycle.size()));
+        ++count[s(i) - 1];
+    }
+    // disk 2 has a quarter of the free space of disk 1
+    die_unequal(count[0], foxxll::load_balanced::weight_resolution);
+    die_unequal(count[1], foxxll::load_balanced::weight_resolution / 4);
+}
+
+//! strategies selected at run time place blocks like their static versions
+void test_dynamic()
+{
+    foxxll::config::get_instance()->set_alloc_strategy("striping");
+
+    foxxll::dynamic_strategy s(1, 3);
+    foxxll::striping ref(1, 3);
+    die_unequal(std::string(s.name()), std::string(ref.name()));
+
+    foxxll::interleaved_dynamic itl(5, s);
+    foxxll::interleaved_striping itl_ref(5, ref);
+    for (size_t i = 0; i < 16; ++i)
+    {
+        die_unequal(s(i), ref(i));
+        die_unequal(itl(i), itl_ref(i));
+    }
+
+    foxxll::dynamic_strategy d("single_disk", 2, 3);
+    for (size_t i = 0; i < 16; ++i)
+        die_unequal(d(i), 2u);
+
+    for (const std::string& name : foxxll::dynamic_strategy::names())
+    {
+        foxxll::dynamic_strategy n(name, 0, 4);
+        for (size_t i = 0; i < 16; ++i)
+            die_unless(n(i) < 4);
+    }
+
+    die_unless_throws(foxxll::dynamic_strategy("no_such_strategy"),
+                      std::runtime_error);
+    // strategies without disks are rejected instead of dividing by zero
+    die_unless_throws(foxxll::dynamic_strategy("random_cyclic", 2, 2),
+                      std::runtime_error);
+}
+
 int main()
 {
     foxxll::config* cfg = foxxll::config::get_instance();
 
+    // disks of equal speed but different capacity
+    cfg->add_disk(foxxll::disk_config("disk0", 16 * 1024 * 1024, "memory autogrow=no"));
+    cfg->add_disk(foxxll::disk_config("disk1", 16 * 1024 * 1024, "memory autogrow=no"));
+    cfg->add_disk(foxxll::disk_config("disk2", 4 * 1024 * 1024, "memory autogrow=no"));
+    cfg->add_disk(foxxll::disk_config("disk3", 16 * 1024 * 1024, "memory autogrow=no"));
+
     // instantiate the allocation strategies
     LOG1 << "Number of disks: " << cfg->disks_number();
     for (unsigned i = 0; i < cfg->disks_number(); ++i)
@@ -63,6 +127,8 @@ int main()
     test_strategy<foxxll::fully_random>();
     test_strategy<foxxll::simple_random>();
     test_strategy<foxxll::random_cyclic>();
+    test_strategy<foxxll::load_balanced>();
+    test_load_balanced();
     LOG1 << "Regular disks: [" << cfg->regular_disk_range().first << "," << cfg->regular_disk_range().second << ")";
     if (cfg->regular_disk_range().first != cfg->regular_disk_range().second)
         test_strategy<foxxll::random_cyclic_disk>();
@@ -70,6 +136,8 @@ int main()
     if (cfg->flash_range().first != cfg->flash_range().second)
         test_strategy<foxxll::random_cyclic_flash>();
     test_strategy<foxxll::single_disk>();
+    test_strategy<foxxll::dynamic_strategy>();
+    test_dynamic();
 }
 
 /**************************************************************************/
@@ -12,8 +12,10 @@
 
 #include <iostream>
 
+#include <tlx/die.hpp>
 #include <tlx/logger.hpp>
 
+#include <foxxll/io/iostats.hpp>
 #include <foxxll/mng.hpp>
 
 #define BLOCK_SIZE (1024 * 1024 * 32)
@@ -56,10 +58,43 @@ int main()
     LOG1 << "get 1 x " << totalblocks / 2;
     bm->new_blocks(foxxll::striping(), b2.begin(), b2.end());
 
+    // runs allocated in extents are contiguous in spite of the fragmentation
+    LOG1 << "get " << totalblocks / 4 << " in extents of 2 and 1 x "
+         << totalblocks / 5 << " in one extent";
+    foxxll::stats_data stats_begin(*foxxll::stats::get_instance());
+
+    foxxll::BIDArray<BLOCK_SIZE> e2(totalblocks / 4);
+    foxxll::BIDArray<BLOCK_SIZE> e1(totalblocks / 5);
+    bm->new_extents(foxxll::striping(), e2.begin(), e2.end(), 2);
+    bm->new_extents(foxxll::striping(), e1.begin(), e1.end());
+
+    for (size_t i = 0; i + 1 < e2.size(); i += 2) {
+        die_unequal(e2[i + 1].storage, e2[i].storage);
+        die_unequal(e2[i + 1].offset, e2[i].offset + BLOCK_SIZE);
+    }
+    for (size_t i = 0; i + 1 < e1.size(); ++i) {
+        die_unequal(e1[i + 1].storage, e1[i].storage);
+        die_unequal(e1[i + 1].offset, e1[i].offset + BLOCK_SIZE);
+    }
+
+    foxxll::stats_data stats_extents =
+        foxxll::stats_data(*foxxll::stats::get_instance()) - stats_begin;
+    die_unequal(stats_extents.get_alloc_extents(), (e2.size() + 1) / 2 + 1);
+    die_unequal(stats_extents.get_alloc_splits(), 0u);
+    LOG1 << stats_extents;
+
+    bm->delete_blocks(e2.begin(), e2.end());
+    bm->delete_blocks(e1.begin(), e1.end());
+
     bm->delete_blocks(b5b.begin(), b5b.end());
     bm->delete_blocks(b5d.begin(), b5d.end());
 
     bm->delete_blocks(b2.begin(), b2.end());
+
+    // deleting a block twice throws at once, whether its discard is still
+    // pending or it is already free
+    die_unless_throws(bm->delete_block(b2[0]), foxxll::bad_ext_alloc);
+    die_unless_throws(bm->delete_block(b5b[0]), foxxll::bad_ext_alloc);
 }
 
 /**************************************************************************/
@@ -13,7 +13,10 @@
 //! \example mng/test_buf_streams.cpp
 //! This is an example of use of \c foxxll::buf_istream and \c foxxll::buf_ostream
 
+#include <algorithm>
 #include <iostream>
+#include <utility>
+#include <vector>
 
 #include <foxxll/common/die_with_message.hpp>
 #include <foxxll/mng.hpp>
@@ -63,6 +66,32 @@ int main()
             die_unless(prevalue == value);
         }
     }
+    {
+        // read in spans and in bulk, crossing block boundaries
+        buf_istream_type in(bids.begin(), bids.end(), 2);
+        std::vector<unsigned> buffer(block_type::size / 3 + 7);
+        unsigned i = 0;
+        while (i < nelements / 2)
+        {
+            std::pair<unsigned*, size_t> span = in.next_span();
+            size_t n = std::min<size_t>(span.second, 1000);
+            for (size_t j = 0; j < n; ++j, ++i)
+                die_unless(span.first[j] == i);
+            in.consume(n);
+        }
+        while (i < nelements)
+        {
+            size_t n = std::min<size_t>(buffer.size(), nelements - i);
+            in.read_bulk(buffer.data(), n);
+            for (size_t j = 0; j < n; ++j, ++i)
+            {
+                die_with_message_unless(
+                    buffer[j] == i,
+                    "Error at position " << std::hex << i << " (" << buffer[j] << ") block " << (i / block_type::size)
+                );
+            }
+        }
+    }
     {
         buf_istream_reverse_type in(bids.begin(), bids.end(), 2);
         for (unsigned i = 0; i < nelements; i++)
@@ -78,6 +107,40 @@ int main()
             die_unless(prevalue == value);
         }
     }
+    {
+        // overwrite with different values, in spans and in bulk
+        buf_ostream_type out(bids.begin(), 2);
+        std::vector<unsigned> buffer(block_type::size / 3 + 7);
+        unsigned i = 0;
+        while (i < nelements / 2)
+        {
+            std::pair<unsigned*, size_t> span = out.reserve_span();
+            size_t n = std::min<size_t>(span.second, 1000);
+            for (size_t j = 0; j < n; ++j)
+                span.first[j] = nelements + i++;
+            out.commit(n);
+        }
+        while (i < nelements)
+        {
+            size_t n = std::min<size_t>(buffer.size(), nelements - i);
+            for (size_t j = 0; j < n; ++j)
+                buffer[j] = nelements + i++;
+            out.write_bulk(buffer.data(), n);
+        }
+    }
+    {
+        buf_istream_type in(bids.begin(), bids.end(), 2);
+        for (unsigned i = 0; i < nelements; i++)
+        {
+            unsigned value;
+            in >> value;
+
+            die_with_message_unless(
+                value == nelements + i,
+                "Error at position " << std::hex << i << " (" << value << ") block " << (i / block_type::size)
+            );
+        }
+    }
     bm->delete_blocks(bids.begin(), bids.end());
 
     return 0;
@@ -10,8 +10,13 @@
  *  http://www.boost.org/LICENSE_1_0.txt)
  **************************************************************************/
 
+#include <chrono>
+#include <thread>
+#include <vector>
+
 #include <tlx/die.hpp>
 
+#include <foxxll/io.hpp>
 #include <foxxll/mng.hpp>
 
 void test1()
@@ -36,13 +41,121 @@ void test1()
     die_unequal(cfg.queue, 5);
     die_unequal(cfg.direct, foxxll::disk_config::DIRECT_ON);
 
+    cfg.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, syscall threads=4");
+
+    die_unequal(cfg.threads, 4u);
+    die_unequal(cfg.fileio_string(), "syscall threads=4");
+
+    cfg.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, syscall threads=2 max_threads=16");
+
+    die_unequal(cfg.threads, 2u);
+    die_unequal(cfg.max_threads, 16u);
+    die_unequal(cfg.fileio_string(), "syscall threads=2 max_threads=16");
+
+    foxxll::disk_config cfg_aio(
+        "disk=/var/tmp/foxxll.tmp, 100 GiB, linuxaio aio_completion=ring");
+
+    die_unequal(cfg_aio.aio_completion, foxxll::disk_config::AIO_RING);
+    die_unequal(cfg_aio.fileio_string(), "linuxaio aio_completion=ring");
+
+    foxxll::disk_config cfg_poll(
+        "disk=/var/tmp/foxxll.tmp, 100 GiB, syscall direct=on poll=20");
+
+    die_unequal(cfg_poll.poll, 20u);
+    die_unequal(cfg_poll.fileio_string(), "syscall direct=on poll=20");
+    cfg_poll.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, syscall poll");
+    die_unequal(cfg_poll.poll, foxxll::disk_config::default_poll);
+    die_unless_throws(
+        cfg_poll.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, syscall poll="),
+        std::runtime_error);
+    die_unless_throws(
+        cfg_poll.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, syscall poll=x"),
+        std::runtime_error);
+    die_unless_throws(
+        cfg_poll.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, syscall poll=-5"),
+        std::runtime_error);
+
+    foxxll::disk_config cfg_limits(
+        "disk=/var/tmp/foxxll.tmp, 100 GiB, syscall max_bandwidth=200MiB max_iops=500");
+
+    die_unequal(cfg_limits.max_bandwidth, 200 * 1024 * uint64_t(1024));
+    die_unequal(cfg_limits.max_iops, 500u);
+    die_unequal(cfg_limits.fileio_string(),
+                "syscall max_bandwidth=209715200 max_iops=500");
+
+    foxxll::disk_config cfg_tier("flash=/var/tmp/foxxll-ssd.tmp, 1 GiB, syscall tier");
+
+    die_unless(cfg_tier.flash);
+    die_unless(cfg_tier.tier);
+    die_unequal(cfg_tier.fileio_string(), "syscall flash tier");
+
+    foxxll::disk_config cfg_compact("disk=/var/tmp/foxxll.tmp, 0, syscall compact");
+
+    die_unless(cfg_compact.compact);
+    die_unequal(cfg_compact.fileio_string(), "syscall delete_on_exit compact");
+
+    foxxll::disk_config cfg_prealloc(
+        "disk=/var/tmp/foxxll.tmp, 100 GiB, syscall prealloc grow_step=1GiB");
+
+    die_unless(cfg_prealloc.prealloc);
+    die_unequal(cfg_prealloc.grow_step, 1024 * 1024 * uint64_t(1024));
+    die_unequal(cfg_prealloc.fileio_string(),
+                "syscall prealloc grow_step=1073741824");
+
+    foxxll::disk_config cfg_discard(
+        "disk=/var/tmp/foxxll.tmp, 100 GiB, syscall discard");
+
+    die_unless(cfg_discard.discard);
+    die_unless(!cfg_prealloc.discard);
+    die_unequal(cfg_discard.fileio_string(), "syscall discard");
+
     // bad configurations
 
+    die_unless_throws(
+        cfg.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, syscall threads=0"),
+        std::runtime_error
+    );
+
+    die_unless_throws(
+        cfg.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, linuxaio threads=4"),
+        std::runtime_error
+    );
+
+    die_unless_throws(
+        cfg.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, syscall aio_completion=ring"),
+        std::runtime_error
+    );
+
+    die_unless_throws(
+        cfg.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, linuxaio aio_completion=poll"),
+        std::runtime_error
+    );
+
+    die_unless_throws(
+        cfg.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, syscall max_threads=0"),
+        std::runtime_error
+    );
+
+    die_unless_throws(
+        cfg.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, syscall max_bandwidth=fast"),
+        std::runtime_error
+    );
+
+    die_unless_throws(
+        cfg.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, linuxaio max_threads=4"),
+        std::runtime_error
+    );
+
     die_unless_throws(
         cfg.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, wincall_fileperblock unlink direct=on"),
         std::runtime_error
     );
 
+    die_unless_throws(
+        cfg.parse_line("disk=/var/tmp/foxxll.tmp, 100 GiB, memory prealloc"),
+        std::runtime_error
+    );
+
     die_unless_throws(
         cfg.parse_line("disk=/var/tmp/foxxll.tmp,0x,syscall"),
         std::runtime_error
@@ -61,33 +174,46 @@ void test2()
                                   "syscall");
         disk1.unlink_on_open = true;
         disk1.direct = foxxll::disk_config::DIRECT_OFF;
+        disk1.prealloc = true;
 
         die_unequal(disk1.path, "/tmp/foxxll-1.tmp");
         die_unequal(disk1.size, 100 * 1024 * uint64_t(1024));
         die_unequal(disk1.autogrow, 1);
         die_unequal(
             disk1.fileio_string(),
-            "syscall direct=off unlink_on_open"
+            "syscall direct=off prealloc unlink_on_open"
         );
 
         config->add_disk(disk1);
 
         foxxll::disk_config disk2("/tmp/foxxll-2.tmp", 200 * 1024 * 1024,
-                                  "syscall autogrow=no direct=off");
+                                  "syscall autogrow=no direct=off threads=4");
         disk2.unlink_on_open = true;
 
         die_unequal(disk2.path, "/tmp/foxxll-2.tmp");
         die_unequal(disk2.size, 200 * 1024 * uint64_t(1024));
         die_unequal(
             disk2.fileio_string(),
-            "syscall autogrow=no direct=off unlink_on_open"
+            "syscall autogrow=no direct=off unlink_on_open threads=4"
         );
         die_unequal(disk2.direct, 0);
 
         config->add_disk(disk2);
+
+        // a flash device used as hot tier is not a disk
+        foxxll::disk_config tier("/tmp/foxxll-tier.tmp", 64 * 1024 * 1024,
+                                 "syscall direct=off unlink_on_open tier");
+
+        die_unless_throws(config->add_disk(tier), std::runtime_error);
+
+        tier.flash = true;
+        config->add_disk(tier);
+
+        die_unless_throws(config->add_disk(tier), std::runtime_error);
     }
 
     die_unequal(config->disks_number(), 2u);
+    die_unless(config->has_tier());
     die_unequal(config->total_size(), 300u * 1024 * 1024);
 
     // construct block_manager with user-supplied config
@@ -97,13 +223,94 @@ void test2()
     die_unequal(bm->total_bytes(), 300u * 1024 * 1024);
     die_unequal(bm->free_bytes(), 300u * 1024 * 1024);
 
+    die_unless(bm->get_hot_tier() != nullptr);
+    die_unequal(bm->get_hot_tier()->num_slots(),
+                64 / (foxxll::hot_tier::default_segment_size / 1024 / 1024));
+
 #endif
 }
 
+void test3()
+{
+    // test background growth of an autogrow disk
+
+    const uint64_t step = 16 * 1024 * 1024;
+    using bid_type = foxxll::BID<1024* 1024>;
+
+    foxxll::disk_config cfg("", 0, "memory grow_step=16MiB");
+    foxxll::file_ptr file = tlx::make_counting<foxxll::memory_file>();
+
+    foxxll::disk_block_allocator alloc(file.get(), cfg);
+
+    // wait for the background thread to grow the file
+    auto wait_for_free_region = [&](uint64_t size) {
+                                    for (size_t i = 0; i < 1000; ++i) {
+                                        if (alloc.largest_free_region() == size)
+                                            return;
+                                        std::this_thread::sleep_for(
+                                            std::chrono::milliseconds(10));
+                                    }
+                                    die("background growth timed out");
+                                };
+    wait_for_free_region(step);
+
+    // leave less than one step free
+    std::vector<bid_type> bids(10);
+    alloc.new_blocks(bids.begin(), bids.end());
+    wait_for_free_region(2 * step - 10 * 1024 * 1024);
+    die_unequal(file->size(), 2 * step);
+
+    // freeing the blocks shrinks the file, but keeps one step as headroom
+    for (const bid_type& bid : bids)
+        alloc.delete_block(bid);
+    alloc.flush();
+    die_unequal(alloc.total_bytes(), step);
+    die_unequal(alloc.free_bytes(), step);
+    die_unequal(file->size(), step);
+}
+
+void test4()
+{
+    // deleted blocks are free at once, unless they are discarded first
+
+    using bid_type = foxxll::BID<1024* 1024>;
+
+    for (bool discard : { false, true })
+    {
+        foxxll::disk_config cfg("", 16 * 1024 * 1024, "memory");
+        cfg.autogrow = false;
+        cfg.discard = discard;
+        foxxll::file_ptr file = tlx::make_counting<foxxll::memory_file>();
+
+        foxxll::disk_block_allocator alloc(file.get(), cfg);
+
+        std::vector<bid_type> bids(16);
+        alloc.new_blocks(bids.begin(), bids.end());
+        die_unequal(alloc.free_bytes(), 0u);
+
+        for (const bid_type& bid : bids)
+            alloc.delete_block(bid);
+
+        // blocks waiting to be discarded count as free space
+        die_unequal(alloc.free_bytes(), 16u * 1024 * 1024);
+        if (!discard)
+            die_unequal(alloc.largest_free_region(), 16u * 1024 * 1024);
+
+        alloc.flush();
+        die_unequal(alloc.largest_free_region(), 16u * 1024 * 1024);
+
+        // the space of the deleted blocks is reused
+        alloc.new_blocks(bids.begin(), bids.end());
+        die_unequal(alloc.used_bytes(), 16u * 1024 * 1024);
+    }
+}
+
 int main()
 {
     test1();
     test2();
+    test3();
+    test4();
 
     return 0;
 }
@@ -13,6 +13,7 @@
 //! \example mng/test_read_write_pool.cpp
 
 #include <iostream>
+#include <vector>
 
 #include <tlx/die.hpp>
 #include <tlx/logger.hpp>
@@ -143,6 +144,53 @@ int main()
         bm->delete_block(bid);
     }
 
+    {
+        LOG1 << "Batch write and hint test";
+        const size_t num_blocks = 16;
+        foxxll::read_write_pool<block_type> pool(num_blocks, 2 * num_blocks);
+        std::vector<block_type*> blocks(num_blocks);
+        std::vector<block_type::bid_type> bids(num_blocks);
+
+        bm->new_blocks(foxxll::striping(), bids.begin(), bids.end());
+
+        for (size_t i = 0; i < num_blocks; ++i) {
+            blocks[i] = pool.steal();
+            (*blocks[i])[0].integer = static_cast<int>(i);
+        }
+        pool.write(blocks.begin(), blocks.end(), bids.begin());
+
+        for (size_t i = 0; i < num_blocks; ++i)
+            die_unless(blocks[i] == nullptr);
+
+        // hint the even blocks, half of them a second time
+        std::vector<block_type::bid_type> hints;
+        for (size_t i = 0; i < num_blocks; i += 2)
+            hints.push_back(bids[i]);
+        die_unequal(pool.hint(hints.begin(), hints.end()), num_blocks / 2);
+        die_unequal(pool.hint(hints.begin(), hints.begin() + num_blocks / 4),
+                    num_blocks / 4);
+
+        // overwrite all blocks, the hinted ones must be re-hinted
+        for (size_t i = 0; i < num_blocks; ++i) {
+            blocks[i] = pool.steal();
+            (*blocks[i])[0].integer = static_cast<int>(100 + i);
+        }
+        pool.write(blocks.begin(), blocks.end(), bids.begin());
+
+        for (size_t i = 0; i < num_blocks; ++i)
+        {
+            block_type* blk = pool.steal();
+            pool.read(blk, bids[i])->wait();
+            die_with_message_unless(
+                (*blk)[0].integer == static_cast<int>(100 + i),
+                "BATCH WRITE-AFTER-HINT COHERENCE FAILURE"
+            );
+            pool.add(blk);
+        }
+
+        bm->delete_blocks(bids.begin(), bids.end());
+    }
+
     return 0;
 }
 
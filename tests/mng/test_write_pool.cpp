@@ -14,6 +14,10 @@
 //! \example mng/test_write_pool.cpp
 
 #include <iostream>
+#include <utility>
+#include <vector>
+
+#include <tlx/die.hpp>
 
 #include <foxxll/mng.hpp>
 #include <foxxll/mng/write_pool.hpp>
@@ -41,6 +45,47 @@ int main()
     block_type::bid_type bid;
     foxxll::block_manager::get_instance()->new_block(foxxll::single_disk(), bid);
     pool.write(blk, bid)->wait();
+
+    {
+        // overwrite blocks while previous writes may be pending (WAW) and
+        // steal pending requests by bid
+        const size_t num_bids = 64;
+        std::vector<block_type::bid_type> bids(num_bids);
+        foxxll::block_manager::get_instance()->new_blocks(
+            foxxll::striping(), bids.begin(), bids.end()
+        );
+
+        pool.resize(2 * num_bids);
+        for (size_t round = 0; round < 2; ++round)
+        {
+            for (size_t i = 0; i < num_bids; ++i)
+            {
+                blk = pool.steal();
+                (*blk)[0].integer = static_cast<int>(round * num_bids + i);
+                pool.write(blk, bids[i]);
+            }
+        }
+        die_unless(pool.size() == 2 * num_bids);
+
+        for (size_t i = 0; i < num_bids; i += 2)
+        {
+            die_unless(pool.has_request(bids[i]));
+            std::pair<block_type*, foxxll::request_ptr> r = pool.steal_request(bids[i]);
+            die_unless(r.first != nullptr);
+            r.second->wait();
+            die_unless((*r.first)[0].integer == static_cast<int>(num_bids + i));
+            die_unless(!pool.has_request(bids[i]));
+            pool.add(r.first);
+        }
+        die_unless(pool.size() == 2 * num_bids);
+
+        // waits for all pending writes
+        pool.resize(0);
+        die_unless(pool.size() == 0);
+
+        foxxll::block_manager::get_instance()->delete_blocks(bids.begin(), bids.end());
+    }
+
     delete blk;
 }
 
@@ -30,6 +30,7 @@
 #include <iomanip>
 #include <limits>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
@@ -57,7 +58,7 @@ using foxxll::external_size_type;
 
 template <typename AllocStrategy>
 int benchmark_disks_alloc(
-    external_size_type length, external_size_type start_offset,
+    const AllocStrategy& alloc, external_size_type length, external_size_type start_offset,
     size_t batch_size, const size_t raw_block_size,
     const std::string& optrw)
 {
@@ -98,7 +99,7 @@ int benchmark_disks_alloc(
          << foxxll::add_IEC_binary_multiplier(batch_size, "B") << " ("
          << num_blocks_per_batch << " blocks of "
          << foxxll::add_IEC_binary_multiplier(raw_block_size, "B") << ")"
-         << " using " << AllocStrategy().name();
+         << " using " << alloc.name();
 
     // allocate data blocks
     for (size_t j = 0; j < num_blocks_per_batch; ++j) {
@@ -113,7 +114,6 @@ int benchmark_disks_alloc(
     }
 
     try {
-        AllocStrategy alloc;
         size_t current_batch_size;
 
         for (external_size_type offset = 0; offset < endpos; offset += current_batch_size)
@@ -227,6 +227,9 @@ int benchmark_disks_alloc(
          << std::setw(5) << std::setprecision(1) << (double(totalsizewrite) / MiB / totaltimewrite) << " MiB/s write, "
          << std::setw(5) << std::setprecision(1) << (double(totalsizeread) / MiB / totaltimeread) << " MiB/s read";
 
+    // free the blocks for the next benchmark
+    foxxll::block_manager::get_instance()->delete_blocks(bids.begin(), bids.end());
+
     delete[] reqs;
 
     for (size_t j = 0; j < num_blocks_per_batch; ++j)
@@ -235,6 +238,34 @@ int benchmark_disks_alloc(
     return 0;
 }
 
+static const int unknown_strategy = -2;
+
+//! Runs the benchmark with the allocation strategy called name, "dynamic"
+//! selects the strategy configured for foxxll::dynamic_strategy.
+template <typename Benchmark>
+int benchmark_disks_named(const std::string& name, const Benchmark& run)
+{
+    if (name == "striping")
+        return run(foxxll::striping());
+    if (name == "fully_random")
+        return run(foxxll::fully_random());
+    if (name == "simple_random")
+        return run(foxxll::simple_random());
+    if (name == "random_cyclic")
+        return run(foxxll::random_cyclic());
+    if (name == "random_cyclic_disk")
+        return run(foxxll::random_cyclic_disk());
+    if (name == "random_cyclic_flash")
+        return run(foxxll::random_cyclic_flash());
+    if (name == "load_balanced")
+        return run(foxxll::load_balanced());
+    if (name == "single_disk")
+        return run(foxxll::single_disk());
+    if (name == "dynamic")
+        return run(foxxll::dynamic_strategy());
+    return unknown_strategy;
+}
+
 int benchmark_disks(int argc, char* argv[])
 {
     // parse command line
@@ -256,7 +287,10 @@ int benchmark_disks(int argc, char* argv[])
     );
     cp.add_opt_param_string(
         "alloc", allocstr,
-        "Block allocation strategy: random_cyclic, simple_random, fully_random, striping. (default: random_cyclic)"
+        "Block allocation strategy: striping, fully_random, simple_random, "
+        "random_cyclic, random_cyclic_disk, random_cyclic_flash, "
+        "load_balanced, single_disk, dynamic (selected by FOXXLL_ALLOC_STRATEGY "
+        "or the config file), or all. (default: random_cyclic)"
     );
 
     cp.add_unsigned(
@@ -285,33 +319,49 @@ int benchmark_disks(int argc, char* argv[])
     if (!cp.process(argc, argv))
         return -1;
 
-    if (allocstr.size())
+    auto run = [&](const auto& alloc) {
+                   return benchmark_disks_alloc(
+                       alloc, length, offset, batch_size, block_size, optrw);
+               };
+
+    if (allocstr == "all")
     {
-        if (allocstr == "random_cyclic")
-            return benchmark_disks_alloc<foxxll::random_cyclic>(
-                length, offset, batch_size, block_size, optrw
-            );
-        if (allocstr == "simple_random")
-            return benchmark_disks_alloc<foxxll::simple_random>(
-                length, offset, batch_size, block_size, optrw
-            );
-        if (allocstr == "fully_random")
-            return benchmark_disks_alloc<foxxll::fully_random>(
-                length, offset, batch_size, block_size, optrw
-            );
-        if (allocstr == "striping")
-            return benchmark_disks_alloc<foxxll::striping>(
-                length, offset, batch_size, block_size, optrw
-            );
+        // compare all strategies on the same disks, the run time selection
+        // shows the overhead of the virtual call per block
+        int result = 0;
+        for (const std::string& name : foxxll::dynamic_strategy::names())
+        {
+            // skip strategies without disks, e.g. random_cyclic_flash
+            // without flash devices
+            try {
+                foxxll::dynamic_strategy check(name);
+            }
+            catch (const std::runtime_error& e) {
+                LOG1 << "Skipping allocation strategy " << name << ": " <<
+                    e.what();
+                continue;
+            }
+            if (benchmark_disks_named(name, run) != 0)
+                result = -1;
+        }
+        if (benchmark_disks_named("dynamic", run) != 0)
+            result = -1;
+        return result;
+    }
 
-        LOG1 << "Unknown allocation strategy '" << allocstr << "'";
-        cp.print_usage();
-        return -1;
+    if (allocstr.size())
+    {
+        int result = benchmark_disks_named(allocstr, run);
+        if (result == unknown_strategy)
+        {
+            LOG1 << "Unknown allocation strategy '" << allocstr << "'";
+            cp.print_usage();
+            return -1;
+        }
+        return result;
     }
 
-    return benchmark_disks_alloc<foxxll::default_alloc_strategy>(
-        length, offset, batch_size, block_size, optrw
-    );
+    return run(foxxll::default_alloc_strategy());
 }
 
 /**************************************************************************/
@@ -91,6 +91,7 @@ int create_files(int argc, char* argv[])
 {
     std::vector<std::string> disks_arr;
     external_size_type offset = 0, length;
+    bool preallocate = false;
 
     tlx::CmdlineParser cp;
     cp.add_param_bytes(
@@ -101,6 +102,11 @@ int create_files(int argc, char* argv[])
         "filename", disks_arr,
         "Paths to files to write."
     );
+    cp.add_bool(
+        'f', "fallocate", preallocate,
+        "Only allocate the files with fallocate() instead of writing them, "
+        "fast but the files contain zeros."
+    );
 
     if (!cp.process(argc, argv))
         return -1;
@@ -115,6 +121,32 @@ int create_files(int argc, char* argv[])
 
     const size_t ndisks = disks_arr.size();
 
+    if (preallocate)
+    {
+        for (size_t i = 0; i < ndisks; ++i)
+        {
+#if FOXXLL_WINDOWS
+            foxxll::wincall_file disk(
+                disks_arr[i], file::CREAT | file::RDWR, static_cast<int>(i)
+            );
+#else
+            foxxll::syscall_file disk(
+                disks_arr[i], file::CREAT | file::RDWR | file::PREALLOC,
+                static_cast<int>(i)
+            );
+#endif
+            double begin = timestamp();
+            disk.set_size(endpos);
+            double end = timestamp();
+
+            LOG1 << "Allocated " << endpos / MB << " MiB of " << disks_arr[i] <<
+                " in " << std::fixed << std::setprecision(3) << end - begin <<
+                " s";
+        }
+
+        return 0;
+    }
+
 #if FOXXLL_WINDOWS
     size_t buffer_size = 64 * MB;
 #else